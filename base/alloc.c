@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "alloc.h"
+#include "utils.h"
+
+
+// Size of the huge pages requested from the kernel
+#define HUGE_PAGE (2UL << 20)
+
+
+/*
+ * Structure gridhdr
+ * -----------------
+ *  Bookkeeping stored right in front of the row pointers of every grid
+ *
+ *  base: pointer to the block holding the rows (NULL for legacy grids)
+ *  bytes: size of the block
+ *  mode: strategy the grid was allocated with
+ *  nRows: number of rows of the grid
+ */
+typedef struct gridhdr {
+  void* base;
+  size_t bytes;
+  int mode;
+  int nRows;
+} gridhdr_t;
+
+
+/*
+ * Structure allocstats
+ * --------------------
+ *  Allocation statistics of the process
+ *
+ *  grids: number of grids allocated
+ *  requested: bytes of cells requested
+ *  reserved: bytes actually reserved (including padding)
+ *  hugeGrids: number of grids backed by explicit huge pages
+ *  fallbacks: number of grids that fell back to a weaker strategy because
+ *             their block was refused (huge to thp to aligned)
+ *  modes: number of grids obtained with every strategy
+ *  seconds: wall time spent allocating
+ */
+typedef struct allocstats {
+  int grids;
+  size_t requested;
+  size_t reserved;
+  int hugeGrids;
+  int fallbacks;
+  int modes[4];
+  double seconds;
+} allocstats_t;
+
+
+static int allocMode = ALLOC_ALIGNED;
+static allocstats_t allocStats;
+
+
+// Forward declaration of static methods
+static inline size_t roundUp(const size_t x, const size_t to);
+static void* checked(void* p, const size_t bytes);
+
+
+
+/*
+ * Function setAllocMode
+ * ---------------------
+ *  Select the strategy used by the following grid allocations
+ *
+ *  mode: one of the ALLOC_* strategies
+ */
+void setAllocMode(const int mode) {
+  allocMode = mode;
+}
+
+
+
+/*
+ * Function parseAllocMode
+ * -----------------------
+ *  Translate the name of an allocation strategy
+ *
+ *  name: legacy, aligned, huge or thp
+ *
+ *  returns: the corresponding ALLOC_* strategy, or -1 if unknown
+ */
+int parseAllocMode(const char* name) {
+  if (strcmp(name, "legacy") == 0) return ALLOC_LEGACY;
+  if (strcmp(name, "aligned") == 0) return ALLOC_ALIGNED;
+  if (strcmp(name, "huge") == 0) return ALLOC_HUGE;
+  if (strcmp(name, "thp") == 0) return ALLOC_THP;
+  return -1;
+}
+
+
+
+/*
+ * Function gridAlloc
+ * ------------------
+ *  Allocate a grid with the current strategy. Except in legacy mode, all rows
+ *  live in one block and start on a cache line boundary, so rows handled by
+ *  different threads never share a cache line. A refused huge page block
+ *  falls back to transparent huge pages, and those to the aligned block;
+ *  the process exits with an error if the memory cannot be obtained at all
+ *
+ *  nRows: number of rows of the grid
+ *  rowBytes: number of bytes of every row
+ *
+ *  returns: a pointer to the first element of the array of row pointers
+ */
+void** gridAlloc(const int nRows, const size_t rowBytes) {
+  double t = get_wall_seconds();
+  int i;
+  const size_t hdrBytes = sizeof(gridhdr_t) + nRows * sizeof(void*);
+  gridhdr_t* hdr = (gridhdr_t*) checked(malloc(hdrBytes), hdrBytes);
+  void** rows = (void**) (hdr + 1);
+  hdr->mode = allocMode;
+  hdr->nRows = nRows;
+  hdr->base = NULL;
+  hdr->bytes = 0;
+
+  if (allocMode == ALLOC_LEGACY) {
+    for (i = 0; i < nRows; i++) {
+      rows[i] = checked(malloc(rowBytes), rowBytes);
+    }
+    allocStats.reserved += nRows * rowBytes;
+  } else {
+    const size_t stride = roundUp(rowBytes, ALLOC_ALIGN);
+    if (allocMode == ALLOC_HUGE) {
+      hdr->bytes = roundUp(nRows * stride, HUGE_PAGE);
+      hdr->base = mmap(NULL, hdr->bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (hdr->base == MAP_FAILED) {
+        // No huge pages reserved: fall back to transparent ones
+        hdr->base = NULL;
+        hdr->mode = ALLOC_THP;
+        allocStats.fallbacks++;
+      } else {
+        allocStats.hugeGrids++;
+      }
+    }
+    if (hdr->mode == ALLOC_THP) {
+      hdr->bytes = roundUp(nRows * stride, HUGE_PAGE);
+      if (posix_memalign(&hdr->base, HUGE_PAGE, hdr->bytes) == 0) {
+        madvise(hdr->base, hdr->bytes, MADV_HUGEPAGE);
+      } else {
+        // No block aligned to a huge page: fall back to the aligned one
+        hdr->base = NULL;
+        hdr->mode = ALLOC_ALIGNED;
+        allocStats.fallbacks++;
+      }
+    }
+    if (hdr->mode == ALLOC_ALIGNED) {
+      hdr->bytes = roundUp(nRows * stride, ALLOC_ALIGN);
+      hdr->base = checked(aligned_alloc(ALLOC_ALIGN, hdr->bytes), hdr->bytes);
+    }
+    for (i = 0; i < nRows; i++) {
+      rows[i] = (char*) hdr->base + i * stride;
+    }
+    allocStats.reserved += hdr->bytes;
+  }
+
+  allocStats.grids++;
+  allocStats.modes[hdr->mode]++;
+  allocStats.requested += nRows * rowBytes;
+  allocStats.seconds += get_wall_seconds() - t;
+  return rows;
+}
+
+
+
+/*
+ * Function gridFree
+ * -----------------
+ *  Free memory occupied by a grid
+ *
+ *  rows: pointer to the first element of the array of row pointers
+ */
+void gridFree(void** rows) {
+  gridhdr_t* hdr = ((gridhdr_t*) rows) - 1;
+  int i;
+  if (hdr->mode == ALLOC_LEGACY) {
+    for (i = 0; i < hdr->nRows; i++) {
+      free(rows[i]);
+    }
+  } else if (hdr->mode == ALLOC_HUGE) {
+    munmap(hdr->base, hdr->bytes);
+  } else {
+    free(hdr->base);
+  }
+  free(hdr);
+}
+
+
+
+/*
+ * Function allocReport
+ * --------------------
+ *  Print the allocation statistics, naming the strategy the grids actually
+ *  got (with the number of grids of each one if they differ, and the
+ *  requested one if some fell back)
+ *
+ *  f: output stream
+ */
+void allocReport(FILE* f) {
+  static const char* names[] = {"legacy", "aligned", "huge", "thp"};
+  char obtained[64] = "";
+  int mode, used = 0, len = 0;
+  for (mode = 0; mode < 4; mode++) {
+    used += allocStats.modes[mode] > 0;
+  }
+  for (mode = 0; mode < 4; mode++) {
+    if (allocStats.modes[mode] == 0) continue;
+    len += used > 1 ? snprintf(obtained + len, sizeof(obtained) - len,
+                               "%s%s %d", len > 0 ? ", " : "", names[mode],
+                               allocStats.modes[mode])
+                    : snprintf(obtained, sizeof(obtained), "%s", names[mode]);
+  }
+  if (used == 0 || allocStats.fallbacks > 0) {
+    snprintf(obtained + len, sizeof(obtained) - len, "%s(requested %s)",
+             len > 0 ? " " : "", names[allocMode]);
+  }
+  fprintf(f, "Allocator %s: %d grids, %zu bytes requested, %zu reserved "
+          "(%.1f%% overhead), %d on huge pages, %d fallbacks, "
+          "%lf seconds\n", obtained, allocStats.grids,
+          allocStats.requested, allocStats.reserved,
+          allocStats.requested > 0
+              ? 100.0 * (allocStats.reserved - allocStats.requested)
+                  / allocStats.requested
+              : 0.0,
+          allocStats.hugeGrids, allocStats.fallbacks, allocStats.seconds);
+}
+
+
+
+/*
+ * Function roundUp
+ * ----------------
+ *  Round a size up to a multiple of another one
+ *
+ *  x: size to round
+ *  to: granularity
+ *
+ *  returns: the rounded size
+ */
+static inline size_t roundUp(const size_t x, const size_t to) {
+  return (x + to - 1) / to * to;
+}
+
+
+
+/*
+ * Function checked
+ * ----------------
+ *  Exit with an error if an allocation failed
+ *
+ *  p: pointer returned by the allocation
+ *  bytes: size of the allocation
+ *
+ *  returns: p, if not NULL
+ */
+static void* checked(void* p, const size_t bytes) {
+  if (p == NULL) {
+    fprintf(stderr, "Cannot allocate %zu bytes for a grid\n", bytes);
+    exit(EXIT_FAILURE);
+  }
+  return p;
+}
+
@@ -1,11 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include "alloc.h"
 #include "gol.h"
 #include "utils.h"
 
 
 
+// Static function declarations
+static int parseOptions(const int argc, char const *argv[], options_t* opts);
+
+
 int** state;
 int** other;
 int** tmp;  // Temporal pointer
@@ -17,8 +23,16 @@ int main(int argc, char const *argv[]) {
   double t1 = get_wall_seconds();
 
   // Check that arguments are provided
-  if (argc != 7) {
-    printf("Usage: %s n m prob nSteps seed debug\n", argv[0]);
+  options_t opts;
+  if (argc < 7 || parseOptions(argc, argv, &opts) != 0) {
+    printf("Usage: %s n m prob nSteps seed debug [options]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -cycles     stop computing once the board repeats itself\n");
+    printf("  -alloc mode grid allocation: legacy (one malloc per row), aligned\n"
+           "              (default), huge (MAP_HUGETLB) or thp (madvise)\n");
+    printf("  -hash every print the hash of generation 0, of every generation multiple\n"
+           "              of every (0 for none) and of the final one, to compare the\n"
+           "              backends (see results/verify.py); not with -cycles\n");
     return -1;
   }
 
@@ -38,18 +52,18 @@ int main(int argc, char const *argv[]) {
   }
 
   // Initialize arbitrary seed for random numbers (or not!)
-  if (seed < 0) {
-    srand(time(NULL));
-  } else {
-    srand((unsigned int) seed);
-  }
+  const unsigned long long key = seed < 0 ? (unsigned long long) time(NULL)
+                                          : (unsigned long long) seed;
 
   // Initialize data structures
+  if (opts.alloc >= 0) {
+    setAllocMode(opts.alloc);
+  }
   state = allocateMatrix(n, m);
   other = allocateMatrix(n, m);
 
   // Create initial state
-  createInitialState(state, n, m, prob);
+  createInitialState(state, n, m, prob, key);
 
   // Print initial state
   if (debug) {
@@ -58,7 +72,15 @@ int main(int argc, char const *argv[]) {
   }
 
   // Evolve the system
-  evolve(n, m, nSteps);
+  history_t hist;
+  if (opts.cycles) {
+    historyInit(&hist, n, m);
+  }
+  evolve(n, m, nSteps, opts.cycles ? &hist : NULL, opts.hash);
+  if (opts.cycles) {
+    historyReport(&hist);
+    historyFree(&hist);
+  }
 
   // Print final state
   if (debug) {
@@ -70,6 +92,11 @@ int main(int argc, char const *argv[]) {
   freeMatrix(state, n, m);
   freeMatrix(other, n, m);
 
+  // Report how the grids were allocated
+  if (debug || opts.alloc >= 0) {
+    allocReport(stderr);
+  }
+
   // Print time it took to run the code
   t1 = get_wall_seconds() - t1;
   if (debug) {
@@ -83,6 +110,48 @@ int main(int argc, char const *argv[]) {
 
 
 
+/*
+ * Function parseOptions
+ * ---------------------
+ *  Parse the optional flags given after the positional arguments
+ *
+ *  argc: number of command line arguments
+ *  argv: command line arguments
+ *  opts: pointer to the structure to fill
+ *
+ *  returns: 0 on success, -1 if an option is not recognized
+ */
+static int parseOptions(const int argc, char const *argv[], options_t* opts) {
+  int a;
+  opts->cycles = 0;
+  opts->alloc = -1;
+  opts->hash = -1;
+  for (a = 7; a < argc; a++) {
+    if (strcmp(argv[a], "-cycles") == 0) {
+      opts->cycles = 1;
+    } else if (strcmp(argv[a], "-alloc") == 0 && a+1 < argc) {
+      opts->alloc = parseAllocMode(argv[++a]);
+      if (opts->alloc < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-hash") == 0 && a+1 < argc) {
+      opts->hash = atoi(argv[++a]);
+      if (opts->hash < 0) {
+        return -1;
+      }
+    } else {
+      return -1;
+    }
+  }
+  // Checkpoints are generations actually computed
+  if (opts->hash >= 0 && opts->cycles) {
+    return -1;
+  }
+  return 0;
+}
+
+
+
 /*
  * Function evolve
  * ---------------
@@ -90,13 +159,33 @@ int main(int argc, char const *argv[]) {
  *
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
- *  nSteps: number of iterations (assumed to be even)
+ *  nSteps: number of iterations
+ *  hist: pointer to the cycle detector, or NULL to evolve blindly. When the
+ *        board enters a cycle, only the generations needed to reach the
+ *        state at nSteps modulo the period are computed
+ *  every: print the hash of generation 0, of every generation multiple of
+ *         every (if positive) and of the final one (see hashReport), or -1
+ *         to print none
  */
-void evolve(int n, int m, int nSteps) {
+void evolve(int n, int m, int nSteps, history_t* hist, int every) {
   int k, i, j;
   int neighbors;
   int topleft, top, topright, left, right, botleft, bot, botright;
-  for (k = 0; k < nSteps; k++) {
+  int last = nSteps;
+  int period;
+  int report;
+  unsigned long long hash;
+
+  if (hist != NULL) {
+    historyStep(hist, hashMatrix(state, n, m), 0, state, n, m);
+  }
+  if (every >= 0) {
+    hashReport(0, hashMatrix(state, n, m));
+  }
+
+  for (k = 0; k < last; k++) {
+    hash = 0;
+    report = every >= 0 && (k+1 == nSteps || (every > 0 && (k+1) % every == 0));
 
     // Generate next state
     for (i = 0; i < n; i++) {
@@ -150,6 +239,10 @@ void evolve(int n, int m, int nSteps) {
         neighbors = topleft + top + topright + left + right + botleft + bot + botright;
         decide(state[i][j], other, i, j, neighbors);
       }
+      // Hash the row while it is still in cache
+      if (hist != NULL || report) {
+        hash += hashRow(other[i], m, i);
+      }
     }
 
     // Make state point to other and other point to state
@@ -157,6 +250,18 @@ void evolve(int n, int m, int nSteps) {
     state = other;
     other = tmp;
 
+    if (report) {
+      hashReport(k+1, hash);
+    }
+
+    // Jump ahead once the board repeats itself
+    if (hist != NULL && hist->period == 0) {
+      period = historyStep(hist, hash, k+1, state, n, m);
+      if (period != 0) {
+        last = k+1 + (nSteps - (k+1)) % period;
+      }
+    }
+
   }
 }
 
@@ -1,7 +1,25 @@
 #ifndef GOL_H
 #define GOL_H
 
-void evolve(int n, int m, int nSteps);
+#include "hash.h"
+
+/*
+ * Structure options
+ * -----------------
+ *  Optional flags given after the positional arguments
+ *
+ *  cycles: detect when the board repeats itself and skip to the final state
+ *  alloc: grid allocation strategy (-1 for the default one)
+ *  hash: generations between printed hashes (0 for the first and final ones
+ *        only, -1 if not requested)
+ */
+typedef struct options {
+  int cycles;
+  int alloc;
+  int hash;
+} options_t;
+
+void evolve(int n, int m, int nSteps, history_t* hist, int every);
 void decide(int alive, int** future, int i, int j, int neighbors);
 
 #endif
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "hash.h"
+
+
+// Forward declaration of static methods
+static inline unsigned long long mix(unsigned long long x);
+static inline unsigned long long packWord(const int* cells,
+                                          const int count);
+
+
+
+/*
+ * Function hashRow
+ * ----------------
+ *  Hash one row of the board. Cells are taken eight at a time as the bytes of
+ *  a little-endian word (the same bytes the char boards of the other variants
+ *  hold), and the row index is part of the hash, so the board hash can be
+ *  formed as a plain (order-independent) sum of row hashes
+ *
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  i: index of the row
+ *
+ *  returns: the hash of the row
+ */
+unsigned long long hashRow(const int* row, const int m, const int i) {
+  unsigned long long h = (i + 1) * 0x9E3779B97F4A7C15ULL;
+  unsigned long long x;
+  int j, b;
+  for (j = 0; j < m; j += 8) {
+    x = 0;
+    for (b = 0; b < 8 && j + b < m; b++) {
+      x |= (unsigned long long) (row[j+b] & 0xFF) << (8*b);
+    }
+    h = (h ^ x) * 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 32;
+  }
+  return mix(h ^ (unsigned long long) m);
+}
+
+
+
+/*
+ * Function hashMatrix
+ * -------------------
+ *  Hash a whole board as the sum of its row hashes
+ *
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *
+ *  returns: the hash of the board
+ */
+unsigned long long hashMatrix(int** mat, const int n, const int m) {
+  unsigned long long h = 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    h += hashRow(mat[i], m, i);
+  }
+  return h;
+}
+
+
+
+/*
+ * Function historyInit
+ * --------------------
+ *  Initialize an empty history for an n x m board
+ *
+ *  hist: pointer to the history
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ */
+void historyInit(history_t* restrict hist, const int n, const int m) {
+  hist->count = 0;
+  hist->detected = -1;
+  hist->period = 0;
+  hist->candidate = 0;
+  hist->held = -1;
+  hist->rejected = 0;
+  hist->words = (m + 63) / 64;
+  hist->snapshot = (unsigned long long*) malloc((size_t) n * hist->words
+                                                * sizeof(unsigned long long));
+}
+
+
+
+/*
+ * Function historyFree
+ * --------------------
+ *  Free the memory of the held board
+ *
+ *  hist: pointer to the history
+ */
+void historyFree(history_t* restrict hist) {
+  free(hist->snapshot);
+}
+
+
+
+/*
+ * Function historyCheck
+ * ---------------------
+ *  Look up the hash of a generation among the remembered ones and remember
+ *  it. A match proposes a period (see historyDue) unless one is already
+ *  awaiting confirmation. Once a cycle has been confirmed the history is no
+ *  longer updated
+ *
+ *  hist: pointer to the history
+ *  hash: hash of the generation
+ *  gen: generation number
+ *
+ *  returns: the period of the cycle the board has entered, or 0 if none
+ */
+int historyCheck(history_t* restrict hist, const unsigned long long hash,
+                 const int gen) {
+  int e;
+  if (hist->period != 0) {
+    return hist->period;
+  }
+  const int nRemembered = hist->count < HISTORY ? hist->count : HISTORY;
+  for (e = 0; e < nRemembered && hist->candidate == 0; e++) {
+    if (hist->hashes[e] == hash) {
+      hist->candidate = gen - hist->gens[e];
+      hist->held = gen;
+    }
+  }
+  hist->hashes[hist->count % HISTORY] = hash;
+  hist->gens[hist->count % HISTORY] = gen;
+  hist->count++;
+  return 0;
+}
+
+
+
+/*
+ * Function historyDue
+ * -------------------
+ *  Tell whether the board of a generation must be compared with the held
+ *  one: it is one proposed period after it
+ *
+ *  hist: pointer to the history
+ *  gen: generation number
+ *
+ *  returns: 1 if the board must be compared, 0 otherwise
+ */
+int historyDue(const history_t* restrict hist, const int gen) {
+  return hist->period == 0 && hist->candidate != 0
+         && gen == hist->held + hist->candidate;
+}
+
+
+
+/*
+ * Function historyHold
+ * --------------------
+ *  Hold some rows of the board of the generation that proposed a period
+ *
+ *  hist: pointer to the history
+ *  mat: pointer to the first element of the matrix
+ *  i0: first row to hold (inclusive)
+ *  i1: last row to hold (exclusive)
+ *  m: number of columns of the matrix
+ */
+void historyHold(history_t* restrict hist, int** mat, const int i0,
+                 const int i1, const int m) {
+  int i, w;
+  for (i = i0; i < i1; i++) {
+    unsigned long long* restrict out = hist->snapshot
+                                       + (size_t) i * hist->words;
+    for (w = 0; w < hist->words; w++) {
+      out[w] = packWord(mat[i] + 64*w, m - 64*w < 64 ? m - 64*w : 64);
+    }
+  }
+}
+
+
+
+/*
+ * Function historySame
+ * --------------------
+ *  Compare some rows of the board with the held ones
+ *
+ *  hist: pointer to the history
+ *  mat: pointer to the first element of the matrix
+ *  i0: first row to compare (inclusive)
+ *  i1: last row to compare (exclusive)
+ *  m: number of columns of the matrix
+ *
+ *  returns: 1 if every cell of the rows matches, 0 otherwise
+ */
+int historySame(const history_t* restrict hist, int** mat,
+                const int i0, const int i1, const int m) {
+  int i, w;
+  for (i = i0; i < i1; i++) {
+    const unsigned long long* restrict held = hist->snapshot
+                                              + (size_t) i * hist->words;
+    for (w = 0; w < hist->words; w++) {
+      if (held[w] != packWord(mat[i] + 64*w, m - 64*w < 64 ? m - 64*w : 64)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function historyConfirm
+ * -----------------------
+ *  Accept the proposed period if the board came back, or drop it (a hash
+ *  collision) and keep looking
+ *
+ *  hist: pointer to the history
+ *  gen: generation number of the compared board
+ *  same: whether it matched the held board (see historySame)
+ *
+ *  returns: the period of the cycle the board has entered, or 0 if none
+ */
+int historyConfirm(history_t* restrict hist, const int gen, const int same) {
+  if (same) {
+    hist->detected = gen;
+    hist->period = hist->candidate;
+  } else {
+    hist->candidate = 0;
+    hist->rejected++;
+  }
+  return hist->period;
+}
+
+
+
+/*
+ * Function historyStep
+ * --------------------
+ *  Feed a generation of a whole board to the cycle detector: confirm the
+ *  proposed period on it if due, then look up its hash and hold it if it
+ *  proposes a period
+ *
+ *  hist: pointer to the history
+ *  hash: hash of the generation
+ *  gen: generation number
+ *  mat: pointer to the first element of the matrix holding the generation
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *
+ *  returns: the period of the cycle the board has entered, or 0 if none
+ */
+int historyStep(history_t* restrict hist, const unsigned long long hash,
+                const int gen, int** mat, const int n, const int m) {
+  if (historyDue(hist, gen)) {
+    historyConfirm(hist, gen, historySame(hist, mat, 0, n, m));
+  }
+  const int period = historyCheck(hist, hash, gen);
+  if (period == 0 && hist->held == gen) {
+    historyHold(hist, mat, 0, n, m);
+  }
+  return period;
+}
+
+
+
+/*
+ * Function historyReport
+ * ----------------------
+ *  Print the outcome of the cycle detection to the error stream, so that
+ *  the timing printed to console is not disturbed
+ *
+ *  hist: pointer to the history
+ */
+void historyReport(const history_t* restrict hist) {
+  if (hist->period != 0) {
+    fprintf(stderr, "Cycle of period %d detected at generation %d",
+            hist->period, hist->detected);
+  } else {
+    fprintf(stderr, "No cycle detected");
+  }
+  if (hist->rejected > 0) {
+    fprintf(stderr, " (%d hash collisions rejected)", hist->rejected);
+  }
+  fprintf(stderr, "\n");
+}
+
+
+
+/*
+ * Function hashReport
+ * -------------------
+ *  Print the hash of a generation to the error stream, in the form read by
+ *  results/verify.py to compare the backends
+ *
+ *  gen: generation number
+ *  hash: hash of the board (see hashMatrix)
+ */
+void hashReport(const int gen, const unsigned long long hash) {
+  fprintf(stderr, "Hash: generation %d %016llx\n", gen, hash);
+}
+
+
+
+/*
+ * Function mix
+ * ------------
+ *  Finalize a hash so that every input bit affects every output bit
+ *  (splitmix64 finalizer)
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned long long mix(unsigned long long x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+
+/*
+ * Function packWord
+ * -----------------
+ *  Pack up to 64 cells into the bits of a word
+ *
+ *  cells: pointer to the first cell
+ *  count: number of cells to pack
+ *
+ *  returns: the word, cell b in bit b
+ */
+static inline unsigned long long packWord(const int* cells,
+                                          const int count) {
+  unsigned long long w = 0;
+  int b;
+  for (b = 0; b < count; b++) {
+    w |= (unsigned long long) (cells[b] & 1) << b;
+  }
+  return w;
+}
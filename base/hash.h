@@ -0,0 +1,57 @@
+#ifndef HASH_H
+#define HASH_H
+
+// Number of past generations remembered by the cycle detector
+#define HISTORY 64
+
+/*
+ * Structure history
+ * -----------------
+ *  Ring of the hashes of the most recent generations, used to detect when
+ *  the board repeats itself. A matching hash only proposes a period: the
+ *  board of that generation is held (bit-packed) and the period is accepted
+ *  once the board comes back cell for cell one period later
+ *
+ *  hashes: hashes of the remembered generations
+ *  gens: generation number of every remembered hash
+ *  count: number of hashes inserted so far
+ *  detected: generation at which a repetition was confirmed (-1 if none)
+ *  period: period of the cycle (0 if none)
+ *  candidate: period proposed by a matching hash and awaiting confirmation
+ *             (0 if none)
+ *  held: generation whose board is held for the confirmation
+ *  rejected: number of proposed periods whose boards differed
+ *  words: number of words of every held row
+ *  snapshot: held board, one bit per cell
+ */
+typedef struct history {
+  unsigned long long hashes[HISTORY];
+  int gens[HISTORY];
+  int count;
+  int detected;
+  int period;
+  int candidate;
+  int held;
+  int rejected;
+  int words;
+  unsigned long long* snapshot;
+} history_t;
+
+unsigned long long hashRow(const int* row, const int m, const int i);
+unsigned long long hashMatrix(int** mat, const int n, const int m);
+void historyInit(history_t* restrict hist, const int n, const int m);
+void historyFree(history_t* restrict hist);
+int historyCheck(history_t* restrict hist, const unsigned long long hash,
+                 const int gen);
+int historyDue(const history_t* restrict hist, const int gen);
+void historyHold(history_t* restrict hist, int** mat, const int i0,
+                 const int i1, const int m);
+int historySame(const history_t* restrict hist, int** mat,
+                const int i0, const int i1, const int m);
+int historyConfirm(history_t* restrict hist, const int gen, const int same);
+int historyStep(history_t* restrict hist, const unsigned long long hash,
+                const int gen, int** mat, const int n, const int m);
+void historyReport(const history_t* restrict hist);
+void hashReport(const int gen, const unsigned long long hash);
+
+#endif
@@ -1,14 +1,20 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include "alloc.h"
 #include "utils.h"
 
 
+// Forward declaration of static methods
+static inline unsigned long long splitMix(unsigned long long x);
+
+
 
 /*
  * Function allocateMatrix
  * -----------------------
- *  Allocate memory for a matrix
+ *  Allocate memory for a matrix with the current allocation strategy (see
+ *  alloc.h)
  *
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
@@ -16,12 +22,7 @@
  *  returns: a pointer to the first element of the matrix
  */
 int** allocateMatrix(int n, int m) {
-  int** mat = (int**) malloc(n * sizeof(int*));
-  int i;
-  for (i = 0; i < n; i++) {
-    mat[i] = (int*) malloc(m * sizeof(int));
-  }
-  return mat;
+  return (int**) gridAlloc(n, m * sizeof(int));
 }
 
 
@@ -36,11 +37,7 @@ int** allocateMatrix(int n, int m) {
  *  m: number of columns of the matrix
  */
 void freeMatrix(int** mat, int n, int m) {
-  int i;
-  for (i = 0; i < n; i++) {
-    free(mat[i]);
-  }
-  free(mat);
+  gridFree((void**) mat);
 }
 
 
@@ -54,28 +51,59 @@ void freeMatrix(int** mat, int n, int m) {
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
  *  prob: probability of a cell being alive
+ *  seed: key of the draws (see createInitialRow)
  */
-void createInitialState(int** mat, int n, int m, double prob) {
-  int i, j;
+void createInitialState(int** mat, int n, int m, double prob,
+                        unsigned long long seed) {
+  int i;
   for (i = 0; i < n; i++) {
-    for (j = 0; j < m; j++) {
-      mat[i][j] = cRandom() <= prob ? 1 : 0;
-    }
+    createInitialRow(mat[i], m, prob, seed, i);
   }
 }
 
 
 
 /*
- * Function cRandom
- * ----------------
- *  Generate a uniform random number in range [0, 1]
+ * Function createInitialRow
+ * -------------------------
+ *  Draw one row of the initial state from a counter-based generator: the row
+ *  gets a key from the seed and its index, and cell j is alive when the top
+ *  53 bits of the mix of the key and j fall below prob, so a board depends
+ *  only on the seed (the same in every variant, whatever the order in which
+ *  the rows are drawn)
+ *
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  prob: probability of a cell being alive
+ *  seed: key of the draws
+ *  i: index of the row
+ */
+void createInitialRow(int* row, const int m, const double prob,
+                      const unsigned long long seed, const int i) {
+  const unsigned long long key = splitMix(splitMix(seed) ^ (unsigned) i);
+  const unsigned long long threshold = (unsigned long long) (prob * 0x1p53);
+  int j;
+  for (j = 0; j < m; j++) {
+    row[j] = splitMix(key + (unsigned) j) >> 11 < threshold;
+  }
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator
+ *
+ *  x: value to mix
  *
- *  returns: the generated number
+ *  returns: the mixed value
  */
-double cRandom() {
-  // https://stackoverflow.com/questions/6218399/how-to-generate-a-random-number-between-0-and-1
-  return (double) rand() / (double) RAND_MAX;
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
 }
 
 
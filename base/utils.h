@@ -4,8 +4,10 @@
 void printMatrix(int** mat, int n, int m);
 int** allocateMatrix(int n, int m);
 void freeMatrix(int** mat, int n, int m);
-void createInitialState(int** mat, int n, int m, double prob);
+void createInitialState(int** mat, int n, int m, double prob,
+                        unsigned long long seed);
+void createInitialRow(int* row, const int m, const double prob,
+                      const unsigned long long seed, const int i);
 double get_wall_seconds();
-double cRandom();
 
 #endif
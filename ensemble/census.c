@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "soup.h"
+#include "utils.h"
+
+
+
+int main(int argc, char const *argv[]) {
+
+  // Take initial time
+  double t1 = get_wall_seconds();
+
+  // Check that arguments are provided
+  if (argc != 8) {
+    printf("Usage: %s n m side nSoups seed nThreads debug\n", argv[0]);
+    printf("  run nSoups random side x side soups at the center of an n x m torus until\n"
+           "  they settle, and count the still lifes (xs), oscillators (xp) and\n"
+           "  spaceships (xq) left, by canonical code\n");
+    return -1;
+  }
+
+  // Parse arguments
+  const int n = atoi(argv[1]);
+  const int m = atoi(argv[2]);
+  const int side = atoi(argv[3]);
+  const long long nSoups = atoll(argv[4]);
+  const int seed = atoi(argv[5]);
+  const int nThreads = atoi(argv[6]);
+  const int debug = atoi(argv[7]);
+
+  // Check that arguments are valid
+  if (n < 3 || m < 3 || side <= 0 || side > n || side > m || nSoups <= 0
+      || seed < 0 || nThreads <= 0) {
+    printf("Usage:\n  n and m must be at least 3, side at most n and m\n  nSoups and nThreads must be positive integers\n  seed must be non-negative\n");
+    return -1;
+  }
+
+  // Every thread runs soups into its own census, merged at the end. Soup s
+  // is keyed by (seed, s), so the census does not depend on the threads
+  census_t* tables = (census_t*) malloc(nThreads * sizeof(census_t));
+  long long s;
+  double t2 = get_wall_seconds();
+  #pragma omp parallel num_threads(nThreads)
+  {
+    const int tid = omp_get_thread_num();
+    soup_t sp;
+    censusInit(&tables[tid]);
+    soupInit(&sp, n, m, side, SOUP_MAX_GENS);
+    #pragma omp for schedule(dynamic, 16)
+    for (s = 0; s < nSoups; s++) {
+      soupRun(&sp, ((unsigned long long) seed << 32) + s, &tables[tid]);
+    }
+    soupFree(&sp);
+  }
+  int t;
+  for (t = 1; t < nThreads; t++) {
+    censusMerge(&tables[0], &tables[t]);
+    censusFree(&tables[t]);
+  }
+  t2 = get_wall_seconds() - t2;
+
+  // Print the census
+  censusEntry_t* list = censusSorted(&tables[0]);
+  long long e, objects = 0;
+  for (e = 0; e < tables[0].size; e++) {
+    printf("%lld %s\n", list[e].count, list[e].code);
+    objects += list[e].count;
+  }
+  fprintf(stderr, "Census: %lld soups, %.3e soups per second, %lld objects "
+          "(%lld distinct), %lld unsettled soups, %lld pathological objects, "
+          "%.1f generations per soup\n", tables[0].soups,
+          tables[0].soups / t2, objects, tables[0].size, tables[0].unsettled,
+          tables[0].pathological,
+          (double) tables[0].generations / tables[0].soups);
+  free(list);
+  censusFree(&tables[0]);
+  free(tables);
+
+  // Print time it took to run the code
+  t1 = get_wall_seconds() - t1;
+  if (debug) {
+    printf("Execution took %lf seconds\n", t1);
+  } else {
+    printf("%lf\n", t1);
+  }
+
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include "gol.h"
+#include "utils.h"
+
+
+
+// Static function declarations
+static inline uint64_t decide(const uint64_t a, const uint64_t b,
+                              const uint64_t c, const uint64_t d,
+                              const uint64_t e, const uint64_t f,
+                              const uint64_t g, const uint64_t h,
+                              const uint64_t alive);
+
+
+
+int main(int argc, char const *argv[]) {
+
+  // Take initial time
+  double t1 = get_wall_seconds();
+
+  // Check that arguments are provided
+  if (argc != 7) {
+    printf("Usage: %s n m nSteps jobFile nThreads debug\n", argv[0]);
+    printf("  jobFile holds one \"seed prob\" pair per board (- for stdin)\n");
+    return -1;
+  }
+
+  // Parse arguments
+  const int n = atoi(argv[1]);
+  const int m = atoi(argv[2]);
+  const int nSteps = atoi(argv[3]);
+  const int nThreads = atoi(argv[5]);
+  const int debug = atoi(argv[6]);
+  int nJobs;
+  job_t* jobs = readJobs(argv[4], &nJobs);
+
+  // Check that arguments are valid
+  if (n <= 0 || m <= 0 || nSteps <= 0 || nThreads <= 0 || jobs == NULL) {
+    printf("Usage:\n  n, m, nSteps and nThreads must be positive integers\n  jobFile must be readable\n");
+    return -1;
+  }
+  int b;
+  for (b = 0; b < nJobs; b++) {
+    if (jobs[b].seed < 0 || jobs[b].prob < 0 || jobs[b].prob > 1) {
+      printf("Job %d: seed must be non-negative and prob in range [0, 1]\n", b);
+      return -1;
+    }
+  }
+
+  // Initialize data structures
+  const int nBlocks = (nJobs + LANES - 1) / LANES;
+  block_t* blocks = (block_t*) malloc(nBlocks * sizeof(block_t));
+  for (b = 0; b < nBlocks; b++) {
+    blocks[b].cur = allocateBlock(n, m);
+    blocks[b].next = allocateBlock(n, m);
+    blocks[b].nBoards = nJobs - b*LANES < LANES ? nJobs - b*LANES : LANES;
+  }
+
+  // Create initial states (every board depends only on its seed)
+  #pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+  for (b = 0; b < nBlocks; b++) {
+    int lane;
+    for (lane = 0; lane < blocks[b].nBoards; lane++) {
+      const job_t* job = &jobs[b*LANES + lane];
+      createInitialState(blocks[b].cur, n, m, lane, job->prob,
+                         (unsigned long long) job->seed);
+    }
+  }
+
+  // Evolve every block independently
+  double t2 = get_wall_seconds();
+  #pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+  for (b = 0; b < nBlocks; b++) {
+    evolve(&blocks[b], n, m, nSteps);
+  }
+  t2 = get_wall_seconds() - t2;
+
+  // Print per-board results
+  for (b = 0; b < nJobs; b++) {
+    printf("%d %lf %lld\n", jobs[b].seed, jobs[b].prob,
+           population(blocks[b/LANES].cur, n, m, b%LANES));
+    if (debug) {
+      printBoard(blocks[b/LANES].cur, n, m, b%LANES);
+    }
+  }
+  fprintf(stderr, "%d boards, %.3e board-generations per second\n", nJobs,
+          (double) nJobs * nSteps / t2);
+
+  // Free data structures
+  for (b = 0; b < nBlocks; b++) {
+    free(blocks[b].cur);
+    free(blocks[b].next);
+  }
+  free(blocks);
+  free(jobs);
+
+  // Print time it took to run the code
+  t1 = get_wall_seconds() - t1;
+  if (debug) {
+    printf("Execution took %lf seconds\n", t1);
+  } else {
+    printf("%lf\n", t1);
+  }
+
+  return 0;
+}
+
+
+
+/*
+ * Function evolve
+ * ---------------
+ *  Evolve the LANES boards of a block for a given number of iterations. Each
+ *  64-bit word holds 64 cells of a row, and its neighbors are obtained by
+ *  shifting the word and its left/right words one bit, wrapping around the
+ *  torus at the first and last column
+ *
+ *  blk: pointer to the block
+ *  n: number of rows of every board
+ *  m: number of columns of every board
+ *  nSteps: number of iterations
+ */
+void evolve(block_t* restrict blk, const int n, const int m,
+            const int nSteps) {
+  const int nWords = (m + 63) / 64;
+  const int last = (m - 1) % 64;  // Bit of the last column in the last word
+  const uint64_t lastMask = last == 63 ? ~0ULL : (1ULL << (last + 1)) - 1;
+  const size_t stride = (size_t) nWords * LANES;  // Words per row
+  int k, i, w, b;
+
+  for (k = 0; k < nSteps; k++) {
+    const uint64_t* restrict cur = blk->cur;
+    uint64_t* restrict next = blk->next;
+    for (i = 0; i < n; i++) {
+      const uint64_t* restrict up = cur + (i == 0 ? n-1 : i-1) * stride;
+      const uint64_t* restrict mid = cur + i * stride;
+      const uint64_t* restrict down = cur + (i == n-1 ? 0 : i+1) * stride;
+      uint64_t* restrict out = next + i * stride;
+      for (w = 0; w < nWords; w++) {
+        // Words (and bits) that provide the carry of the west/east shifts
+        const int wSrc = w == 0 ? nWords-1 : w-1;
+        const int wBit = w == 0 ? last : 63;
+        const int eSrc = w == nWords-1 ? 0 : w+1;
+        const int eBit = w == nWords-1 ? last : 63;
+        const uint64_t mask = w == nWords-1 ? lastMask : ~0ULL;
+        // Same bit operations for every lane: vectorized across boards
+        for (b = 0; b < LANES; b++) {
+          const uint64_t u = up[w*LANES + b];
+          const uint64_t c = mid[w*LANES + b];
+          const uint64_t d = down[w*LANES + b];
+          const uint64_t uw = (u << 1) | ((up[wSrc*LANES + b] >> wBit) & 1);
+          const uint64_t ue = (u >> 1) | ((up[eSrc*LANES + b] & 1) << eBit);
+          const uint64_t cw = (c << 1) | ((mid[wSrc*LANES + b] >> wBit) & 1);
+          const uint64_t ce = (c >> 1) | ((mid[eSrc*LANES + b] & 1) << eBit);
+          const uint64_t dw = (d << 1) | ((down[wSrc*LANES + b] >> wBit) & 1);
+          const uint64_t de = (d >> 1) | ((down[eSrc*LANES + b] & 1) << eBit);
+          out[w*LANES + b] = decide(uw, u, ue, cw, ce, dw, d, de, c) & mask;
+        }
+      }
+    }
+
+    // Make cur point to next and next point to cur
+    uint64_t* restrict tmp = blk->cur;
+    blk->cur = blk->next;
+    blk->next = tmp;
+  }
+}
+
+
+/*
+ * Function decide
+ * ---------------
+ *  Decide wether 64 cells live or die, using a bit-sliced adder over the
+ *  eight neighbor words
+ *
+ *  a, b, c, d, e, f, g, h: neighbor words
+ *  alive: current state of the cells
+ *
+ *  returns: the future state of the cells
+ */
+static inline uint64_t decide(const uint64_t a, const uint64_t b,
+                              const uint64_t c, const uint64_t d,
+                              const uint64_t e, const uint64_t f,
+                              const uint64_t g, const uint64_t h,
+                              const uint64_t alive) {
+  // Add the neighbors in groups of three: ones bits and twos bits
+  const uint64_t s1 = a ^ b ^ c, c1 = (a & b) | (c & (a ^ b));
+  const uint64_t s2 = f ^ g ^ h, c2 = (f & g) | (h & (f ^ g));
+  const uint64_t s3 = d ^ e, c3 = d & e;
+  const uint64_t ones = s1 ^ s2 ^ s3, c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+  // The count is 2 or 3 when exactly one of the twos bits is set
+  const uint64_t twos = (c1 ^ c2 ^ c3 ^ c4) & ~((c1 & c2) | (c3 & c4));
+  return twos & (ones | alive);
+}
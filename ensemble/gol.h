@@ -0,0 +1,41 @@
+#ifndef GOL_H
+#define GOL_H
+
+#include <stdint.h>
+
+// Number of boards evolved together in one interleaved block
+#define LANES 8
+
+/*
+ * Structure job
+ * -------------
+ *  Describes one board of the ensemble
+ *
+ *  seed: seed for the random initial state
+ *  prob: probability of a cell being alive in the initial state
+ */
+typedef struct job {
+  int seed;
+  double prob;
+} job_t;
+
+/*
+ * Structure block
+ * ---------------
+ *  Group of LANES boards of the same size stored interleaved: word w of row i
+ *  of lane b lives at index (i*nWords + w)*LANES + b, so the innermost loop
+ *  over lanes applies the same bit operations to contiguous words
+ *
+ *  cur: current generation
+ *  next: next generation
+ *  nBoards: number of lanes holding an actual board (the rest stay empty)
+ */
+typedef struct block {
+  uint64_t* restrict cur;
+  uint64_t* restrict next;
+  int nBoards;
+} block_t;
+
+void evolve(block_t* restrict blk, const int n, const int m, const int nSteps);
+
+#endif
@@ -0,0 +1,994 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "soup.h"
+
+
+
+// Static function declarations
+static inline uint64_t soupRandom(uint64_t* restrict state);
+static void step(soup_t* restrict sp, const int first, const int count);
+static inline uint64_t decide(const uint64_t a, const uint64_t b,
+                              const uint64_t c, const uint64_t d,
+                              const uint64_t e, const uint64_t f,
+                              const uint64_t g, const uint64_t h,
+                              const uint64_t alive);
+static int settledPeriod(const int* restrict pops, const int k);
+static int findRoot(int* restrict parent, int c);
+static int unite(int* restrict parent, const int a, const int b);
+static int gather(soup_t* restrict sp);
+static void isolate(soup_t* restrict sp, const int g);
+static void record(soup_t* restrict sp, const int ri, const int a,
+                   const int b, int* restrict lo, int* restrict hi);
+static int interactions(soup_t* restrict sp, const int nGroups);
+static void classify(soup_t* restrict sp, const int g, census_t* restrict cs);
+static int extract(const soup_t* restrict sp, const int g, const int t,
+                   shape_t* restrict sh);
+static void orient(const shape_t* restrict src, const int o,
+                   shape_t* restrict dst);
+static void encode(const shape_t* restrict sh, char* restrict out);
+static int sameShape(const shape_t* restrict a, const shape_t* restrict b);
+static unsigned long long hashCode(const char* code);
+static int compareEntries(const void* a, const void* b);
+
+
+
+/*
+ * Function censusInit
+ * -------------------
+ *  Set up an empty census
+ *
+ *  cs: pointer to the census
+ */
+void censusInit(census_t* restrict cs) {
+  cs->cap = 1024;
+  cs->size = 0;
+  cs->slots = (censusEntry_t*) calloc(cs->cap, sizeof(censusEntry_t));
+  cs->soups = 0;
+  cs->unsettled = 0;
+  cs->pathological = 0;
+  cs->generations = 0;
+}
+
+
+
+/*
+ * Function censusAdd
+ * ------------------
+ *  Count an object, doubling the table when it gets half full
+ *
+ *  cs: pointer to the census
+ *  code: canonical code of the object
+ *  count: number of copies found
+ */
+void censusAdd(census_t* restrict cs, const char* code, const long long count) {
+  long long s;
+
+  if (2 * (cs->size + 1) > cs->cap) {
+    censusEntry_t* old = cs->slots;
+    const long long oldCap = cs->cap;
+    cs->cap *= 2;
+    cs->slots = (censusEntry_t*) calloc(cs->cap, sizeof(censusEntry_t));
+    for (s = 0; s < oldCap; s++) {
+      if (old[s].code != NULL) {
+        long long t = hashCode(old[s].code) & (cs->cap - 1);
+        while (cs->slots[t].code != NULL) t = (t + 1) & (cs->cap - 1);
+        cs->slots[t] = old[s];
+      }
+    }
+    free(old);
+  }
+
+  s = hashCode(code) & (cs->cap - 1);
+  while (cs->slots[s].code != NULL && strcmp(cs->slots[s].code, code) != 0) {
+    s = (s + 1) & (cs->cap - 1);
+  }
+  if (cs->slots[s].code == NULL) {
+    cs->slots[s].code = strdup(code);
+    cs->size++;
+  }
+  cs->slots[s].count += count;
+}
+
+
+
+/*
+ * Function censusMerge
+ * --------------------
+ *  Add the objects and counters of a census to another one
+ *
+ *  into: pointer to the census that receives the counts
+ *  from: pointer to the census whose counts are added
+ */
+void censusMerge(census_t* restrict into, const census_t* restrict from) {
+  long long s;
+  for (s = 0; s < from->cap; s++) {
+    if (from->slots[s].code != NULL) {
+      censusAdd(into, from->slots[s].code, from->slots[s].count);
+    }
+  }
+  into->soups += from->soups;
+  into->unsettled += from->unsettled;
+  into->pathological += from->pathological;
+  into->generations += from->generations;
+}
+
+
+
+/*
+ * Function censusSorted
+ * ---------------------
+ *  List the objects of a census from the most to the least common (ties by
+ *  code), so the listing does not depend on the order they were found in
+ *
+ *  cs: pointer to the census
+ *
+ *  returns: array of cs->size entries sharing their codes with the census
+ *           (free the array, not the codes)
+ */
+censusEntry_t* censusSorted(const census_t* restrict cs) {
+  censusEntry_t* list = (censusEntry_t*) malloc((cs->size + 1)
+                                                * sizeof(censusEntry_t));
+  long long s, k = 0;
+  for (s = 0; s < cs->cap; s++) {
+    if (cs->slots[s].code != NULL) list[k++] = cs->slots[s];
+  }
+  qsort(list, k, sizeof(censusEntry_t), compareEntries);
+  return list;
+}
+
+
+
+/*
+ * Function censusFree
+ * -------------------
+ *  Free the memory of a census
+ *
+ *  cs: pointer to the census
+ */
+void censusFree(census_t* restrict cs) {
+  long long s;
+  for (s = 0; s < cs->cap; s++) {
+    free(cs->slots[s].code);
+  }
+  free(cs->slots);
+}
+
+
+
+/*
+ * Function soupInit
+ * -----------------
+ *  Allocate the scratch space to run soups
+ *
+ *  sp: pointer to the scratch space
+ *  n, m: dimensions of the torus
+ *  side: side of the random square at its center
+ *  maxGens: generations after which an active soup is given up
+ */
+void soupInit(soup_t* restrict sp, const int n, const int m, const int side,
+              const int maxGens) {
+  const size_t cells = (size_t) n * m;
+  sp->n = n;
+  sp->m = m;
+  sp->side = side;
+  sp->maxGens = maxGens;
+  sp->words = (m + 63) / 64;
+  const size_t board = (size_t) n * sp->words;
+  sp->cur = (uint64_t*) malloc(board * sizeof(uint64_t));
+  sp->next = (uint64_t*) malloc(board * sizeof(uint64_t));
+  sp->phases = (uint64_t*) malloc((SOUP_MAX_PERIOD + 1) * board
+                                  * sizeof(uint64_t));
+  sp->pops = (int*) malloc((maxGens + 1) * sizeof(int));
+  sp->cells = (int*) malloc(cells * sizeof(int));
+  sp->parent = (int*) malloc(cells * sizeof(int));
+  sp->group = (int*) malloc(cells * sizeof(int));
+  sp->members = (int*) malloc(cells * sizeof(int));
+  sp->first = (int*) malloc((cells + 1) * sizeof(int));
+  sp->bad = (char*) malloc(cells);
+  sp->track = NULL;
+  sp->nTrack = sp->capTrack = 0;
+  sp->span = NULL;
+  sp->capSpan = 0;
+  sp->label = (int*) malloc(cells * sizeof(int));
+  sp->stamp = (int*) malloc(cells * sizeof(int));
+}
+
+
+
+/*
+ * Function soupRun
+ * ----------------
+ *  Run one soup until its population repeats itself with a period of at most
+ *  SOUP_MAX_PERIOD for SOUP_SPAN generations, then split the live cells into
+ *  objects and count each of them under its canonical code. Candidates start
+ *  as the 8-connected groups of live cells; every candidate is evolved alone
+ *  for SOUP_MAX_PERIOD generations, and candidates that touch in any phase,
+ *  or that surround a cell where the soup differs from the candidates
+ *  evolved alone (they interact, being less than 2 cells apart), are merged
+ *  and evolved again until they all evolve on their own. Objects are named
+ *  from their own phases:
+ *   - xs<population>_ for still lifes, xp<period>_ for oscillators and
+ *     xq<period>_ for spaceships
+ *   - followed by the Extended Wechsler Format of the object, the shortest
+ *     (then alphabetically first) over its phases and the 8 rotations and
+ *     reflections, so a block is xs4_33, a blinker xp2_7 and a glider
+ *     xq4_153
+ *
+ *  sp: pointer to the scratch space
+ *  seed: key of the random square (the soup only depends on it)
+ *  cs: pointer to the census that counts the objects
+ */
+void soupRun(soup_t* restrict sp, const unsigned long long seed,
+             census_t* restrict cs) {
+  const int n = sp->n, m = sp->m, words = sp->words;
+  const size_t board = (size_t) n * words;
+  const int i0 = (n - sp->side) / 2, j0 = (m - sp->side) / 2;
+  uint64_t state = seed, draw = 0;
+  int i, j, k, t, w;
+
+  cs->soups++;
+
+  // Random square at the center, 50% density
+  memset(sp->cur, 0, board * sizeof(uint64_t));
+  for (i = 0; i < sp->side; i++) {
+    for (j = 0; j < sp->side; j++) {
+      const int b = i * sp->side + j;
+      if (b % 64 == 0) draw = soupRandom(&state);
+      if ((draw >> (b % 64)) & 1) {
+        sp->cur[(i0+i) * words + (j0+j) / 64] |= 1ULL << ((j0+j) % 64);
+      }
+    }
+  }
+
+  // Evolve until the population settles
+  for (k = 0; ; k++) {
+    int pop = 0;
+    for (w = 0; w < board; w++) {
+      pop += __builtin_popcountll(sp->cur[w]);
+    }
+    sp->pops[k] = pop;
+    if (k % SOUP_CHECK == 0 && k >= SOUP_SPAN + SOUP_MAX_PERIOD) {
+      if (settledPeriod(sp->pops, k) > 0) break;
+    }
+    if (k == sp->maxGens) {
+      cs->unsettled++;
+      cs->generations += k;
+      return;
+    }
+    step(sp, 0, n);
+  }
+
+  // Keep the next SOUP_MAX_PERIOD phases: a population with a short period
+  // can hide objects with longer ones (a blinker and a glider keep theirs
+  // constant), and the candidates evolved alone are checked against them
+  for (t = 0; t <= SOUP_MAX_PERIOD; t++) {
+    if (t > 0) step(sp, 0, n);
+    memcpy(sp->phases + t * board, sp->cur, board * sizeof(uint64_t));
+  }
+  cs->generations += k + SOUP_MAX_PERIOD;
+
+  // Candidates: 8-connected cells of the first phase
+  memset(sp->stamp, 0, (size_t) n * m * sizeof(int));
+  sp->paint = 1;
+  sp->nCells = 0;
+  for (i = 0; i < n; i++) {
+    for (w = 0; w < words; w++) {
+      uint64_t bits = sp->phases[i * words + w];
+      while (bits != 0) {
+        j = 64*w + __builtin_ctzll(bits);
+        bits &= bits - 1;
+        const int c = sp->nCells++;
+        sp->cells[c] = i*m + j;
+        sp->parent[c] = c;
+        int di, dj;
+        for (di = -1; di <= 1; di++) {
+          for (dj = -1; dj <= 1; dj++) {
+            const int nb = (i + di + n) % n * m + (j + dj + m) % m;
+            if (sp->stamp[nb] == sp->paint) {
+              unite(sp->parent, c, sp->label[nb]);
+            }
+          }
+        }
+        sp->stamp[i*m + j] = sp->paint;
+        sp->label[i*m + j] = c;
+      }
+    }
+  }
+
+  // Evolve every candidate alone and merge those that do not evolve on
+  // their own, until none interact
+  int g, nGroups;
+  do {
+    nGroups = gather(sp);
+    sp->nTrack = 0;
+    for (g = 0; g < nGroups; g++) {
+      isolate(sp, g);
+    }
+  } while (interactions(sp, nGroups) > 0);
+
+  for (g = 0; g < nGroups; g++) {
+    classify(sp, g, cs);
+  }
+}
+
+
+
+/*
+ * Function soupFree
+ * -----------------
+ *  Free the scratch space to run soups
+ *
+ *  sp: pointer to the scratch space
+ */
+void soupFree(soup_t* restrict sp) {
+  free(sp->cur);
+  free(sp->next);
+  free(sp->phases);
+  free(sp->pops);
+  free(sp->cells);
+  free(sp->parent);
+  free(sp->group);
+  free(sp->members);
+  free(sp->first);
+  free(sp->bad);
+  free(sp->track);
+  free(sp->span);
+  free(sp->label);
+  free(sp->stamp);
+}
+
+
+
+/*
+ * Function soupRandom
+ * -------------------
+ *  Next draw of a SplitMix64 generator
+ *
+ *  state: pointer to the state of the generator
+ *
+ *  returns: 64 random bits
+ */
+static inline uint64_t soupRandom(uint64_t* restrict state) {
+  uint64_t x = (*state += 0x9E3779B97F4A7C15ULL);
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+
+/*
+ * Function step
+ * -------------
+ *  Evolve the board of a soup one generation, as the lanes of an ensemble
+ *  block (see evolve in gol.c). Only some rows are computed: the others of
+ *  the new board keep what the buffer held
+ *
+ *  sp: pointer to the scratch space
+ *  first: first row to compute
+ *  count: number of rows to compute, from first on and wrapping around
+ */
+static void step(soup_t* restrict sp, const int first, const int count) {
+  const int n = sp->n, m = sp->m, nWords = sp->words;
+  const int last = (m - 1) % 64;  // Bit of the last column in the last word
+  const uint64_t lastMask = last == 63 ? ~0ULL : (1ULL << (last + 1)) - 1;
+  const uint64_t* restrict cur = sp->cur;
+  uint64_t* restrict next = sp->next;
+  int r, w;
+
+  for (r = 0; r < count; r++) {
+    const int i = (first + r) % n;
+    const uint64_t* restrict up = cur + (i == 0 ? n-1 : i-1) * nWords;
+    const uint64_t* restrict mid = cur + i * nWords;
+    const uint64_t* restrict down = cur + (i == n-1 ? 0 : i+1) * nWords;
+    uint64_t* restrict out = next + i * nWords;
+    for (w = 0; w < nWords; w++) {
+      // Words (and bits) that provide the carry of the west/east shifts
+      const int wSrc = w == 0 ? nWords-1 : w-1;
+      const int wBit = w == 0 ? last : 63;
+      const int eSrc = w == nWords-1 ? 0 : w+1;
+      const int eBit = w == nWords-1 ? last : 63;
+      const uint64_t mask = w == nWords-1 ? lastMask : ~0ULL;
+      const uint64_t u = up[w], c = mid[w], d = down[w];
+      const uint64_t uw = (u << 1) | ((up[wSrc] >> wBit) & 1);
+      const uint64_t ue = (u >> 1) | ((up[eSrc] & 1) << eBit);
+      const uint64_t cw = (c << 1) | ((mid[wSrc] >> wBit) & 1);
+      const uint64_t ce = (c >> 1) | ((mid[eSrc] & 1) << eBit);
+      const uint64_t dw = (d << 1) | ((down[wSrc] >> wBit) & 1);
+      const uint64_t de = (d >> 1) | ((down[eSrc] & 1) << eBit);
+      out[w] = decide(uw, u, ue, cw, ce, dw, d, de, c) & mask;
+    }
+  }
+
+  // Make cur point to next and next point to cur
+  uint64_t* restrict tmp = sp->cur;
+  sp->cur = sp->next;
+  sp->next = tmp;
+}
+
+
+
+/*
+ * Function decide
+ * ---------------
+ *  Decide wether 64 cells live or die, using a bit-sliced adder over the
+ *  eight neighbor words (as in gol.c)
+ *
+ *  a, b, c, d, e, f, g, h: neighbor words
+ *  alive: current state of the cells
+ *
+ *  returns: the future state of the cells
+ */
+static inline uint64_t decide(const uint64_t a, const uint64_t b,
+                              const uint64_t c, const uint64_t d,
+                              const uint64_t e, const uint64_t f,
+                              const uint64_t g, const uint64_t h,
+                              const uint64_t alive) {
+  const uint64_t s1 = a ^ b ^ c, c1 = (a & b) | (c & (a ^ b));
+  const uint64_t s2 = f ^ g ^ h, c2 = (f & g) | (h & (f ^ g));
+  const uint64_t s3 = d ^ e, c3 = d & e;
+  const uint64_t ones = s1 ^ s2 ^ s3, c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+  const uint64_t twos = (c1 ^ c2 ^ c3 ^ c4) & ~((c1 & c2) | (c3 & c4));
+  return twos & (ones | alive);
+}
+
+
+
+/*
+ * Function settledPeriod
+ * ----------------------
+ *  Find whether the population of the last SOUP_SPAN generations repeats
+ *  itself
+ *
+ *  pops: population of every generation
+ *  k: last generation (at least SOUP_SPAN + SOUP_MAX_PERIOD)
+ *
+ *  returns: the shortest period, or 0 if there is none up to SOUP_MAX_PERIOD
+ */
+static int settledPeriod(const int* restrict pops, const int k) {
+  int p, g;
+  for (p = 1; p <= SOUP_MAX_PERIOD; p++) {
+    for (g = k; g > k - SOUP_SPAN && pops[g] == pops[g-p]; g--);
+    if (g == k - SOUP_SPAN) return p;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function findRoot
+ * -----------------
+ *  Find the root of a cell in a union-find forest, halving the path on the
+ *  way
+ *
+ *  parent: parent of every cell
+ *  c: cell
+ *
+ *  returns: the root of the tree of the cell
+ */
+static int findRoot(int* restrict parent, int c) {
+  while (parent[c] != c) {
+    parent[c] = parent[parent[c]];
+    c = parent[c];
+  }
+  return c;
+}
+
+
+
+/*
+ * Function unite
+ * --------------
+ *  Join the trees of two cells in a union-find forest
+ *
+ *  parent: parent of every cell
+ *  a, b: cells
+ *
+ *  returns: 1 if they were in different trees, 0 otherwise
+ */
+static int unite(int* restrict parent, const int a, const int b) {
+  const int ra = findRoot(parent, a), rb = findRoot(parent, b);
+  if (ra == rb) return 0;
+  if (ra < rb) {
+    parent[rb] = ra;
+  } else {
+    parent[ra] = rb;
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function gather
+ * ---------------
+ *  Sort the cells of the first phase by candidate, numbering the candidates
+ *  in the order of their first cell on the board
+ *
+ *  sp: pointer to the scratch space
+ *
+ *  returns: the number of candidates
+ */
+static int gather(soup_t* restrict sp) {
+  int c, g, nGroups = 0;
+  for (c = 0; c < sp->nCells; c++) {
+    sp->group[c] = -1;
+  }
+  for (c = 0; c < sp->nCells; c++) {
+    const int r = findRoot(sp->parent, c);
+    if (sp->group[r] < 0) {
+      sp->group[r] = nGroups;
+      sp->first[nGroups + 1] = 0;
+      nGroups++;
+    }
+    sp->first[sp->group[r] + 1]++;
+  }
+  sp->first[0] = 0;
+  for (g = 0; g < nGroups; g++) {
+    sp->first[g + 1] += sp->first[g];
+  }
+  for (c = 0; c < sp->nCells; c++) {
+    const int g = sp->group[findRoot(sp->parent, c)];
+    sp->members[sp->first[g]++] = c;
+  }
+  for (g = nGroups; g > 0; g--) {
+    sp->first[g] = sp->first[g - 1];
+  }
+  sp->first[0] = 0;
+
+  const long long spans = (long long) nGroups * (SOUP_MAX_PERIOD + 2);
+  if (spans > sp->capSpan) {
+    sp->capSpan = 2 * spans;
+    sp->span = (long long*) realloc(sp->span,
+                                    sp->capSpan * sizeof(long long));
+  }
+  return nGroups;
+}
+
+
+
+/*
+ * Function isolate
+ * ----------------
+ *  Evolve a candidate alone on the torus for SOUP_MAX_PERIOD generations and
+ *  append its cells in every phase to the track. Only the rows next to its
+ *  live cells are computed, plus those live two phases earlier (the stale
+ *  contents of the buffer the new phase goes to)
+ *
+ *  sp: pointer to the scratch space
+ *  g: candidate
+ */
+static void isolate(soup_t* restrict sp, const int g) {
+  const int n = sp->n;
+  const size_t board = (size_t) n * sp->words;
+  long long* restrict span = sp->span + (size_t) g * (SOUP_MAX_PERIOD + 2);
+  const int ri = sp->cells[sp->members[sp->first[g]]] / sp->m;
+  // Live rows of the last two phases, as offsets from row ri (empty when
+  // lo > hi)
+  int lo = n, hi = -n, prevLo = 1, prevHi = 0;
+  int c, t;
+
+  memset(sp->cur, 0, board * sizeof(uint64_t));
+  memset(sp->next, 0, board * sizeof(uint64_t));
+  for (c = sp->first[g]; c < sp->first[g+1]; c++) {
+    const int cell = sp->cells[sp->members[c]];
+    const int i = cell / sp->m, j = cell % sp->m;
+    int di = (i - ri + n) % n;
+    if (di > n / 2) di -= n;
+    if (di < lo) lo = di;
+    if (di > hi) hi = di;
+    sp->cur[i * sp->words + j / 64] |= 1ULL << (j % 64);
+  }
+  span[0] = sp->nTrack;
+  record(sp, ri, lo, hi, &lo, &hi);
+  for (t = 1; t <= SOUP_MAX_PERIOD; t++) {
+    int a = lo - 1, b = hi + 1;
+    if (lo > hi) {
+      a = prevLo;
+      b = prevHi;
+    } else if (prevLo <= prevHi) {
+      if (prevLo < a) a = prevLo;
+      if (prevHi > b) b = prevHi;
+    }
+    if (b - a + 1 > n) b = a + n - 1;
+    prevLo = lo;
+    prevHi = hi;
+    if (a <= b) step(sp, (ri + a % n + n) % n, b - a + 1);
+    span[t] = sp->nTrack;
+    record(sp, ri, a, b, &lo, &hi);
+  }
+  span[SOUP_MAX_PERIOD + 1] = sp->nTrack;
+}
+
+
+
+/*
+ * Function record
+ * ---------------
+ *  Append the live cells of some rows of the current board to the track
+ *
+ *  sp: pointer to the scratch space
+ *  ri: reference row
+ *  a, b: rows to scan, as offsets from ri (wrapping around the torus)
+ *  lo, hi: where to store the first and last live rows, as offsets from ri
+ *          (lo > hi if none)
+ */
+static void record(soup_t* restrict sp, const int ri, const int a,
+                   const int b, int* restrict lo, int* restrict hi) {
+  const int words = sp->words;
+  int r, w;
+  *lo = 1;
+  *hi = 0;
+  for (r = a; r <= b; r++) {
+    const int i = ((ri + r) % sp->n + sp->n) % sp->n;
+    const uint64_t* restrict row = sp->cur + (size_t) i * words;
+    if (sp->nTrack + 64 * words > sp->capTrack) {
+      sp->capTrack = 2 * (sp->nTrack + 64 * words);
+      sp->track = (int*) realloc(sp->track, sp->capTrack * sizeof(int));
+    }
+    for (w = 0; w < words; w++) {
+      uint64_t bits = row[w];
+      if (bits != 0) {
+        if (*lo > *hi) *lo = r;
+        *hi = r;
+      }
+      while (bits != 0) {
+        sp->track[sp->nTrack++] = i * sp->m + 64*w + __builtin_ctzll(bits);
+        bits &= bits - 1;
+      }
+    }
+  }
+}
+
+
+
+/*
+ * Function interactions
+ * ---------------------
+ *  Merge the candidates that do not evolve on their own. In every phase the
+ *  cells of the candidates evolved alone are painted with their candidate,
+ *  and two candidates with adjacent cells are merged. Where the soup differs
+ *  from the union of the candidates evolved alone, the candidates around the
+ *  cell in the previous phase (those that took part in its update) are
+ *  merged too; a lone candidate there is marked bad
+ *
+ *  sp: pointer to the scratch space
+ *  nGroups: number of candidates
+ *
+ *  returns: the number of merges
+ */
+static int interactions(soup_t* restrict sp, const int nGroups) {
+  const int n = sp->n, m = sp->m, words = sp->words;
+  const size_t board = (size_t) n * words;
+  int merges = 0, g, t, di, dj;
+  long long c;
+  size_t w;
+
+  memset(sp->bad, 0, nGroups);
+  for (t = 0; t <= SOUP_MAX_PERIOD; t++) {
+    // Union of the candidates evolved alone
+    memset(sp->next, 0, board * sizeof(uint64_t));
+    for (g = 0; g < nGroups; g++) {
+      const long long* restrict span = sp->span
+                                       + (size_t) g * (SOUP_MAX_PERIOD + 2);
+      for (c = span[t]; c < span[t+1]; c++) {
+        const int j = sp->track[c] % m;
+        sp->next[sp->track[c] / m * words + j / 64] |= 1ULL << (j % 64);
+      }
+    }
+
+    // Cells where the soup differs, against the paint of the previous phase
+    const uint64_t* restrict soup = sp->phases + t * board;
+    for (w = 0; w < board; w++) {
+      uint64_t diff = sp->next[w] ^ soup[w];
+      while (diff != 0) {
+        const int i = (int) (w / words);
+        const int j = (int) (w % words) * 64 + __builtin_ctzll(diff);
+        int near = -1;
+        diff &= diff - 1;
+        for (di = -1; di <= 1; di++) {
+          for (dj = -1; dj <= 1; dj++) {
+            const int nb = (i + di + n) % n * m + (j + dj + m) % m;
+            if (sp->stamp[nb] != sp->paint) continue;
+            if (near < 0) {
+              near = sp->label[nb];
+            } else if (sp->label[nb] != near) {
+              merges += unite(sp->parent, sp->members[sp->first[near]],
+                              sp->members[sp->first[sp->label[nb]]]);
+            }
+          }
+        }
+        if (near >= 0) sp->bad[near] = 1;
+      }
+    }
+
+    // Paint the phase, merging the candidates that touch
+    sp->paint++;
+    for (g = 0; g < nGroups; g++) {
+      const long long* restrict span = sp->span
+                                       + (size_t) g * (SOUP_MAX_PERIOD + 2);
+      for (c = span[t]; c < span[t+1]; c++) {
+        const int i = sp->track[c] / m, j = sp->track[c] % m;
+        for (di = -1; di <= 1; di++) {
+          for (dj = -1; dj <= 1; dj++) {
+            const int nb = (i + di + n) % n * m + (j + dj + m) % m;
+            if (sp->stamp[nb] == sp->paint && sp->label[nb] != g) {
+              merges += unite(sp->parent, sp->members[sp->first[g]],
+                              sp->members[sp->first[sp->label[nb]]]);
+            }
+          }
+        }
+        sp->stamp[sp->track[c]] = sp->paint;
+        sp->label[sp->track[c]] = g;
+      }
+    }
+  }
+  return merges;
+}
+
+
+
+/*
+ * Function classify
+ * -----------------
+ *  Count one object of a settled soup, evolved alone. Its period is the
+ *  first phase with the same shape as phase 0; it is a spaceship if it moved
+ *  meanwhile
+ *
+ *  sp: pointer to the scratch space
+ *  g: candidate holding the object
+ *  cs: pointer to the census that counts the object
+ */
+static void classify(soup_t* restrict sp, const int g, census_t* restrict cs) {
+  int q, t, o;
+
+  // Shortest period of the object
+  shape_t first, later;
+  if (sp->bad[g] || extract(sp, g, 0, &first) <= 0) {
+    cs->pathological++;
+    return;
+  }
+  for (q = 1; q <= SOUP_MAX_PERIOD; q++) {
+    if (extract(sp, g, q, &later) < 0) {
+      q = SOUP_MAX_PERIOD + 1;
+      break;
+    }
+    if (sameShape(&first, &later)) break;
+  }
+  if (q > SOUP_MAX_PERIOD) {
+    cs->pathological++;
+    return;
+  }
+  const int moves = later.row != first.row || later.col != first.col;
+
+  // Shortest code over the phases and orientations
+  char best[SOUP_CODE], code[SOUP_CODE];
+  shape_t phase, turned;
+  best[0] = '\0';
+  for (t = 0; t < q; t++) {
+    extract(sp, g, t, &phase);
+    for (o = 0; o < 8; o++) {
+      orient(&phase, o, &turned);
+      encode(&turned, code);
+      if (best[0] == '\0' || strlen(code) < strlen(best)
+          || (strlen(code) == strlen(best) && strcmp(code, best) < 0)) {
+        strcpy(best, code);
+      }
+    }
+  }
+
+  char name[SOUP_CODE + 16];
+  if (moves) {
+    snprintf(name, sizeof(name), "xq%d_%s", q, best);
+  } else if (q > 1) {
+    snprintf(name, sizeof(name), "xp%d_%s", q, best);
+  } else {
+    snprintf(name, sizeof(name), "xs%d_%s", first.pop, best);
+  }
+  censusAdd(cs, name, 1);
+}
+
+
+
+/*
+ * Function extract
+ * ----------------
+ *  Take the cells of one phase of a candidate evolved alone, cropped to their
+ *  bounding box. Cells are unwrapped to the nearest copy of the first cell of
+ *  the candidate, so the box must span less than half of the torus
+ *
+ *  sp: pointer to the scratch space
+ *  g: candidate
+ *  t: phase
+ *  sh: where to store the shape
+ *
+ *  returns: the population of the phase, or -1 if its box is larger than
+ *           SOUP_MAX_SIDE or half of the torus
+ */
+static int extract(const soup_t* restrict sp, const int g, const int t,
+                   shape_t* restrict sh) {
+  const long long* restrict span = sp->span
+                                   + (size_t) g * (SOUP_MAX_PERIOD + 2);
+  const int ref = sp->cells[sp->members[sp->first[g]]];
+  const int ri = ref / sp->m, rj = ref % sp->m;
+  int top = 0, bottom = -1, left = 0, right = -1, r;
+  long long c;
+
+  // Unwrapped offsets from the first cell, in (-n/2, n/2] and (-m/2, m/2]
+  for (c = span[t]; c < span[t+1]; c++) {
+    int di = (sp->track[c] / sp->m - ri + sp->n) % sp->n;
+    int dj = (sp->track[c] % sp->m - rj + sp->m) % sp->m;
+    if (di > sp->n / 2) di -= sp->n;
+    if (dj > sp->m / 2) dj -= sp->m;
+    if (c == span[t] || di < top) top = di;
+    if (c == span[t] || di > bottom) bottom = di;
+    if (c == span[t] || dj < left) left = dj;
+    if (c == span[t] || dj > right) right = dj;
+  }
+  sh->pop = (int) (span[t+1] - span[t]);
+  if (sh->pop == 0) return 0;
+  sh->h = bottom - top + 1;
+  sh->w = right - left + 1;
+  if (sh->h > SOUP_MAX_SIDE || sh->w > SOUP_MAX_SIDE
+      || 2 * sh->h > sp->n || 2 * sh->w > sp->m) {
+    return -1;
+  }
+
+  sh->row = top;
+  sh->col = left;
+  for (r = 0; r < sh->h; r++) {
+    sh->bits[r] = 0;
+  }
+  for (c = span[t]; c < span[t+1]; c++) {
+    int di = (sp->track[c] / sp->m - ri + sp->n) % sp->n;
+    int dj = (sp->track[c] % sp->m - rj + sp->m) % sp->m;
+    if (di > sp->n / 2) di -= sp->n;
+    if (dj > sp->m / 2) dj -= sp->m;
+    sh->bits[di - top] |= 1ULL << (dj - left);
+  }
+  return sh->pop;
+}
+
+
+
+/*
+ * Function orient
+ * ---------------
+ *  Rotate or reflect a shape
+ *
+ *  src: pointer to the shape
+ *  o: orientation (bit 2 transposes, bit 0 flips the rows upside down and
+ *     bit 1 the columns left to right)
+ *  dst: where to store the result
+ */
+static void orient(const shape_t* restrict src, const int o,
+                   shape_t* restrict dst) {
+  int r, c;
+  dst->h = o & 4 ? src->w : src->h;
+  dst->w = o & 4 ? src->h : src->w;
+  dst->pop = src->pop;
+  dst->row = dst->col = 0;
+  for (r = 0; r < dst->h; r++) {
+    dst->bits[r] = 0;
+  }
+  for (r = 0; r < src->h; r++) {
+    for (c = 0; c < src->w; c++) {
+      if ((src->bits[r] >> c) & 1) {
+        int r2 = o & 4 ? c : r, c2 = o & 4 ? r : c;
+        if (o & 1) r2 = dst->h - 1 - r2;
+        if (o & 2) c2 = dst->w - 1 - c2;
+        dst->bits[r2] |= 1ULL << c2;
+      }
+    }
+  }
+}
+
+
+
+/*
+ * Function encode
+ * ---------------
+ *  Write a shape in Extended Wechsler Format: strips of 5 rows separated by
+ *  'z', each column of a strip a base-32 digit (top row in the lowest bit),
+ *  trailing zero columns dropped and runs of zeros shortened to w (2), x (3)
+ *  or y followed by a digit (4 to 35)
+ *
+ *  sh: pointer to the shape
+ *  out: where to store the code (SOUP_CODE characters)
+ */
+static void encode(const shape_t* restrict sh, char* restrict out) {
+  static const char digits[] = "0123456789abcdefghijklmnopqrstuv";
+  int s, r, c, len;
+  int strip[SOUP_MAX_SIDE];
+
+  for (s = 0; s * 5 < sh->h; s++) {
+    if (s > 0) *out++ = 'z';
+    for (c = 0; c < sh->w; c++) {
+      strip[c] = 0;
+      for (r = 0; r < 5 && s*5 + r < sh->h; r++) {
+        strip[c] |= ((sh->bits[s*5 + r] >> c) & 1) << r;
+      }
+    }
+    for (len = sh->w; len > 0 && strip[len-1] == 0; len--);
+    for (c = 0; c < len; ) {
+      if (strip[c] != 0) {
+        *out++ = digits[strip[c++]];
+        continue;
+      }
+      int run = 0;
+      while (strip[c] == 0) {
+        run++;
+        c++;
+      }
+      while (run >= 4) {
+        const int chunk = run < 35 ? run : 35;
+        *out++ = 'y';
+        *out++ = digits[chunk - 4];
+        run -= chunk;
+      }
+      if (run == 3) *out++ = 'x';
+      if (run == 2) *out++ = 'w';
+      if (run == 1) *out++ = '0';
+    }
+  }
+  *out = '\0';
+}
+
+
+
+/*
+ * Function sameShape
+ * ------------------
+ *  Compare two shapes regardless of where they are
+ *
+ *  a, b: pointers to the shapes
+ *
+ *  returns: whether they have the same cells
+ */
+static int sameShape(const shape_t* restrict a, const shape_t* restrict b) {
+  int r;
+  if (a->h != b->h || a->w != b->w || a->pop != b->pop) return 0;
+  for (r = 0; r < a->h; r++) {
+    if (a->bits[r] != b->bits[r]) return 0;
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function hashCode
+ * -----------------
+ *  FNV-1a hash of the code of an object
+ *
+ *  code: code of the object
+ *
+ *  returns: the hash
+ */
+static unsigned long long hashCode(const char* code) {
+  unsigned long long h = 0xCBF29CE484222325ULL;
+  for (; *code != '\0'; code++) {
+    h = (h ^ (unsigned char) *code) * 0x100000001B3ULL;
+  }
+  return h;
+}
+
+
+
+/*
+ * Function compareEntries
+ * -----------------------
+ *  Order census entries by decreasing count, then by code (for qsort)
+ *
+ *  a, b: pointers to the entries
+ *
+ *  returns: negative, zero or positive as a goes before, with or after b
+ */
+static int compareEntries(const void* a, const void* b) {
+  const censusEntry_t* x = (const censusEntry_t*) a;
+  const censusEntry_t* y = (const censusEntry_t*) b;
+  if (x->count != y->count) return x->count > y->count ? -1 : 1;
+  return strcmp(x->code, y->code);
+}
@@ -0,0 +1,139 @@
+#ifndef SOUP_H
+#define SOUP_H
+
+#include <stdint.h>
+
+// Generations after which an active soup is given up
+#define SOUP_MAX_GENS 10000
+// Longest period recognized when a soup settles
+#define SOUP_MAX_PERIOD 60
+// Generations the population must repeat itself for a soup to be settled
+#define SOUP_SPAN 180
+// Generations between two checks for a settled soup
+#define SOUP_CHECK 8
+// Largest side of an object (the bitmaps of objects are one word per row)
+#define SOUP_MAX_SIDE 64
+// Longest code of an object
+#define SOUP_CODE 1024
+
+/*
+ * Structure censusEntry
+ * ---------------------
+ *  Slot of a census table
+ *
+ *  code: canonical code of the object (NULL for an empty slot)
+ *  count: number of times the object was found
+ */
+typedef struct censusEntry {
+  char* code;
+  long long count;
+} censusEntry_t;
+
+/*
+ * Structure census
+ * ----------------
+ *  Counts of the objects found in the soups, in an open-addressing table
+ *  keyed by their codes
+ *
+ *  slots, cap, size: table of the objects
+ *  soups: soups run
+ *  unsettled: soups still active after the last generation allowed
+ *  pathological: objects that do not repeat themselves alone, or are larger
+ *                than SOUP_MAX_SIDE (counted apart from the table)
+ *  generations: generations computed over all soups
+ */
+typedef struct census {
+  censusEntry_t* slots;
+  long long cap, size;
+  long long soups;
+  long long unsettled;
+  long long pathological;
+  long long generations;
+} census_t;
+
+/*
+ * Structure shape
+ * ---------------
+ *  Cells of one phase of an object, cropped to their bounding box
+ *
+ *  bits: rows of the box (bit c of a row is column c)
+ *  h, w: rows and columns of the box
+ *  row, col: top left corner of the box, relative to the first cell of the
+ *            object in its first phase (unwrapped across the edges of the
+ *            torus)
+ *  pop: live cells
+ */
+typedef struct shape {
+  uint64_t bits[SOUP_MAX_SIDE];
+  int h, w;
+  int row, col;
+  int pop;
+} shape_t;
+
+/*
+ * Structure soup
+ * --------------
+ *  Scratch space to run soups on an n x m torus, the board bit-packed with
+ *  64 cells per word (bits past the last column are zero)
+ *
+ *  n, m: dimensions of the torus
+ *  side: side of the random square at its center
+ *  maxGens: generations after which an active soup is given up
+ *  words: 64-bit words per row
+ *  cur, next: current generation and its scratch buffer
+ *  phases: the SOUP_MAX_PERIOD+1 boards of a soup once it settles
+ *  pops: population of every generation
+ *  cells, nCells: cells alive in the first phase (index i*m + j), which
+ *                 seed the candidate objects
+ *  parent: union-find forest over cells, joining those of one candidate
+ *  group: candidate of every root of the forest
+ *  members, first: indices in cells sorted by candidate, candidate g being
+ *                  members[first[g]] to members[first[g+1]-1]
+ *  bad: whether the soup differs from a candidate evolved alone near it,
+ *       with no other candidate to merge it with
+ *  track, nTrack, capTrack: cells of every candidate in every phase when
+ *                           evolved alone
+ *  span, capSpan: where the cells of candidate g in phase t start in track
+ *                 (index g*(SOUP_MAX_PERIOD+2) + t, the last one ending it)
+ *  label, stamp: candidate that painted every cell around its own in the
+ *                current phase, and the paint it belongs to (so the map is
+ *                never cleared within a soup)
+ *  paint: number of paints of the soup
+ */
+typedef struct soup {
+  int n, m;
+  int side;
+  int maxGens;
+  int words;
+  uint64_t* cur;
+  uint64_t* next;
+  uint64_t* phases;
+  int* pops;
+  int* cells;
+  int nCells;
+  int* parent;
+  int* group;
+  int* members;
+  int* first;
+  char* bad;
+  int* track;
+  long long nTrack, capTrack;
+  long long* span;
+  long long capSpan;
+  int* label;
+  int* stamp;
+  int paint;
+} soup_t;
+
+void censusInit(census_t* restrict cs);
+void censusAdd(census_t* restrict cs, const char* code, const long long count);
+void censusMerge(census_t* restrict into, const census_t* restrict from);
+censusEntry_t* censusSorted(const census_t* restrict cs);
+void censusFree(census_t* restrict cs);
+void soupInit(soup_t* restrict sp, const int n, const int m, const int side,
+              const int maxGens);
+void soupRun(soup_t* restrict sp, const unsigned long long seed,
+             census_t* restrict cs);
+void soupFree(soup_t* restrict sp);
+
+#endif
@@ -0,0 +1,29 @@
+import subprocess
+
+
+output_file = 'test_result.txt'
+jobs_file = 'jobs.txt'
+grid = ['32', '64', '128', '256']
+prob = '0.5'
+nsteps = '100'
+n_boards = 10000
+n_threads = '1'
+debug = '0'
+n_reps = 10
+
+with open(jobs_file, 'w') as f:
+    f.writelines(['{} {}\n'.format(seed+1, prob) for seed in range(n_boards)])
+
+times = [[' ' for j in range(n_reps)] for i in grid]
+
+for index_i, i in enumerate(grid):
+    for j in range(n_reps):
+        command = ' '.join(['./gol', i, i, nsteps, jobs_file, n_threads, debug])
+        proc = subprocess.Popen(command, shell=True, stdout=subprocess.PIPE)
+        subprocess_return = proc.stdout.read().strip().split()[-1]
+#        print(subprocess_return)
+        times[index_i][j] = str(float(subprocess_return))
+    print('{}% complete!'.format(((index_i+1)/len(grid))*100))
+
+with open(output_file, 'w') as f:
+    f.writelines([' '.join(line) + '\n' for line in times])
@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include "utils.h"
+
+
+// Forward declaration of static methods
+static inline unsigned long long splitMix(unsigned long long x);
+
+
+
+/*
+ * Function readJobs
+ * -----------------
+ *  Read the list of boards to evolve. Every line of the file holds a seed and
+ *  a probability separated by whitespace
+ *
+ *  fileName: path of the job file ("-" for standard input)
+ *  nJobs: pointer where the number of jobs read is stored
+ *
+ *  returns: a pointer to the first element of the job array, or NULL if the
+ *           file cannot be read
+ */
+job_t* readJobs(const char* fileName, int* nJobs) {
+  FILE* f = fileName[0] == '-' && fileName[1] == '\0' ? stdin
+                                                      : fopen(fileName, "r");
+  if (f == NULL) {
+    return NULL;
+  }
+  int capacity = 1024;
+  job_t* jobs = (job_t*) malloc(capacity * sizeof(job_t));
+  *nJobs = 0;
+  while (fscanf(f, "%d %lf", &jobs[*nJobs].seed, &jobs[*nJobs].prob) == 2) {
+    (*nJobs)++;
+    if (*nJobs == capacity) {
+      capacity *= 2;
+      jobs = (job_t*) realloc(jobs, capacity * sizeof(job_t));
+    }
+  }
+  if (f != stdin) {
+    fclose(f);
+  }
+  return jobs;
+}
+
+
+
+/*
+ * Function allocateBlock
+ * ----------------------
+ *  Allocate zeroed memory for LANES interleaved bit-packed boards
+ *
+ *  nRows: number of rows of every board
+ *  nCols: number of columns of every board
+ *
+ *  returns: a pointer to the first word of the block
+ */
+uint64_t* allocateBlock(const int nRows, const int nCols) {
+  const int nWords = (nCols + 63) / 64;
+  return (uint64_t*) calloc((size_t) nRows * nWords * LANES, sizeof(uint64_t));
+}
+
+
+
+/*
+ * Function createInitialState
+ * ---------------------------
+ *  Create an initial state for one lane of a block, drawing every row from
+ *  the same counter-based generator as createInitialRow in the other
+ *  variants: the row gets a key from the seed and its index, and cell j is
+ *  alive when the top 53 bits of the mix of the key and j fall below prob.
+ *  A board thus equals the one that ../opt/gol builds from the same seed
+ *
+ *  blk: pointer to the first word of the block
+ *  nRows: number of rows of the board
+ *  nCols: number of columns of the board
+ *  lane: lane of the block that holds the board
+ *  prob: probability of a cell being alive
+ *  seed: key of the draws
+ */
+void createInitialState(uint64_t* restrict blk, const int nRows,
+                        const int nCols, const int lane, const double prob,
+                        const unsigned long long seed) {
+  const int nWords = (nCols + 63) / 64;
+  const unsigned long long threshold = (unsigned long long) (prob * 0x1p53);
+  int i, j;
+  for (i = 0; i < nRows; i++) {
+    const unsigned long long key = splitMix(splitMix(seed) ^ (unsigned) i);
+    uint64_t* restrict row = blk + (size_t) i*nWords*LANES + lane;
+    for (j = 0; j < nCols; j++) {
+      const uint64_t alive = splitMix(key + (unsigned) j) >> 11 < threshold;
+      row[(j/64)*LANES] |= alive << (j%64);
+    }
+  }
+}
+
+
+
+/*
+ * Function population
+ * -------------------
+ *  Count the live cells of one lane of a block
+ *
+ *  blk: pointer to the first word of the block
+ *  nRows: number of rows of the board
+ *  nCols: number of columns of the board
+ *  lane: lane of the block that holds the board
+ *
+ *  returns: the number of live cells
+ */
+long long population(const uint64_t* restrict blk, const int nRows,
+                     const int nCols, const int lane) {
+  const int nWords = (nCols + 63) / 64;
+  size_t w;
+  long long count = 0;
+  for (w = 0; w < (size_t) nRows * nWords; w++) {
+    count += __builtin_popcountll(blk[w*LANES + lane]);
+  }
+  return count;
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+
+/*
+ * Function printBoard
+ * -------------------
+ *  Print one lane of a block to console
+ *
+ *  blk: pointer to the first word of the block
+ *  nRows: number of rows of the board
+ *  nCols: number of columns of the board
+ *  lane: lane of the block that holds the board
+ */
+void printBoard(const uint64_t* restrict blk, const int nRows, const int nCols,
+                const int lane) {
+  const int nWords = (nCols + 63) / 64;
+  int i, j;
+  for (i = 0; i < nRows; i++) {
+    printf("[ ");
+    for (j = 0; j < nCols; j++) {
+      printf("%d ", (int) (blk[((size_t) i*nWords + j/64)*LANES + lane]
+                           >> (j%64)) & 1);
+    }
+    printf("]\n");
+  }
+}
+
+
+
+/*
+* Function: get_wall_seconds
+* ----------------------
+*  Fetch the current wall time
+*
+*  returns: the current wall time
+*/
+double get_wall_seconds() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  double seconds = tv.tv_sec + (double)tv.tv_usec / 1000000;
+  return seconds;
+}
@@ -0,0 +1,17 @@
+#ifndef UTILS_H
+#define UTILS_H
+
+#include "gol.h"
+
+job_t* readJobs(const char* fileName, int* nJobs);
+uint64_t* allocateBlock(const int nRows, const int nCols);
+void createInitialState(uint64_t* restrict blk, const int nRows,
+                        const int nCols, const int lane, const double prob,
+                        const unsigned long long seed);
+long long population(const uint64_t* restrict blk, const int nRows,
+                     const int nCols, const int lane);
+void printBoard(const uint64_t* restrict blk, const int nRows, const int nCols,
+                const int lane);
+double get_wall_seconds();
+
+#endif
@@ -0,0 +1,696 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "adaptive.h"
+#include "utils.h"
+
+
+// Forward declaration of static methods
+static inline char decide(const char alive, const char field);
+static inline void evolveSpan(const char* restrict up,
+                              const char* restrict mid,
+                              const char* restrict down, char* restrict out,
+                              const int j0, const int j1, const int m);
+static void denseGeneration(adaptive_t* restrict ad, char** restrict cur,
+                            char** restrict next);
+static void tiledGeneration(adaptive_t* restrict ad, char** restrict cur,
+                            char** restrict next, const int all);
+static void sparseGeneration(adaptive_t* restrict ad);
+static inline void spanStats(const char* restrict now,
+                             const char* restrict before, const int len,
+                             char* restrict diff, int* restrict pop);
+static inline int spanPop(const char* restrict row, const int len);
+static long long countLive(const adaptive_t* restrict ad, char** restrict cur);
+static inline unsigned long long splitMix(unsigned long long x);
+static long long dilate(adaptive_t* restrict ad);
+static int cheapest(const adaptive_t* restrict ad);
+static void toSparse(adaptive_t* restrict ad, char** restrict cur);
+static void toGrid(adaptive_t* restrict ad, char** restrict cur);
+static void reserveCells(adaptive_t* restrict ad, const long long count);
+
+
+static const char* const names[3] = {"dense", "tiled", "sparse"};
+
+
+
+/*
+ * Function adaptiveInit
+ * ---------------------
+ *  Set up the adaptive engine, starting with the dense one
+ *
+ *  ad: pointer to the engine
+ *  n, m: dimensions of the board
+ *  log: stream where every switch is reported (NULL for none)
+ */
+void adaptiveInit(adaptive_t* restrict ad, const int n, const int m,
+                  FILE* log) {
+  ad->n = n;
+  ad->m = m;
+  ad->mode = ADAPT_DENSE;
+  ad->tn = (n + ADAPT_TILE - 1) / ADAPT_TILE;
+  ad->tm = (m + ADAPT_TILE - 1) / ADAPT_TILE;
+  const size_t tiles = (size_t) ad->tn * ad->tm;
+  ad->changed = (char*) calloc(tiles, sizeof(char));
+  ad->active = (char*) calloc(tiles, sizeof(char));
+  ad->tilePop = (int*) calloc(tiles, sizeof(int));
+  ad->tilePrev = (int*) calloc(tiles, sizeof(int));
+  ad->prints = (unsigned long long*) calloc(3 * tiles,
+                                            sizeof(unsigned long long));
+  ad->fresh = 1;
+  ad->population = 0;
+  ad->activeTiles = tiles;
+  ad->cells = NULL;
+  ad->spare = NULL;
+  ad->touched = NULL;
+  ad->nCells = ad->capCells = 0;
+  ad->keys = NULL;
+  ad->counts = NULL;
+  ad->capMap = 0;
+  ad->since = 0;
+  ad->switches = 0;
+  ad->gens[0] = ad->gens[1] = ad->gens[2] = 0;
+  ad->seconds[0] = ad->seconds[1] = ad->seconds[2] = 0;
+  ad->convert = 0;
+  ad->log = log;
+}
+
+
+
+/*
+ * Function adaptiveEvolve
+ * -----------------------
+ *  Evolve the board for a given number of iterations. After every
+ *  generation measured (all of them, except that the dense engine only
+ *  probes every ADAPT_PROBE), the cost of a generation is estimated for
+ *  every engine: the whole board for the dense one, the tiles next to a
+ *  change since two generations earlier for the tiled one and the live cells
+ *  for the sparse one (see cheapest). The board is converted when the current engine has run for
+ *  ADAPT_MIN_GENS generations, and the thresholds to leave an engine are
+ *  wider than those to enter it, so a run hovering around one does not
+ *  switch back and forth
+ *
+ *  ad: pointer to the engine
+ *  a: grid holding the initial state
+ *  b: scratch grid of the same size
+ *  nSteps: number of iterations
+ *
+ *  returns: a or b, whichever holds the final state
+ */
+char** adaptiveEvolve(adaptive_t* restrict ad, char** restrict a,
+                      char** restrict b, const int nSteps) {
+  char** restrict cur = a;
+  char** restrict next = b;
+  double t = get_wall_seconds();
+  int k, measured = 1;
+
+  for (k = 0; k < nSteps; k++) {
+    measured = 1;
+    if (ad->mode == ADAPT_SPARSE) {
+      sparseGeneration(ad);
+    } else {
+      if (ad->mode == ADAPT_TILED) {
+        tiledGeneration(ad, cur, next, 0);
+      } else if (ad->since % ADAPT_PROBE == 0) {
+        // Probe: every tile, measured like the tiled engine does
+        tiledGeneration(ad, cur, next, 1);
+      } else {
+        denseGeneration(ad, cur, next);
+        measured = 0;
+      }
+      char** restrict tmp = cur;
+      cur = next;
+      next = tmp;
+    }
+    ad->gens[ad->mode]++;
+    ad->since++;
+    if (!measured || ad->since < ADAPT_MIN_GENS) continue;
+
+    // Switch to a cheaper engine
+    const int to = cheapest(ad);
+    if (to == ad->mode) continue;
+    const double now = get_wall_seconds();
+    ad->seconds[ad->mode] += now - t;
+    if (to == ADAPT_SPARSE) {
+      toSparse(ad, cur);
+    } else if (ad->mode == ADAPT_SPARSE) {
+      toGrid(ad, cur);
+    }
+    t = get_wall_seconds();
+    ad->convert += t - now;
+    if (ad->log != NULL) {
+      fprintf(ad->log, "Adaptive: generation %d, %s -> %s, population %lld, "
+              "%lld of %lld tiles active, converted in %.3f ms\n", k+1,
+              names[ad->mode], names[to], ad->population, ad->activeTiles,
+              (long long) ad->tn * ad->tm, (t - now) * 1e3);
+    }
+    ad->mode = to;
+    ad->since = 0;
+    ad->switches++;
+  }
+  ad->seconds[ad->mode] += get_wall_seconds() - t;
+
+  // Leave the final state in a grid, with its population measured
+  if (ad->mode == ADAPT_SPARSE) {
+    toGrid(ad, cur);
+  } else if (!measured) {
+    ad->population = countLive(ad, cur);
+  }
+  return cur;
+}
+
+
+
+/*
+ * Function adaptiveReport
+ * -----------------------
+ *  Print how the run was split among the engines
+ *
+ *  ad: pointer to the engine
+ *  f: stream to print to
+ */
+void adaptiveReport(const adaptive_t* restrict ad, FILE* f) {
+  fprintf(f, "Adaptive: %d switches, dense %lld generations (%.3f s), tiled "
+          "%lld generations (%.3f s), sparse %lld generations (%.3f s), "
+          "conversions %.3f ms, final population %lld\n", ad->switches,
+          ad->gens[ADAPT_DENSE], ad->seconds[ADAPT_DENSE],
+          ad->gens[ADAPT_TILED], ad->seconds[ADAPT_TILED],
+          ad->gens[ADAPT_SPARSE], ad->seconds[ADAPT_SPARSE],
+          ad->convert * 1e3, ad->population);
+}
+
+
+
+/*
+ * Function adaptiveFree
+ * ---------------------
+ *  Free the memory of the adaptive engine (not the grids)
+ *
+ *  ad: pointer to the engine
+ */
+void adaptiveFree(adaptive_t* restrict ad) {
+  free(ad->changed);
+  free(ad->active);
+  free(ad->tilePop);
+  free(ad->tilePrev);
+  free(ad->prints);
+  free(ad->cells);
+  free(ad->spare);
+  free(ad->touched);
+  free(ad->keys);
+  free(ad->counts);
+}
+
+
+
+/*
+ * Function decide
+ * ---------------
+ *  Decide wether a cell lives or dies
+ *
+ *  alive: current state of the cell
+ *  field: number of alive neighbors + the cell itself
+ *
+ *  returns: the future state of the cell
+ */
+static inline char decide(const char alive, const char field) {
+  if (field == 3) {
+    return 1;
+  } else if (field == 4) {
+    return alive;
+  } else {
+    return 0;
+  }
+}
+
+
+
+/*
+ * Function evolveSpan
+ * -------------------
+ *  Compute the future state of columns j0 to j1-1 of one row of the torus
+ *  (the whole row, like evolveRow in gol.c, when they are 0 and m)
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  j0, j1: first and past the last column
+ *  m: number of columns of the matrix
+ */
+static inline void evolveSpan(const char* restrict up,
+                              const char* restrict mid,
+                              const char* restrict down, char* restrict out,
+                              const int j0, const int j1, const int m) {
+  const int end = j1 == m ? m - 1 : j1;
+  int j = j0;
+  char field;
+  // First column (j=0)
+  if (j == 0) {
+    field = up[m-1] + up[0] + up[1]
+            + mid[m-1] + mid[0] + mid[1]
+            + down[m-1] + down[0] + down[1];
+    out[0] = decide(mid[0], field);
+    j = 1;
+  }
+  // Inner columns
+  for (; j < end; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+            + mid[j-1] + mid[j] + mid[j+1]
+            + down[j-1] + down[j] + down[j+1];
+    out[j] = decide(mid[j], field);
+  }
+  // Last column (j=m-1)
+  if (j1 == m) {
+    field = up[m-2] + up[m-1] + up[0]
+            + mid[m-2] + mid[m-1] + mid[0]
+            + down[m-2] + down[m-1] + down[0];
+    out[m-1] = decide(mid[m-1], field);
+  }
+}
+
+
+
+/*
+ * Function denseGeneration
+ * ------------------------
+ *  Compute every row of one generation
+ *
+ *  ad: pointer to the engine
+ *  cur: current generation
+ *  next: where to store the next generation
+ */
+static void denseGeneration(adaptive_t* restrict ad, char** restrict cur,
+                            char** restrict next) {
+  const int n = ad->n, m = ad->m;
+  int i;
+  for (i = 0; i < n; i++) {
+    const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+    const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+    evolveSpan(up, cur[i], down, next[i], 0, m, m);
+  }
+  // The scratch grid holds the previous generation from now on
+  ad->fresh = 0;
+}
+
+
+
+/*
+ * Function tiledGeneration
+ * ------------------------
+ *  Compute the tiles of one generation next to a tile that differs from two
+ *  generations earlier. The scratch grid holds the last generation but one,
+ *  so for the others it already holds the next state: their neighborhood is
+ *  the same as when it was computed. Period-2 oscillators such as blinkers
+ *  thus leave their tiles inactive. Every computed tile is compared with the
+ *  scratch grid before it is overwritten, and the active tiles of the next
+ *  generation are marked
+ *
+ *  ad: pointer to the engine
+ *  cur: current generation
+ *  next: where to store the next generation (holding the previous one)
+ *  all: whether to compute every tile, measuring the population of both
+ *       grids (the probe of the dense engine)
+ */
+static void tiledGeneration(adaptive_t* restrict ad, char** restrict cur,
+                            char** restrict next, const int all) {
+  const int n = ad->n, m = ad->m, tm = ad->tm;
+  // A stale scratch grid has no earlier generation to compare with
+  const int every = all || ad->fresh;
+  char before[ADAPT_TILE];
+  int ti, tj, i;
+
+  ad->population = 0;
+  for (ti = 0; ti < ad->tn; ti++) {
+    const int i0 = ti * ADAPT_TILE;
+    const int i1 = i0 + ADAPT_TILE < n ? i0 + ADAPT_TILE : n;
+    for (tj = 0; tj < tm; tj++) {
+      const int t = ti * tm + tj;
+      if (!every && !ad->active[t]) {
+        ad->changed[t] = 0;
+        ad->population += ad->tilePrev[t];
+        continue;
+      }
+      const int j0 = tj * ADAPT_TILE;
+      const int j1 = j0 + ADAPT_TILE < m ? j0 + ADAPT_TILE : m;
+      char diff = 0;
+      int pop = 0, old = 0;
+      for (i = i0; i < i1; i++) {
+        const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+        const char* restrict mid = cur[i];
+        const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+        char* restrict out = next[i];
+        memcpy(before, out + j0, j1 - j0);
+        evolveSpan(up, mid, down, out, j0, j1, m);
+        spanStats(out + j0, before, j1 - j0, &diff, &pop);
+        if (every) old += spanPop(mid + j0, j1 - j0);
+      }
+      ad->changed[t] = diff || ad->fresh;
+      ad->tilePrev[t] = pop;
+      if (every) ad->tilePop[t] = old;
+      ad->population += pop;
+    }
+  }
+
+  // The populations of the tiles follow their grids
+  int* tmp = ad->tilePop;
+  ad->tilePop = ad->tilePrev;
+  ad->tilePrev = tmp;
+  ad->fresh = 0;
+  dilate(ad);
+}
+
+
+
+/*
+ * Function sparseGeneration
+ * -------------------------
+ *  Compute one generation from the list of live cells: every live cell adds
+ *  16 to its own count and 1 to the counts of its neighbors, then every
+ *  counted cell decides its fate from its count. The table is indexed by the
+ *  cell index itself, so the cells around a live one land in a few runs of
+ *  slots instead of nine random ones. The live cells of every tile are
+ *  summed into a fingerprint, to find the tiles the tiled engine would
+ *  compute
+ *
+ *  ad: pointer to the engine
+ */
+static void sparseGeneration(adaptive_t* restrict ad) {
+  const int n = ad->n, m = ad->m;
+  long long c, s;
+  int di, dj;
+
+  // Table at most half full, even if every neighbor is a different cell
+  const long long need = 18 * ad->nCells + 16;
+  if (ad->capMap < need) {
+    while (ad->capMap < need) ad->capMap = ad->capMap > 0 ? 2 * ad->capMap : 64;
+    free(ad->keys);
+    free(ad->counts);
+    ad->keys = (long long*) malloc(ad->capMap * sizeof(long long));
+    ad->counts = (unsigned char*) malloc(ad->capMap);
+    memset(ad->keys, 0xff, ad->capMap * sizeof(long long));
+  }
+  const long long mask = ad->capMap - 1;
+  long long nTouched = 0;
+  reserveCells(ad, ad->nCells * 9);
+
+  for (c = 0; c < ad->nCells; c++) {
+    const int i = (int) (ad->cells[c] / m), j = (int) (ad->cells[c] - (long long) i * m);
+    // Rows and columns around the cell, wrapping around the torus
+    const long long rows[3] = {(long long) (i == 0 ? n-1 : i-1) * m,
+                               (long long) i * m,
+                               (long long) (i == n-1 ? 0 : i+1) * m};
+    const int cols[3] = {j == 0 ? m-1 : j-1, j, j == m-1 ? 0 : j+1};
+    for (di = 0; di < 3; di++) {
+      for (dj = 0; dj < 3; dj++) {
+        const long long key = rows[di] + cols[dj];
+        s = key & mask;
+        while (ad->keys[s] != key && ad->keys[s] != -1) s = (s + 1) & mask;
+        if (ad->keys[s] == -1) {
+          ad->keys[s] = key;
+          ad->counts[s] = 0;
+          ad->touched[nTouched++] = s;
+        }
+        ad->counts[s] += di == 1 && dj == 1 ? 16 : 1;
+      }
+    }
+  }
+
+  // Fates, emptying the table for the next generation
+  const long long tiles = (long long) ad->tn * ad->tm;
+  unsigned long long* restrict sums = ad->prints + 2 * tiles;
+  unsigned long long* restrict back = ad->prints + (ad->since & 1) * tiles;
+  memset(sums, 0, tiles * sizeof(unsigned long long));
+  long long count = 0;
+  for (c = 0; c < nTouched; c++) {
+    s = ad->touched[c];
+    const long long key = ad->keys[s];
+    const int alive = ad->counts[s] >= 16;
+    const int neighbors = ad->counts[s] & 15;
+    const int born = neighbors == 3 || (alive && neighbors == 2);
+    if (born) {
+      const int i = (int) (key / m), j = (int) (key % m);
+      ad->spare[count++] = key;
+      sums[(i / ADAPT_TILE) * ad->tm + j / ADAPT_TILE] += splitMix(key);
+    }
+    ad->keys[s] = -1;
+  }
+  // A tile changed if its live cells differ from two generations earlier
+  // (compared by fingerprint, which only feeds the estimates); the first two
+  // generations have nothing to compare with
+  for (c = 0; c < tiles; c++) {
+    ad->changed[c] = ad->since < 2 || sums[c] != back[c];
+    back[c] = sums[c];
+  }
+  long long* tmp = ad->cells;
+  ad->cells = ad->spare;
+  ad->spare = tmp;
+  ad->nCells = count;
+  ad->population = count;
+  ad->activeTiles = dilate(ad);
+}
+
+
+
+/*
+ * Function spanStats
+ * ------------------
+ *  Accumulate whether a span of a row changed, and how many of its cells are
+ *  alive. Full tiles are read as 64-bit words: cells are 0 or 1, so the
+ *  multiplication by 0x0101... adds the eight cells of a word into its top
+ *  byte
+ *
+ *  now: pointer to the first element of the span
+ *  before: pointer to the first element of the span as it was before
+ *  len: number of cells of the span
+ *  diff: where to accumulate the changes (non-zero if any)
+ *  pop: where to accumulate the live cells
+ */
+static inline void spanStats(const char* restrict now,
+                             const char* restrict before, const int len,
+                             char* restrict diff, int* restrict pop) {
+  int j;
+  if (len == ADAPT_TILE) {
+    uint64_t x, y, d = 0, sum = 0;
+    for (j = 0; j < len; j += 8) {
+      memcpy(&x, now + j, 8);
+      memcpy(&y, before + j, 8);
+      d |= x ^ y;
+      sum += (x * 0x0101010101010101ULL) >> 56;
+    }
+    *diff |= d != 0;
+    *pop += (int) sum;
+  } else {
+    for (j = 0; j < len; j++) {
+      *diff |= now[j] ^ before[j];
+      *pop += now[j];
+    }
+  }
+}
+
+
+
+/*
+ * Function spanPop
+ * ----------------
+ *  Count the live cells of a span of a row, a 64-bit word at a time like
+ *  spanStats
+ *
+ *  row: pointer to the first element of the span
+ *  len: number of cells of the span
+ *
+ *  returns: the number of live cells
+ */
+static inline int spanPop(const char* restrict row, const int len) {
+  uint64_t x, sum = 0;
+  int j;
+  for (j = 0; j + 8 <= len; j += 8) {
+    memcpy(&x, row + j, 8);
+    sum += (x * 0x0101010101010101ULL) >> 56;
+  }
+  for (; j < len; j++) {
+    sum += row[j];
+  }
+  return (int) sum;
+}
+
+
+
+/*
+ * Function countLive
+ * ------------------
+ *  Count the live cells of a grid
+ *
+ *  ad: pointer to the engine
+ *  cur: grid to count
+ *
+ *  returns: the number of live cells
+ */
+static long long countLive(const adaptive_t* restrict ad, char** restrict cur) {
+  long long count = 0;
+  int i;
+  for (i = 0; i < ad->n; i++) {
+    count += spanPop(cur[i], ad->m);
+  }
+  return count;
+}
+
+
+
+/*
+ * Function dilate
+ * ---------------
+ *  Mark as active the tiles that changed and their neighbors (around the
+ *  torus). The changes are overwritten
+ *
+ *  ad: pointer to the engine
+ *
+ *  returns: the number of active tiles
+ */
+static long long dilate(adaptive_t* restrict ad) {
+  const int tn = ad->tn, tm = ad->tm;
+  long long count = 0;
+  int ti, tj;
+  // Rows of tiles first (into active), then columns (into changed, which is
+  // overwritten by the next generation anyway)
+  for (ti = 0; ti < tn; ti++) {
+    const char* restrict c = ad->changed + ti * tm;
+    char* restrict a = ad->active + ti * tm;
+    for (tj = 0; tj < tm; tj++) {
+      a[tj] = c[tj == 0 ? tm-1 : tj-1] | c[tj] | c[tj == tm-1 ? 0 : tj+1];
+    }
+  }
+  for (ti = 0; ti < tn; ti++) {
+    const char* restrict up = ad->active + (ti == 0 ? tn-1 : ti-1) * tm;
+    const char* restrict mid = ad->active + ti * tm;
+    const char* restrict down = ad->active + (ti == tn-1 ? 0 : ti+1) * tm;
+    char* restrict out = ad->changed + ti * tm;
+    for (tj = 0; tj < tm; tj++) {
+      out[tj] = up[tj] | mid[tj] | down[tj];
+    }
+  }
+  for (ti = 0; ti < tn * tm; ti++) {
+    ad->active[ti] = ad->changed[ti];
+    count += ad->active[ti];
+  }
+  ad->activeTiles = count;
+  return count;
+}
+
+
+
+/*
+ * Function cheapest
+ * -----------------
+ *  Pick the engine to run next. The grid engines cost about the same per
+ *  cell computed, so the tiled one is chosen by the fraction of active tiles,
+ *  with a band between ADAPT_TILED_ENTER and ADAPT_TILED_LEAVE where the
+ *  current one stays. The sparse engine is compared by the estimated cost
+ *  of a generation: the live cells against the cells the grid engine
+ *  computes, plus the visit of every tile for the tiled one
+ *
+ *  ad: pointer to the engine
+ *
+ *  returns: the engine to run next
+ */
+static int cheapest(const adaptive_t* restrict ad) {
+  const double tiles = (double) ad->tn * ad->tm;
+  const double frac = ad->activeTiles / tiles;
+  const int grid = frac < ADAPT_TILED_ENTER
+                   || (ad->mode == ADAPT_TILED && frac <= ADAPT_TILED_LEAVE)
+                   ? ADAPT_TILED : ADAPT_DENSE;
+  const double gridCost = grid == ADAPT_DENSE ? (double) ad->n * ad->m
+                          : ADAPT_TILED_COST * ad->activeTiles * ADAPT_TILE
+                            * ADAPT_TILE + ADAPT_TILE_SCAN * tiles;
+  const double sparseCost = ADAPT_SPARSE_COST * ad->population;
+  if (ad->mode == ADAPT_SPARSE) {
+    return sparseCost > ADAPT_HYSTERESIS * gridCost ? grid : ADAPT_SPARSE;
+  }
+  return sparseCost * ADAPT_HYSTERESIS < gridCost ? ADAPT_SPARSE : grid;
+}
+
+
+
+/*
+ * Function toSparse
+ * -----------------
+ *  Convert the board from a grid to the list of live cells
+ *
+ *  ad: pointer to the engine
+ *  cur: grid holding the current generation
+ */
+static void toSparse(adaptive_t* restrict ad, char** restrict cur) {
+  long long count = 0;
+  int i, j;
+  reserveCells(ad, ad->population);
+  for (i = 0; i < ad->n; i++) {
+    for (j = 0; j < ad->m; j++) {
+      if (cur[i][j]) ad->cells[count++] = (long long) i * ad->m + j;
+    }
+  }
+  ad->nCells = count;
+}
+
+
+
+/*
+ * Function toGrid
+ * ---------------
+ *  Convert the board from the list of live cells to a grid. The scratch grid
+ *  is stale afterwards, so the first tiled generation computes every tile
+ *
+ *  ad: pointer to the engine
+ *  cur: grid where to store the current generation
+ */
+static void toGrid(adaptive_t* restrict ad, char** restrict cur) {
+  long long c;
+  int i;
+  for (i = 0; i < ad->n; i++) {
+    memset(cur[i], 0, ad->m);
+  }
+  for (c = 0; c < ad->nCells; c++) {
+    cur[ad->cells[c] / ad->m][ad->cells[c] % ad->m] = 1;
+  }
+  ad->fresh = 1;
+}
+
+
+
+/*
+ * Function reserveCells
+ * ---------------------
+ *  Make room in the lists of cells of the sparse engine
+ *
+ *  ad: pointer to the engine
+ *  count: number of cells the lists must hold
+ */
+static void reserveCells(adaptive_t* restrict ad, const long long count) {
+  if (count <= ad->capCells) return;
+  ad->capCells = 2 * count;
+  long long* cells = (long long*) malloc(ad->capCells * sizeof(long long));
+  memcpy(cells, ad->cells, ad->nCells * sizeof(long long));
+  free(ad->cells);
+  free(ad->spare);
+  free(ad->touched);
+  ad->cells = cells;
+  ad->spare = (long long*) malloc(ad->capCells * sizeof(long long));
+  ad->touched = (long long*) malloc(ad->capCells * sizeof(long long));
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
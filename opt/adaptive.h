@@ -0,0 +1,97 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <stdio.h>
+
+// Representations of the board
+#define ADAPT_DENSE 0   // Every row of the grid computed
+#define ADAPT_TILED 1   // Only the tiles of the grid next to a change computed
+#define ADAPT_SPARSE 2  // List of the live cells, neighbors counted in a hash
+
+// Side of the tiles that track activity
+#define ADAPT_TILE 32
+// Generations between two activity probes of the dense engine
+#define ADAPT_PROBE 16
+// Generations an engine runs before the next switch is considered
+#define ADAPT_MIN_GENS 16
+// Fractions of active tiles below which the dense engine turns tiled, and
+// above which the tiled one turns dense
+#define ADAPT_TILED_ENTER 0.5
+#define ADAPT_TILED_LEAVE 0.75
+// How much cheaper the estimated cost of the sparse engine has to be to
+// switch to it, or dearer to switch back to a grid
+#define ADAPT_HYSTERESIS 2.0
+// Estimated cost of a cell of an active tile, of visiting any tile and of a
+// live cell of the sparse engine, in cell updates of the dense engine
+#define ADAPT_TILED_COST 1.25
+#define ADAPT_TILE_SCAN 12.0
+#define ADAPT_SPARSE_COST 400.0
+
+/*
+ * Structure adaptive
+ * ------------------
+ *  Torus evolved by whichever of the dense, tiled and sparse engines is
+ *  estimated to be the cheapest for the current population and activity.
+ *  The grid engines share the two grids; the sparse one keeps the live cells
+ *  as indices i*m + j
+ *
+ *  n, m: dimensions of the board
+ *  mode: current engine (ADAPT_DENSE, ADAPT_TILED or ADAPT_SPARSE)
+ *  tn, tm: rows and columns of tiles
+ *  changed: tiles of the last generation that differ from two generations
+ *           earlier
+ *  active: tiles to compute in the next generation (changed or next to one)
+ *  tilePop: live cells of every tile of the current grid
+ *  tilePrev: live cells of every tile of the scratch grid
+ *  prints: fingerprints of the live cells of every tile in the sparse engine,
+ *          for even and odd generations, then the one being summed
+ *  fresh: whether the scratch grid is stale, so every tile is computed once
+ *  population: live cells of the board
+ *  activeTiles: tiles next to a change in the last generation measured
+ *  cells, nCells, capCells: live cells of the sparse engine
+ *  spare: scratch list of the next live cells
+ *  touched: slots of the table filled in the current generation
+ *  keys, counts, capMap: neighbor counts of the sparse engine (keys -1 when
+ *                        empty, counts 16 for a live cell plus 1 per live
+ *                        neighbor)
+ *  since: generations since the last switch
+ *  switches: number of switches
+ *  gens, seconds: generations and time spent in every engine
+ *  convert: time spent converting the board
+ *  log: stream where every switch is reported (NULL for none)
+ */
+typedef struct adaptive {
+  int n, m;
+  int mode;
+  int tn, tm;
+  char* changed;
+  char* active;
+  int* tilePop;
+  int* tilePrev;
+  unsigned long long* prints;
+  int fresh;
+  long long population;
+  long long activeTiles;
+  long long* cells;
+  long long nCells, capCells;
+  long long* spare;
+  long long* touched;
+  long long* keys;
+  unsigned char* counts;
+  long long capMap;
+  int since;
+  int switches;
+  long long gens[3];
+  double seconds[3];
+  double convert;
+  FILE* log;
+} adaptive_t;
+
+void adaptiveInit(adaptive_t* restrict ad, const int n, const int m,
+                  FILE* log);
+char** adaptiveEvolve(adaptive_t* restrict ad, char** restrict a,
+                      char** restrict b, const int nSteps);
+void adaptiveReport(const adaptive_t* restrict ad, FILE* f);
+void adaptiveFree(adaptive_t* restrict ad);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Grid allocation strategies
+#define ALLOC_LEGACY 0   // One malloc per row, no alignment (original layout)
+#define ALLOC_ALIGNED 1  // One block, rows aligned and padded to cache lines
+#define ALLOC_HUGE 2     // Aligned block backed by explicit huge pages
+#define ALLOC_THP 3      // Aligned block with transparent huge pages advised
+
+// Alignment (and padding) of every row: one cache line, one AVX-512 vector
+#define ALLOC_ALIGN 64
+
+void setAllocMode(const int mode);
+int parseAllocMode(const char* name);
+void** gridAlloc(const int nRows, const size_t rowBytes);
+void gridFree(void** rows);
+void allocReport(FILE* f);
+
+#endif
@@ -0,0 +1,27 @@
+import subprocess
+
+
+# Sizes with a specialized kernel (SIZES in the Makefile) and a generic one
+output_file = 'kernel_result.txt'
+grid = [('4096', '4096'), ('8192', '8192'), ('4000', '4000')]
+prob = '0.5'
+nsteps = '100'
+debug = '0'
+n_reps = 10
+
+times = [[' ' for j in range(n_reps)] for i in range(2 * len(grid))]
+
+for index_i, (n, m) in enumerate(grid):
+    for index_k, kernel in enumerate(['', '-generic']):
+        for j in range(n_reps):
+            seed = str(j+1)
+            command = ' '.join(['./gol', n, m, prob, nsteps, seed, debug, kernel])
+            proc = subprocess.Popen(command, shell=True, stdout=subprocess.PIPE)
+            subprocess_return = proc.stdout.read().strip()
+            times[2*index_i + index_k][j] = str(float(subprocess_return))
+        med = sorted(float(t) for t in times[2*index_i + index_k])[n_reps // 2]
+        print('{}x{} {}: median {} s'.format(n, m, kernel or 'default', med))
+
+# One line per size and kernel: default (specialized if available), generic
+with open(output_file, 'w') as f:
+    f.writelines([' '.join(line) + '\n' for line in times])
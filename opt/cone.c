@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cone.h"
+
+
+// Forward declaration of static methods
+static void region(cone_t* restrict cn, const int t, const long long i0,
+                   const long long j0, const int h, const int w,
+                   char* restrict out);
+static inline unsigned long long tileKey(const cone_t* restrict cn,
+                                         const int level, const long long tr,
+                                         const long long tc);
+static void store(cone_t* restrict cn, const unsigned long long key,
+                  char* cells);
+static tileEntry_t* lookup(const cone_t* restrict cn,
+                           const unsigned long long key);
+static void grow(cone_t* restrict cn);
+static void shrink(const char* restrict in, char* restrict out, const int h,
+                   const int w);
+static void torusStep(const char* restrict cur, char* restrict next,
+                      const int n, const int m);
+static inline int wrap(const long long x, const int n);
+static inline long long floorDiv(const long long x, const int d);
+
+
+
+/*
+ * Function coneInit
+ * -----------------
+ *  Create an evaluator of light cones from an initial board
+ *
+ *  cn: pointer to the evaluator
+ *  mat: pointer to the first element of the initial board
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ */
+void coneInit(cone_t* restrict cn, char** restrict mat, const int n,
+              const int m) {
+  int i;
+  cn->n = n;
+  cn->m = m;
+  cn->init = (char*) malloc((size_t) n * m);
+  for (i = 0; i < n; i++) {
+    memcpy(cn->init + (size_t) i * m, mat[i], m);
+  }
+  cn->cap = 1024;
+  cn->memo = (tileEntry_t*) calloc(cn->cap, sizeof(tileEntry_t));
+  cn->tiles = 0;
+  cn->full = cn->scratch = NULL;
+  cn->fullGen = -1;
+  cn->updates = cn->hits = 0;
+}
+
+
+
+/*
+ * Function coneQuery
+ * ------------------
+ *  Compute a region of the board at a generation. The light cone of the
+ *  region is evaluated unless it holds more cells than the board, in which
+ *  case the whole board is evolved (from the last board evolved if it is not
+ *  past the generation, from the initial one otherwise)
+ *
+ *  cn: pointer to the evaluator
+ *  q: pointer to the query
+ *  out: pointer to the h x w cells of the region to fill (row-major)
+ *
+ *  returns: 1 if the whole board was evolved, 0 if only the light cone
+ */
+int coneQuery(cone_t* restrict cn, const query_t* restrict q,
+              char* restrict out) {
+  const int n = cn->n, m = cn->m;
+  const long long cone = (long long) (q->h + 2*q->gen) * (q->w + 2*q->gen);
+  char* tmp;
+  int r, c;
+
+  if (cone < (long long) n * m) {
+    region(cn, q->gen, q->i, q->j, q->h, q->w, out);
+    return 0;
+  }
+
+  if (cn->full == NULL) {
+    cn->full = (char*) malloc((size_t) n * m);
+    cn->scratch = (char*) malloc((size_t) n * m);
+  }
+  if (cn->fullGen < 0 || cn->fullGen > q->gen) {
+    memcpy(cn->full, cn->init, (size_t) n * m);
+    cn->fullGen = 0;
+  }
+  for (; cn->fullGen < q->gen; cn->fullGen++) {
+    torusStep(cn->full, cn->scratch, n, m);
+    tmp = cn->full;
+    cn->full = cn->scratch;
+    cn->scratch = tmp;
+    cn->updates += (long long) n * m;
+  }
+  for (r = 0; r < q->h; r++) {
+    const char* restrict row = cn->full + (size_t) wrap(q->i + r, n) * m;
+    for (c = 0; c < q->w; c++) {
+      out[(size_t) r * q->w + c] = row[wrap(q->j + c, m)];
+    }
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function coneFree
+ * -----------------
+ *  Free the initial board, the memoized tiles and the full boards
+ *
+ *  cn: pointer to the evaluator
+ */
+void coneFree(cone_t* restrict cn) {
+  long long s;
+  for (s = 0; s < cn->cap; s++) {
+    free(cn->memo[s].cells);
+  }
+  free(cn->memo);
+  free(cn->init);
+  free(cn->full);
+  free(cn->scratch);
+}
+
+
+
+/*
+ * Function region
+ * ---------------
+ *  Compute a region at a generation from its light cone at the level below:
+ *  the region grown by the generations in between is read from the
+ *  memoized tiles of that level (or from the initial board) and evolved
+ *  while it shrinks by one cell on every side per generation. The missing
+ *  tiles are computed together, as the smallest block of tiles holding
+ *  them, so that their cones are evaluated once
+ *
+ *  cn: pointer to the evaluator
+ *  t: generation
+ *  i0, j0: top left cell of the region (any integer, wrapped on the torus)
+ *  h, w: rows and columns of the region
+ *  out: pointer to the h x w cells to fill (row-major)
+ */
+static void region(cone_t* restrict cn, const int t, const long long i0,
+                   const long long j0, const int h, const int w,
+                   char* restrict out) {
+  const int n = cn->n, m = cn->m;
+  long long tr, tc;
+  int r, c, s;
+
+  if (t == 0) {
+    for (r = 0; r < h; r++) {
+      const char* restrict row = cn->init + (size_t) wrap(i0 + r, n) * m;
+      for (c = 0; c < w; ) {
+        const int j = wrap(j0 + c, m);
+        const int len = w - c < m - j ? w - c : m - j;
+        memcpy(out + (size_t) r * w + c, row + j, len);
+        c += len;
+      }
+    }
+    return;
+  }
+
+  const int t0 = (t - 1) / CONE_LEVEL * CONE_LEVEL;
+  const int level = t0 / CONE_LEVEL;
+  const int d = t - t0;
+  const int hh = h + 2*d, ww = w + 2*d;
+  char* a = (char*) malloc((size_t) hh * ww);
+  char* b = (char*) malloc((size_t) hh * ww);
+  char* tmp;
+
+  if (t0 == 0) {
+    region(cn, 0, i0 - d, j0 - d, hh, ww, a);
+  } else {
+    // Tiles covering the grown region, and the block of the missing ones
+    const long long tr0 = floorDiv(i0 - d, CONE_TILE);
+    const long long tr1 = floorDiv(i0 + h + d - 1, CONE_TILE);
+    const long long tc0 = floorDiv(j0 - d, CONE_TILE);
+    const long long tc1 = floorDiv(j0 + w + d - 1, CONE_TILE);
+    long long mr0 = tr1 + 1, mr1 = tr0 - 1, mc0 = tc1 + 1, mc1 = tc0 - 1;
+    for (tr = tr0; tr <= tr1; tr++) {
+      for (tc = tc0; tc <= tc1; tc++) {
+        if (lookup(cn, tileKey(cn, level, tr, tc))->key != 0) {
+          cn->hits++;
+        } else {
+          mr0 = tr < mr0 ? tr : mr0;
+          mr1 = tr > mr1 ? tr : mr1;
+          mc0 = tc < mc0 ? tc : mc0;
+          mc1 = tc > mc1 ? tc : mc1;
+        }
+      }
+    }
+    if (mr0 <= mr1) {
+      const int bh = (int) (mr1 - mr0 + 1) * CONE_TILE;
+      const int bw = (int) (mc1 - mc0 + 1) * CONE_TILE;
+      char* block = (char*) malloc((size_t) bh * bw);
+      region(cn, t0, mr0 * CONE_TILE, mc0 * CONE_TILE, bh, bw, block);
+      for (tr = mr0; tr <= mr1; tr++) {
+        for (tc = mc0; tc <= mc1; tc++) {
+          const unsigned long long key = tileKey(cn, level, tr, tc);
+          if (lookup(cn, key)->key != 0) {
+            continue;
+          }
+          char* cells = (char*) malloc(CONE_TILE * CONE_TILE);
+          for (r = 0; r < CONE_TILE; r++) {
+            memcpy(cells + r * CONE_TILE,
+                   block + (size_t) ((tr - mr0) * CONE_TILE + r) * bw
+                   + (tc - mc0) * CONE_TILE, CONE_TILE);
+          }
+          store(cn, key, cells);
+        }
+      }
+      free(block);
+    }
+
+    // Copy the grown region out of the tiles
+    for (r = 0; r < hh; r++) {
+      const long long i = i0 - d + r;
+      tr = floorDiv(i, CONE_TILE);
+      for (c = 0; c < ww; ) {
+        const long long j = j0 - d + c;
+        tc = floorDiv(j, CONE_TILE);
+        const int cj = (int) (j - tc * CONE_TILE);
+        const int len = ww - c < CONE_TILE - cj ? ww - c : CONE_TILE - cj;
+        const tileEntry_t* e = lookup(cn, tileKey(cn, level, tr, tc));
+        memcpy(a + (size_t) r * ww + c,
+               e->cells + (i - tr * CONE_TILE) * CONE_TILE + cj, len);
+        c += len;
+      }
+    }
+  }
+
+  for (s = 0; s < d; s++) {
+    shrink(a, b, hh - 2*s, ww - 2*s);
+    cn->updates += (long long) (hh - 2*s - 2) * (ww - 2*s - 2);
+    tmp = a;
+    a = b;
+    b = tmp;
+  }
+  memcpy(out, a, (size_t) h * w);
+  free(a);
+  free(b);
+}
+
+
+
+/*
+ * Function tileKey
+ * ----------------
+ *  Key of a tile in the memo. Tiles are aligned to CONE_TILE on the unrolled
+ *  torus; tiles that start at the same cell of the torus hold the same
+ *  cells, so they share the key
+ *
+ *  cn: pointer to the evaluator
+ *  level: level of the tile (generation level * CONE_LEVEL)
+ *  tr, tc: row and column of the tile on the unrolled torus
+ *
+ *  returns: the key, never 0
+ */
+static inline unsigned long long tileKey(const cone_t* restrict cn,
+                                         const int level, const long long tr,
+                                         const long long tc) {
+  return ((unsigned long long) level << 48)
+         | ((unsigned long long) wrap(tr * CONE_TILE, cn->n) << 24)
+         | (unsigned long long) wrap(tc * CONE_TILE, cn->m);
+}
+
+
+
+/*
+ * Function store
+ * --------------
+ *  Add a tile to the memo
+ *
+ *  cn: pointer to the evaluator
+ *  key: key of the tile (not in the memo yet)
+ *  cells: CONE_TILE x CONE_TILE cells of the tile
+ */
+static void store(cone_t* restrict cn, const unsigned long long key,
+                  char* cells) {
+  if (2 * (cn->tiles + 1) > cn->cap) {
+    grow(cn);
+  }
+  tileEntry_t* e = lookup(cn, key);
+  e->key = key;
+  e->cells = cells;
+  cn->tiles++;
+}
+
+
+
+/*
+ * Function lookup
+ * ---------------
+ *  Find the slot of a key in the memo (linear probing)
+ *
+ *  cn: pointer to the evaluator
+ *  key: key of the tile
+ *
+ *  returns: pointer to the slot holding the key, or to the empty slot where
+ *           it would go
+ */
+static tileEntry_t* lookup(const cone_t* restrict cn,
+                           const unsigned long long key) {
+  unsigned long long s = key * 0x9E3779B97F4A7C15ULL;
+  s ^= s >> 29;
+  s &= cn->cap - 1;
+  while (cn->memo[s].key != 0 && cn->memo[s].key != key) {
+    s = (s + 1) & (cn->cap - 1);
+  }
+  return &cn->memo[s];
+}
+
+
+
+/*
+ * Function grow
+ * -------------
+ *  Double the capacity of the memo
+ *
+ *  cn: pointer to the evaluator
+ */
+static void grow(cone_t* restrict cn) {
+  tileEntry_t* old = cn->memo;
+  const long long cap = cn->cap;
+  long long s;
+  cn->cap *= 2;
+  cn->memo = (tileEntry_t*) calloc(cn->cap, sizeof(tileEntry_t));
+  for (s = 0; s < cap; s++) {
+    if (old[s].key != 0) {
+      *lookup(cn, old[s].key) = old[s];
+    }
+  }
+  free(old);
+}
+
+
+
+/*
+ * Function shrink
+ * ---------------
+ *  Evolve the inner cells of a window one generation: the border of the
+ *  window is only read, so the result is two rows and two columns smaller
+ *
+ *  in: pointer to the h x w cells of the window (row-major)
+ *  out: pointer to the (h-2) x (w-2) cells of the next generation
+ *  h, w: rows and columns of the window
+ */
+static void shrink(const char* restrict in, char* restrict out, const int h,
+                   const int w) {
+  int r, c;
+  for (r = 1; r < h - 1; r++) {
+    const char* restrict up = in + (size_t) (r-1) * w;
+    const char* restrict mid = in + (size_t) r * w;
+    const char* restrict down = in + (size_t) (r+1) * w;
+    char* restrict dst = out + (size_t) (r-1) * (w-2) - 1;
+    for (c = 1; c < w - 1; c++) {
+      const char field = up[c-1] + up[c] + up[c+1]
+                         + mid[c-1] + mid[c] + mid[c+1]
+                         + down[c-1] + down[c] + down[c+1];
+      dst[c] = (field == 3) | ((field == 4) & mid[c]);
+    }
+  }
+}
+
+
+
+/*
+ * Function torusStep
+ * ------------------
+ *  Evolve the whole torus one generation
+ *
+ *  cur: pointer to the n x m cells of the board (row-major)
+ *  next: pointer to the n x m cells of the next generation
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ */
+static void torusStep(const char* restrict cur, char* restrict next,
+                      const int n, const int m) {
+  int i, j;
+  for (i = 0; i < n; i++) {
+    const char* restrict up = cur + (size_t) (i == 0 ? n-1 : i-1) * m;
+    const char* restrict mid = cur + (size_t) i * m;
+    const char* restrict down = cur + (size_t) (i == n-1 ? 0 : i+1) * m;
+    for (j = 0; j < m; j++) {
+      const int l = j == 0 ? m-1 : j-1, r = j == m-1 ? 0 : j+1;
+      const char field = up[l] + up[j] + up[r] + mid[l] + mid[j] + mid[r]
+                         + down[l] + down[j] + down[r];
+      next[(size_t) i * m + j] = (field == 3) | ((field == 4) & mid[j]);
+    }
+  }
+}
+
+
+
+/*
+ * Function wrap
+ * -------------
+ *  Bring a coordinate back onto the torus
+ *
+ *  x: coordinate
+ *  n: size of the dimension
+ *
+ *  returns: x modulo n, between 0 and n-1
+ */
+static inline int wrap(const long long x, const int n) {
+  const long long r = x % n;
+  return (int) (r < 0 ? r + n : r);
+}
+
+
+
+/*
+ * Function floorDiv
+ * -----------------
+ *  Division rounding towards minus infinity
+ *
+ *  x: dividend
+ *  d: positive divisor
+ *
+ *  returns: the largest q with q * d <= x
+ */
+static inline long long floorDiv(const long long x, const int d) {
+  return x >= 0 ? x / d : -((-x + d - 1) / d);
+}
@@ -0,0 +1,78 @@
+#ifndef CONE_H
+#define CONE_H
+
+// Side of the memoized tiles
+#define CONE_TILE 32
+// Generations between the levels at which tiles are memoized. A multiple of
+// CONE_TILE, so a block of tiles grown by the cone of a level is a block of
+// tiles of the level below
+#define CONE_LEVEL 32
+// Most queries given on the command line
+#define CONE_MAX_QUERIES 16
+
+/*
+ * Structure query
+ * ---------------
+ *  Region of the torus wanted at some generation
+ *
+ *  gen: generation
+ *  i, j: top left cell of the region
+ *  h, w: rows and columns of the region
+ */
+typedef struct query {
+  int gen;
+  int i, j;
+  int h, w;
+} query_t;
+
+/*
+ * Structure tileEntry
+ * -------------------
+ *  Slot of the memo of tiles
+ *
+ *  key: level and first row and column of the tile (0 for an empty slot)
+ *  cells: CONE_TILE x CONE_TILE cells of the tile (row-major, wrapping
+ *         around the torus)
+ */
+typedef struct tileEntry {
+  unsigned long long key;
+  char* cells;
+} tileEntry_t;
+
+/*
+ * Structure cone
+ * --------------
+ *  Evaluator of regions of the torus at a later generation from the initial
+ *  board, computing only their light cone. Tiles of the board at the
+ *  generations multiple of CONE_LEVEL are memoized as they are computed, so
+ *  queries with overlapping cones share them. A query whose cone holds more
+ *  cells than the board is answered by evolving the whole board instead,
+ *  keeping the last board evolved for later queries
+ *
+ *  n, m: dimensions of the board
+ *  init: initial board (n x m, row-major)
+ *  memo, cap, tiles: open-addressing table of the memoized tiles
+ *  full, scratch: whole board at generation fullGen, and its scratch buffer
+ *  fullGen: generation of full (-1 before the first full evaluation)
+ *  updates: number of cell updates computed so far
+ *  hits: tiles a region found already memoized
+ */
+typedef struct cone {
+  int n, m;
+  char* init;
+  tileEntry_t* memo;
+  long long cap, tiles;
+  char* full;
+  char* scratch;
+  int fullGen;
+  long long updates;
+  long long hits;
+} cone_t;
+
+void coneInit(cone_t* restrict cn, char** restrict mat, const int n,
+              const int m);
+int coneQuery(cone_t* restrict cn, const query_t* restrict q,
+              char* restrict out);
+void coneFree(cone_t* restrict cn);
+
+#endif
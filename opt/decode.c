@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "delta.h"
+
+
+
+int main(int argc, char const *argv[]) {
+
+  // Check that arguments are provided
+  if (argc != 3) {
+    printf("Usage: %s streamFile gen\n", argv[0]);
+    printf("  print generation gen of a stream written by gol -delta\n");
+    return -1;
+  }
+
+  // Parse arguments
+  const int target = atoi(argv[2]);
+  FILE* f = fopen(argv[1], "rb");
+  int n, m, interval;
+  if (f == NULL || deltaReadHeader(f, &n, &m, &interval) != 0 || target < 0) {
+    printf("Usage:\n  streamFile must be a generation stream\n  gen must be a non-negative integer\n");
+    return -1;
+  }
+
+  // Initialize data structures
+  char** mat = (char**) malloc(n * sizeof(char*));
+  int i, j;
+  for (i = 0; i < n; i++) {
+    mat[i] = (char*) calloc(m, sizeof(char));
+  }
+
+  // Frames before the last keyframe are skipped without being read
+  const int keyGen = target - target % interval;
+  int gen = -1, key, found = 0;
+  unsigned char* payload;
+  size_t len;
+  while (!found) {
+    const int skip = gen+1 < keyGen;
+    if (deltaReadFrame(f, &gen, &key, skip ? NULL : &payload, &len) != 0) {
+      break;
+    }
+    if (skip || gen < keyGen) {
+      if (!skip) free(payload);
+      continue;
+    }
+    if (key) {
+      for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++) {
+          mat[i][j] = 0;
+        }
+      }
+    }
+    if (deltaApply(payload, len, mat, n, m) != 0) {
+      printf("Corrupt frame at generation %d\n", gen);
+      free(payload);
+      return -1;
+    }
+    free(payload);
+    found = gen == target;
+  }
+  fclose(f);
+  if (!found) {
+    printf("Generation %d is not in the stream\n", target);
+    return -1;
+  }
+
+  // Print the board
+  printf("Generation %d:\n", target);
+  for (i = 0; i < n; i++) {
+    printf("[ ");
+    for (j = 0; j < m; j++) {
+      printf("%d ", mat[i][j]);
+    }
+    printf("]\n");
+  }
+
+  // Free data structures
+  for (i = 0; i < n; i++) {
+    free(mat[i]);
+  }
+  free(mat);
+
+  return 0;
+}
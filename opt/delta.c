@@ -0,0 +1,450 @@
+#include <stdlib.h>
+#include <string.h>
+#include "delta.h"
+
+
+// Forward declaration of static methods
+static inline void put(delta_t* restrict dl, unsigned long long v);
+static inline unsigned long long changedBits(const char* restrict prev,
+                                             const char* restrict row,
+                                             const int base, const int m);
+static int writeVarint(FILE* f, unsigned long long v);
+static int readVarint(FILE* f, unsigned long long* v);
+static inline int getVarint(const unsigned char* restrict p, const size_t len,
+                            size_t* pos, unsigned long long* v);
+
+
+
+/*
+ * Function deltaOpen
+ * ------------------
+ *  Create a generation stream and write its header
+ *
+ *  dl: pointer to the writer
+ *  path: path of the stream
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  interval: a keyframe is written every interval generations
+ *
+ *  returns: 0 on success, -1 if the file cannot be created
+ */
+int deltaOpen(delta_t* restrict dl, const char* path, const int n,
+              const int m, const int interval) {
+  dl->f = fopen(path, "wb");
+  if (dl->f == NULL) {
+    return -1;
+  }
+  dl->n = n;
+  dl->m = m;
+  dl->interval = interval;
+  dl->cap = 4096;
+  dl->buf = (unsigned char*) malloc(dl->cap);
+  dl->len = 0;
+  dl->mask = (unsigned long long*) malloc(((m + 63) / 64)
+                                          * sizeof(unsigned long long));
+  dl->frames = dl->keyframes = 0;
+  fwrite(DELTA_MAGIC, 1, 4, dl->f);
+  dl->bytes = 4 + writeVarint(dl->f, n) + writeVarint(dl->f, m)
+              + writeVarint(dl->f, interval);
+  return 0;
+}
+
+
+
+/*
+ * Function deltaBegin
+ * -------------------
+ *  Start the frame of a generation
+ *
+ *  dl: pointer to the writer
+ *  gen: generation of the frame
+ */
+void deltaBegin(delta_t* restrict dl, const int gen) {
+  dl->key = gen % dl->interval == 0;
+  dl->len = 0;
+  dl->lastRow = -1;
+}
+
+
+
+/*
+ * Function deltaRow
+ * -----------------
+ *  Append the changes of one row to the current frame. It is called right
+ *  after the row is computed, while both versions are still in cache. The
+ *  changed cells of every 64 columns are first gathered in a bit mask, which
+ *  gives the number of runs with a few popcounts. Rows with many short runs
+ *  (chaotic regions) are stored as the raw mask, the others as runs found
+ *  with count-trailing-zeros
+ *
+ *  dl: pointer to the writer
+ *  prev: pointer to the first element of the row in the previous generation
+ *        (ignored for keyframes)
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  i: index of the row
+ */
+void deltaRow(delta_t* restrict dl, const char* restrict prev,
+              const char* restrict row, const int m, const int i) {
+  const int nChunks = (m + 63) / 64, nBytes = (m + 7) / 8;
+  unsigned long long* restrict mask = dl->mask;
+  unsigned long long any = 0, carry = 0;
+  long long runs = 0;
+  int c;
+  if (dl->key) {
+    prev = NULL;
+  }
+  for (c = 0; c < nChunks; c++) {
+    const unsigned long long bits = changedBits(prev, row, 64*c, m);
+    mask[c] = bits;
+    any |= bits;
+    runs += __builtin_popcountll(bits & ~((bits << 1) | carry));
+    carry = bits >> 63;
+  }
+  if (!any) {
+    return;
+  }
+
+  // Room for the worst case, so that put does not need to check it
+  if (dl->len + 2 * (size_t) nBytes + 16 > dl->cap) {
+    dl->cap = 2 * (dl->len + 2 * (size_t) nBytes + 16);
+    dl->buf = (unsigned char*) realloc(dl->buf, dl->cap);
+  }
+  put(dl, i - dl->lastRow);
+  dl->lastRow = i;
+
+  // Raw mask when the runs would take more space (a run takes 2 bytes or
+  // more)
+  if (2*runs >= nBytes) {
+    put(dl, 0);
+    memcpy(dl->buf + dl->len, mask, nBytes);
+    dl->len += nBytes;
+    return;
+  }
+
+  // Runs start where a changed cell follows an unchanged one and end where
+  // an unchanged cell follows a changed one, so both are read off bit masks
+  int start = 0, end = 0, inRun = 0;
+  carry = 0;
+  for (c = 0; c < nChunks; c++) {
+    const unsigned long long bits = mask[c];
+    const unsigned long long shifted = (bits << 1) | carry;
+    unsigned long long starts = bits & ~shifted;
+    unsigned long long ends = ~bits & shifted;  // Past the row: unchanged
+    carry = bits >> 63;
+    if (inRun && ends) {
+      const int stop = 64*c + __builtin_ctzll(ends);
+      ends &= ends - 1;
+      put(dl, start - end + 1);
+      put(dl, stop - start);
+      end = stop;
+      inRun = 0;
+    }
+    while (ends) {
+      start = 64*c + __builtin_ctzll(starts);
+      starts &= starts - 1;
+      const int stop = 64*c + __builtin_ctzll(ends);
+      ends &= ends - 1;
+      put(dl, start - end + 1);
+      put(dl, stop - start);
+      end = stop;
+    }
+    if (starts) {
+      start = 64*c + __builtin_ctzll(starts);
+      inRun = 1;
+    }
+  }
+  // Run reaching the last column
+  if (inRun) {
+    put(dl, start - end + 1);
+    put(dl, m - start);
+  }
+  put(dl, 0);
+}
+
+
+
+/*
+ * Function deltaEnd
+ * -----------------
+ *  Write the frame of a generation to the stream
+ *
+ *  dl: pointer to the writer
+ *  gen: generation of the frame
+ */
+void deltaEnd(delta_t* restrict dl, const int gen) {
+  dl->buf[dl->len++] = 0;
+  dl->bytes += writeVarint(dl->f, gen);
+  fputc(dl->key, dl->f);
+  dl->bytes += 1 + writeVarint(dl->f, dl->len) + dl->len;
+  fwrite(dl->buf, 1, dl->len, dl->f);
+  dl->frames++;
+  dl->keyframes += dl->key;
+}
+
+
+
+/*
+ * Function deltaClose
+ * -------------------
+ *  Close a generation stream and report its size against full bit-packed
+ *  frames
+ *
+ *  dl: pointer to the writer
+ */
+void deltaClose(delta_t* restrict dl) {
+  const double raw = (double) dl->frames * dl->n * ((dl->m + 7) / 8);
+  fprintf(stderr, "Delta stream: %lld frames (%lld keyframes), %lld bytes, "
+          "%.2f%% of bit-packed frames\n", dl->frames, dl->keyframes,
+          dl->bytes, raw > 0 ? 100.0 * dl->bytes / raw : 0.0);
+  fclose(dl->f);
+  free(dl->buf);
+  free(dl->mask);
+}
+
+
+
+/*
+ * Function deltaReadHeader
+ * ------------------------
+ *  Read the header of a generation stream
+ *
+ *  f: stream positioned at its beginning
+ *  n, m: where to store the dimensions of the board
+ *  interval: where to store the keyframe interval
+ *
+ *  returns: 0 on success, -1 if the stream is not a generation stream
+ */
+int deltaReadHeader(FILE* f, int* n, int* m, int* interval) {
+  char magic[4];
+  unsigned long long v[3];
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, DELTA_MAGIC, 4) != 0
+      || readVarint(f, &v[0]) || readVarint(f, &v[1])
+      || readVarint(f, &v[2]) || v[2] == 0) {
+    return -1;
+  }
+  *n = (int) v[0];
+  *m = (int) v[1];
+  *interval = (int) v[2];
+  return 0;
+}
+
+
+
+/*
+ * Function deltaReadFrame
+ * -----------------------
+ *  Read the next frame of a generation stream
+ *
+ *  f: stream positioned at the start of a frame
+ *  gen: where to store the generation of the frame
+ *  key: where to store whether it is a keyframe
+ *  payload: where to store a pointer to the payload (allocated with malloc),
+ *           or NULL to skip over it
+ *  len: where to store the length of the payload
+ *
+ *  returns: 0 on success, -1 at the end of the stream
+ */
+int deltaReadFrame(FILE* f, int* gen, int* key, unsigned char** payload,
+                   size_t* len) {
+  unsigned long long g, l;
+  int k;
+  if (readVarint(f, &g) || (k = fgetc(f)) == EOF || readVarint(f, &l)) {
+    return -1;
+  }
+  *gen = (int) g;
+  *key = k;
+  *len = (size_t) l;
+  if (payload == NULL) {
+    return fseek(f, (long) l, SEEK_CUR) == 0 ? 0 : -1;
+  }
+  *payload = (unsigned char*) malloc(l > 0 ? l : 1);
+  if (fread(*payload, 1, l, f) != l) {
+    free(*payload);
+    return -1;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function deltaApply
+ * -------------------
+ *  Apply the payload of a frame to a board: delta frames flip the listed
+ *  cells of the previous generation, keyframes must be applied to an empty
+ *  board
+ *
+ *  payload: pointer to the first byte of the payload
+ *  len: length of the payload
+ *  mat: pointer to the first element of the board
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *
+ *  returns: 0 on success, -1 if the payload is corrupt
+ */
+int deltaApply(const unsigned char* restrict payload, const size_t len,
+               char** restrict mat, const int n, const int m) {
+  size_t pos = 0;
+  unsigned long long gap, skip, run;
+  long long i = -1, j, end;
+  while (1) {
+    if (getVarint(payload, len, &pos, &gap)) return -1;
+    if (gap == 0) return 0;
+    i += gap;
+    if (i >= n) return -1;
+    end = 0;
+    if (getVarint(payload, len, &pos, &skip)) return -1;
+    if (skip == 0) {
+      // Raw mask of the changed cells
+      if (pos + (m + 7) / 8 > len) return -1;
+      for (j = 0; j < m; j++) {
+        mat[i][j] ^= (payload[pos + j/8] >> (j%8)) & 1;
+      }
+      pos += (m + 7) / 8;
+      continue;
+    }
+    while (skip != 0) {
+      if (getVarint(payload, len, &pos, &run)) return -1;
+      j = end + skip - 1;
+      end = j + run;
+      if (end > m) return -1;
+      for (; j < end; j++) {
+        mat[i][j] ^= 1;
+      }
+      if (getVarint(payload, len, &pos, &skip)) return -1;
+    }
+  }
+}
+
+
+
+/*
+ * Function put
+ * ------------
+ *  Append a varint to the frame being built (the caller makes room for it)
+ *
+ *  dl: pointer to the writer
+ *  v: value to append
+ */
+static inline void put(delta_t* restrict dl, unsigned long long v) {
+  while (v >= 0x80) {
+    dl->buf[dl->len++] = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  dl->buf[dl->len++] = (unsigned char) v;
+}
+
+
+
+/*
+ * Function changedBits
+ * --------------------
+ *  Gather which of 64 consecutive cells changed into a bit mask. Cells are 0
+ *  or 1, so the XOR of eight cells read as one word is packed into eight
+ *  bits with one multiplication
+ *
+ *  prev: pointer to the first element of the previous row (NULL for empty)
+ *  row: pointer to the first element of the row
+ *  base: column of the first cell
+ *  m: number of columns of the row
+ *
+ *  returns: the mask, with bit b set if cell base+b changed
+ */
+static inline unsigned long long changedBits(const char* restrict prev,
+                                             const char* restrict row,
+                                             const int base, const int m) {
+  unsigned long long bits = 0, x, y = 0;
+  int k, j;
+  for (k = 0; k < 8 && base + 8*k + 8 <= m; k++) {
+    memcpy(&x, row + base + 8*k, 8);
+    if (prev != NULL) {
+      memcpy(&y, prev + base + 8*k, 8);
+    }
+    bits |= (((x ^ y) * 0x0102040810204080ULL) >> 56) << (8*k);
+  }
+  for (j = base + 8*k; j < m && j < base + 64; j++) {
+    if (row[j] != (prev != NULL ? prev[j] : 0)) {
+      bits |= 1ULL << (j - base);
+    }
+  }
+  return bits;
+}
+
+
+
+/*
+ * Function writeVarint
+ * --------------------
+ *  Write a varint to a stream
+ *
+ *  f: stream
+ *  v: value to write
+ *
+ *  returns: the number of bytes written
+ */
+static int writeVarint(FILE* f, unsigned long long v) {
+  int bytes = 1;
+  while (v >= 0x80) {
+    fputc((int) ((v & 0x7F) | 0x80), f);
+    v >>= 7;
+    bytes++;
+  }
+  fputc((int) v, f);
+  return bytes;
+}
+
+
+
+/*
+ * Function readVarint
+ * -------------------
+ *  Read a varint from a stream
+ *
+ *  f: stream
+ *  v: where to store the value
+ *
+ *  returns: 0 on success, -1 at the end of the stream
+ */
+static int readVarint(FILE* f, unsigned long long* v) {
+  int c, shift = 0;
+  *v = 0;
+  do {
+    if ((c = fgetc(f)) == EOF || shift > 63) {
+      return -1;
+    }
+    *v |= (unsigned long long) (c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return 0;
+}
+
+
+
+/*
+ * Function getVarint
+ * ------------------
+ *  Read a varint from a payload
+ *
+ *  p: pointer to the first byte of the payload
+ *  len: length of the payload
+ *  pos: position to read from, advanced past the varint
+ *  v: where to store the value
+ *
+ *  returns: 0 on success, -1 past the end of the payload
+ */
+static inline int getVarint(const unsigned char* restrict p, const size_t len,
+                            size_t* pos, unsigned long long* v) {
+  int shift = 0;
+  unsigned char c;
+  *v = 0;
+  do {
+    if (*pos >= len || shift > 63) {
+      return -1;
+    }
+    c = p[(*pos)++];
+    *v |= (unsigned long long) (c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// First bytes of a generation stream
+#define DELTA_MAGIC "GOLD"
+
+/*
+ * Structure delta
+ * ---------------
+ *  Writer of a delta-encoded generation stream. The stream starts with the
+ *  magic, n, m and the keyframe interval (varints), followed by one frame per
+ *  generation: generation (varint), kind (1 keyframe, 0 delta), payload
+ *  length (varint) and payload. The payload lists the rows that differ from
+ *  the previous generation (from the empty board for keyframes) as the gap
+ *  since the last listed row plus either the runs of changed cells, each run
+ *  as the gap since the end of the last run plus one and its length, all
+ *  varints, ended by a zero; or a zero followed by the (m+7)/8 bytes of the
+ *  bit mask of changed cells. A zero row gap ends the payload
+ *
+ *  f: stream the frames are written to
+ *  interval: a keyframe is written every interval generations
+ *  key: whether the frame being built is a keyframe
+ *  buf, len, cap: payload of the frame being built
+ *  lastRow: last row listed in the frame being built
+ *  mask: changed cells of the row being encoded, one bit per cell
+ *  frames, keyframes, bytes: totals written so far
+ */
+typedef struct delta {
+  FILE* f;
+  int n, m;
+  int interval;
+  int key;
+  unsigned char* buf;
+  size_t len, cap;
+  int lastRow;
+  unsigned long long* mask;
+  long long frames, keyframes, bytes;
+} delta_t;
+
+int deltaOpen(delta_t* restrict dl, const char* path, const int n,
+              const int m, const int interval);
+void deltaBegin(delta_t* restrict dl, const int gen);
+void deltaRow(delta_t* restrict dl, const char* restrict prev,
+              const char* restrict row, const int m, const int i);
+void deltaEnd(delta_t* restrict dl, const int gen);
+void deltaClose(delta_t* restrict dl);
+int deltaReadHeader(FILE* f, int* n, int* m, int* interval);
+int deltaReadFrame(FILE* f, int* gen, int* key, unsigned char** payload,
+                   size_t* len);
+int deltaApply(const unsigned char* restrict payload, const size_t len,
+               char** restrict mat, const int n, const int m);
+
+#endif
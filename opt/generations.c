@@ -0,0 +1,465 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include "generations.h"
+
+
+// Forward declaration of static methods
+static void evolveBand(const gens_t* restrict g,
+                       const unsigned long long* restrict cur,
+                       unsigned long long* restrict next, const int i0,
+                       const int i1, unsigned long long* restrict rows);
+static inline void evolveBandBits(const gens_t* restrict g,
+                                  const unsigned long long* restrict cur,
+                                  unsigned long long* restrict next,
+                                  const int i0, const int i1,
+                                  unsigned long long* restrict rows,
+                                  const int bits);
+static inline void sumRow(const unsigned long long* restrict row,
+                          unsigned long long* restrict h, const int words,
+                          const int bits, const int m);
+static inline void evolveRow(const unsigned long long* restrict up,
+                             const unsigned long long* restrict mid,
+                             const unsigned long long* restrict down,
+                             const unsigned long long* restrict row,
+                             unsigned long long* restrict out,
+                             const gens_t* restrict g, const int bits);
+static inline unsigned long long aliveWord(const unsigned long long* restrict
+                                           row, const int words,
+                                           const int bits, const int w);
+static inline unsigned long long matchField(const unsigned long long s0,
+                                            const unsigned long long s1,
+                                            const unsigned long long s2,
+                                            const unsigned long long s3,
+                                            const unsigned set);
+static int cellState(const gens_t* restrict g, const int i, const int j);
+
+
+
+/*
+ * Function gensParseRule
+ * ----------------------
+ *  Parse a rule in B/S/C notation, e.g. B2/S/C3 (Brian's Brain) or
+ *  B2/S345/C4 (Star Wars). C is the number of states (2 if omitted, which is
+ *  a plain life-like rule)
+ *
+ *  rule: rule string
+ *  born: pointer to the birth counts (bit c set for c neighbors)
+ *  survive: pointer to the survival counts
+ *  states: pointer to the number of states
+ *
+ *  returns: 0 on success, -1 if the rule is not valid
+ */
+int gensParseRule(const char* rule, unsigned* born, unsigned* survive,
+                  int* states) {
+  unsigned* set = NULL;
+  const char* c;
+  *born = *survive = 0;
+  *states = 2;
+  for (c = rule; *c != '\0'; c++) {
+    const char t = toupper(*c);
+    if (t == 'B') {
+      set = born;
+    } else if (t == 'S') {
+      set = survive;
+    } else if (t == 'C') {
+      *states = atoi(c+1);
+      while (isdigit(c[1])) c++;
+      set = NULL;
+    } else if (t == '/') {
+      set = NULL;
+    } else if (set != NULL && *c >= '0' && *c <= '8') {
+      *set |= 1u << (*c - '0');
+    } else {
+      return -1;
+    }
+  }
+  // Births with no neighbors would fill the whole torus at once
+  if (*states < 2 || *states > GENS_MAX_STATES || (*born & 1)) {
+    return -1;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function gensInit
+ * -----------------
+ *  Create a multi-state torus with every cell dead
+ *
+ *  g: pointer to the torus to initialize
+ *  n: number of rows of the torus
+ *  m: number of columns of the torus
+ *  born, survive, states: rule (see gensParseRule)
+ */
+void gensInit(gens_t* restrict g, const int n, const int m,
+              const unsigned born, const unsigned survive, const int states) {
+  g->n = n;
+  g->m = m;
+  g->states = states;
+  g->bits = states <= 4 ? 2 : 4;
+  g->words = (m + 63) / 64;
+  g->born = born;
+  g->survive = survive;
+  const size_t rowWords = (size_t) g->bits * g->words;
+  g->cells = (unsigned long long*) calloc(n * rowWords,
+                                          sizeof(unsigned long long));
+  g->next = (unsigned long long*) calloc(n * rowWords,
+                                         sizeof(unsigned long long));
+  g->rows = (unsigned long long*) malloc(6 * g->words
+                                         * sizeof(unsigned long long));
+}
+
+
+
+/*
+ * Function gensLoadRow
+ * --------------------
+ *  Set one row of a multi-state torus from a row of dead and alive cells, so
+ *  a board can be loaded without holding it a byte per cell
+ *
+ *  g: pointer to the torus
+ *  i: index of the row
+ *  row: pointer to the first element of the row (0 dead, 1 alive)
+ */
+void gensLoadRow(gens_t* restrict g, const int i, const char* restrict row) {
+  unsigned long long* restrict planes = g->cells
+                                        + (size_t) i * g->bits * g->words;
+  int j, p;
+  for (p = 0; p < g->bits; p++) {
+    for (j = 0; j < g->words; j++) {
+      planes[p * g->words + j] = 0;
+    }
+  }
+  for (j = 0; j < g->m; j++) {
+    planes[j / 64] |= (unsigned long long) (row[j] != 0) << (j % 64);
+  }
+}
+
+
+
+/*
+ * Function gensEvolve
+ * -------------------
+ *  Evolve a multi-state torus for a given number of iterations
+ *
+ *  g: pointer to the torus
+ *  nSteps: number of iterations
+ */
+void gensEvolve(gens_t* restrict g, const int nSteps) {
+  int k;
+  for (k = 0; k < nSteps; k++) {
+    evolveBand(g, g->cells, g->next, 0, g->n, g->rows);
+
+    // Make cells point to next and next point to cells
+    unsigned long long* restrict tmp = g->cells;
+    g->cells = g->next;
+    g->next = tmp;
+  }
+}
+
+
+
+/*
+ * Function gensCount
+ * ------------------
+ *  Count the cells of a multi-state torus in every state
+ *
+ *  g: pointer to the torus
+ *  counts: array of g->states elements to fill
+ */
+void gensCount(const gens_t* restrict g, long long* restrict counts) {
+  int i, j;
+  for (i = 0; i < g->states; i++) {
+    counts[i] = 0;
+  }
+  for (i = 0; i < g->n; i++) {
+    for (j = 0; j < g->m; j++) {
+      counts[cellState(g, i, j)]++;
+    }
+  }
+}
+
+
+
+/*
+ * Function gensPrint
+ * ------------------
+ *  Print the states of a multi-state torus to console
+ *
+ *  g: pointer to the torus
+ */
+void gensPrint(const gens_t* restrict g) {
+  int i, j;
+  for (i = 0; i < g->n; i++) {
+    printf("[ ");
+    for (j = 0; j < g->m; j++) {
+      printf("%d ", cellState(g, i, j));
+    }
+    printf("]\n");
+  }
+}
+
+
+
+/*
+ * Function gensFree
+ * -----------------
+ *  Free memory occupied by a multi-state torus
+ *
+ *  g: pointer to the torus
+ */
+void gensFree(gens_t* restrict g) {
+  free(g->cells);
+  free(g->next);
+  free(g->rows);
+  g->cells = g->next = g->rows = NULL;
+}
+
+
+
+/*
+ * Function evolveBand
+ * -------------------
+ *  Compute the next generation of the rows [i0, i1) of a multi-state torus,
+ *  with the kernel for its number of bits per cell
+ *
+ *  g: pointer to the torus
+ *  cur: pointer to the first word of the current generation
+ *  next: pointer to the first word of the next generation
+ *  i0, i1: first (inclusive) and last (exclusive) row
+ *  rows: scratch of 6 * g->words words
+ */
+static void evolveBand(const gens_t* restrict g,
+                       const unsigned long long* restrict cur,
+                       unsigned long long* restrict next, const int i0,
+                       const int i1, unsigned long long* restrict rows) {
+  if (g->bits == 2) {
+    evolveBandBits(g, cur, next, i0, i1, rows, 2);
+  } else {
+    evolveBandBits(g, cur, next, i0, i1, rows, 4);
+  }
+}
+
+
+
+/*
+ * Function evolveBandBits
+ * -----------------------
+ *  Compute the next generation of the rows [i0, i1) of a multi-state torus.
+ *  The horizontal sums of alive cells of every row are computed once and
+ *  kept in a ring of three scratch rows
+ *
+ *  g: pointer to the torus
+ *  cur: pointer to the first word of the current generation
+ *  next: pointer to the first word of the next generation
+ *  i0, i1: first (inclusive) and last (exclusive) row
+ *  rows: scratch of 6 * g->words words
+ *  bits: bits per cell (a constant, so every call gets its own kernel)
+ */
+static inline void evolveBandBits(const gens_t* restrict g,
+                                  const unsigned long long* restrict cur,
+                                  unsigned long long* restrict next,
+                                  const int i0, const int i1,
+                                  unsigned long long* restrict rows,
+                                  const int bits) {
+  const int n = g->n, words = g->words;
+  const size_t rowWords = (size_t) bits * words;
+  int i;
+  sumRow(cur + (i0 == 0 ? n-1 : i0-1) * rowWords, rows, words, bits, g->m);
+  sumRow(cur + i0 * rowWords, rows + 2*words, words, bits, g->m);
+  for (i = i0; i < i1; i++) {
+    const int k = i - i0;
+    sumRow(cur + (i == n-1 ? 0 : i+1) * rowWords,
+           rows + (k+2) % 3 * 2*words, words, bits, g->m);
+    evolveRow(rows + k % 3 * 2*words, rows + (k+1) % 3 * 2*words,
+              rows + (k+2) % 3 * 2*words, cur + i * rowWords,
+              next + i * rowWords, g, bits);
+  }
+}
+
+
+
+/*
+ * Function sumRow
+ * ---------------
+ *  Add every alive cell of a row to its left and right neighbors (torus
+ *  wrap included), 64 cells per word: h holds bit 0 of the sums in its first
+ *  words words and bit 1 in the next ones
+ *
+ *  row: pointer to the first plane of the row
+ *  h: pointer to the 2 * words words of the sums
+ *  words: words per plane
+ *  bits: bits per cell
+ *  m: number of columns
+ */
+static inline void sumRow(const unsigned long long* restrict row,
+                          unsigned long long* restrict h, const int words,
+                          const int bits, const int m) {
+  const int pos = (m-1) % 64;  // Bit of the last cell in the last word
+  const unsigned long long first = aliveWord(row, words, bits, 0) & 1;
+  unsigned long long carry = (aliveWord(row, words, bits, words-1) >> pos) & 1;
+  unsigned long long a = aliveWord(row, words, bits, 0);
+  int w;
+  for (w = 0; w < words; w++) {
+    const unsigned long long next = w+1 < words
+                                    ? aliveWord(row, words, bits, w+1) : 0;
+    const unsigned long long l = (a << 1) | carry;
+    const unsigned long long r = (a >> 1)
+                                 | (w+1 < words ? next << 63 : first << pos);
+    h[w] = l ^ a ^ r;
+    h[words + w] = (l & a) | (r & (l ^ a));
+    carry = a >> 63;
+    a = next;
+  }
+}
+
+
+
+/*
+ * Function evolveRow
+ * ------------------
+ *  Compute the next states of one row of a multi-state torus from the
+ *  horizontal sums of the rows above, itself and below. The four bits of
+ *  the field (alive neighbors + the cell itself) are formed with bitwise
+ *  adders, and the births, survivals and decays of 64 cells are resolved
+ *  at once per word
+ *
+ *  up, mid, down: horizontal sums of the three rows (see sumRow)
+ *  row: pointer to the first plane of the current row
+ *  out: pointer to the first plane of the next row
+ *  g: pointer to the torus
+ *  bits: bits per cell
+ */
+static inline void evolveRow(const unsigned long long* restrict up,
+                             const unsigned long long* restrict mid,
+                             const unsigned long long* restrict down,
+                             const unsigned long long* restrict row,
+                             unsigned long long* restrict out,
+                             const gens_t* restrict g, const int bits) {
+  const int words = g->words;
+  const int states = g->states;
+  // Alive cells count themselves in the field
+  const unsigned born = g->born, survive = g->survive << 1;
+  const unsigned long long last = g->m % 64 == 0 ? ~0ULL
+                                  : (1ULL << (g->m % 64)) - 1;
+  int w, p;
+  for (w = 0; w < words; w++) {
+    // Field = up + mid + down, each 0 to 3
+    const unsigned long long u0 = up[w], u1 = up[words + w];
+    const unsigned long long m0 = mid[w], m1 = mid[words + w];
+    const unsigned long long d0 = down[w], d1 = down[words + w];
+    const unsigned long long s0 = u0 ^ m0 ^ d0;
+    const unsigned long long c0 = (u0 & m0) | (d0 & (u0 ^ m0));
+    const unsigned long long t = u1 ^ m1 ^ d1;
+    const unsigned long long cc = (u1 & m1) | (d1 & (u1 ^ m1));
+    const unsigned long long s1 = t ^ c0;
+    const unsigned long long c1 = t & c0;
+    const unsigned long long s2 = cc ^ c1;
+    const unsigned long long s3 = cc & c1;
+
+    // Current state
+    unsigned long long hi = 0;
+    for (p = 1; p < bits; p++) {
+      hi |= row[p*words + w];
+    }
+    const unsigned long long lo = row[w];
+    const unsigned long long alive = lo & ~hi;
+    const unsigned long long dead = ~(lo | hi);
+
+    // Cells that are alive next, and cells that move to the next state
+    const unsigned long long one = (dead & matchField(s0, s1, s2, s3, born))
+                                   | (alive
+                                      & matchField(s0, s1, s2, s3, survive));
+    const unsigned long long keep = ~dead & ~one;
+    unsigned long long inc[4];
+    unsigned long long carry = ~0ULL, wrap = states < (1 << bits) ? ~0ULL : 0;
+    for (p = 0; p < bits; p++) {
+      const unsigned long long c = row[p*words + w];
+      inc[p] = c ^ carry;
+      carry &= c;
+      wrap &= (states >> p) & 1 ? inc[p] : ~inc[p];
+    }
+    const unsigned long long mask = w == words-1 ? last : ~0ULL;
+    out[w] = ((keep & ~wrap & inc[0]) | one) & mask;
+    for (p = 1; p < bits; p++) {
+      out[p*words + w] = keep & ~wrap & inc[p] & mask;
+    }
+  }
+}
+
+
+
+/*
+ * Function aliveWord
+ * ------------------
+ *  Find the alive cells (state 1) of one word of a row
+ *
+ *  row: pointer to the first plane of the row
+ *  words: words per plane
+ *  bits: bits per cell
+ *  w: index of the word
+ *
+ *  returns: a word with the bits of the alive cells set
+ */
+static inline unsigned long long aliveWord(const unsigned long long* restrict
+                                           row, const int words,
+                                           const int bits, const int w) {
+  unsigned long long hi = 0;
+  int p;
+  for (p = 1; p < bits; p++) {
+    hi |= row[p*words + w];
+  }
+  return row[w] & ~hi;
+}
+
+
+
+/*
+ * Function matchField
+ * -------------------
+ *  Find the cells whose field is in a set
+ *
+ *  s0, s1, s2, s3: bits of the fields of 64 cells
+ *  set: bit c set if field c is in the set
+ *
+ *  returns: a word with the bits of the matching cells set
+ */
+static inline unsigned long long matchField(const unsigned long long s0,
+                                            const unsigned long long s1,
+                                            const unsigned long long s2,
+                                            const unsigned long long s3,
+                                            const unsigned set) {
+  unsigned long long r = 0;
+  int c;
+  for (c = 0; c <= 9; c++) {
+    if ((set >> c) & 1) {
+      r |= (c & 1 ? s0 : ~s0) & (c & 2 ? s1 : ~s1)
+           & (c & 4 ? s2 : ~s2) & (c & 8 ? s3 : ~s3);
+    }
+  }
+  return r;
+}
+
+
+
+/*
+ * Function cellState
+ * ------------------
+ *  Read the state of one cell of a multi-state torus
+ *
+ *  g: pointer to the torus
+ *  i, j: row and column of the cell
+ *
+ *  returns: the state of the cell
+ */
+static int cellState(const gens_t* restrict g, const int i, const int j) {
+  const unsigned long long* restrict row = g->cells
+                                           + (size_t) i * g->bits * g->words;
+  int p, s = 0;
+  for (p = 0; p < g->bits; p++) {
+    s |= (int) ((row[p * g->words + j / 64] >> (j % 64)) & 1) << p;
+  }
+  return s;
+}
@@ -1,18 +1,73 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include "adaptive.h"
+#include "alloc.h"
+#include "cone.h"
+#include "delta.h"
+#include "generations.h"
 #include "gol.h"
+#include "hash.h"
+#include "incremental.h"
+#include "noise.h"
+#include "plane.h"
+#include "ring.h"
+#include "roofline.h"
+#include "stats.h"
 #include "utils.h"
 
 
 
 // Static function declarations
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field);
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts);
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, unsigned long long* restrict hash,
+                       stats_t* restrict st, delta_t* restrict stream,
+                       char* restrict colSum, const noise_t* restrict noise,
+                       const int gen);
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              unsigned long long* restrict hash,
+                              stats_t* restrict st, delta_t* restrict stream,
+                              char* restrict colSum, char* restrict rows);
+static inline void fixedGeneration(char** restrict cur, char** restrict next,
+                                   const int n, const int m);
+static kernel_t selectKernel(const int n, const int m);
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m);
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum);
+static inline char decide(const char alive, const char field);
+static void rewindReport(ring_t* restrict rg, const int n, const int m,
+                         const int nSteps, const int back, const int debug,
+                         const noise_t* restrict noise);
+static char** rewindTo(ring_t* restrict rg, const int gen,
+                       char** restrict a, char** restrict b, const int n,
+                       const int m, const noise_t* restrict noise);
+static int compareDoubles(const void* a, const void* b);
 
 
-char** restrict state; // State at even times (0, 2, 4, etc.)
-char** restrict other; // State at odd times (1, 3, 5, etc.)
+char** restrict state; // Current state
+char** restrict other; // Scratch buffer for the next state
+
+
+// Kernels specialized at compile time for the board sizes of FIXED_SIZES,
+// a list of SIZE(n, m) set by the Makefile (make SIZES="4096x4096 ...")
+#ifdef FIXED_SIZES
+#define SIZE(N, M) \
+  static void generation_##N##_##M(char** restrict cur, \
+                                   char** restrict next) { \
+    fixedGeneration(cur, next, N, M); \
+  }
+FIXED_SIZES
+#undef SIZE
+#endif
 
 
 
@@ -22,8 +77,63 @@ int main(int argc, char const *argv[]) {
   double t1 = get_wall_seconds();
   
   // Check that arguments are provided
-  if (argc != 7) {
-    printf("Usage: %s n m prob nSteps seed debug\n", argv[0]);
+  options_t opts;
+  if (argc < 7 || parseOptions(argc, argv, &opts) != 0) {
+    printf("Usage: %s n m prob nSteps seed debug [options]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -unbounded  evolve on the infinite plane instead of the n x m torus\n");
+    printf("  -cycles     stop computing once the board repeats itself\n");
+    printf("  -alloc mode grid allocation: legacy (one malloc per row), aligned\n"
+           "              (default), huge (MAP_HUGETLB) or thp (madvise)\n");
+    printf("  -stats file write population, births, deaths and bounding box of every\n"
+           "              generation to file (not with -cycles)\n");
+    printf("  -separable  compute neighbor counts from vertical column sums reused by a\n"
+           "              horizontal sliding window\n");
+    printf("  -inplace    update a single grid in place with a few rolling rows instead\n"
+           "              of a second grid (half the memory)\n");
+    printf("  -footprint  report peak RSS and cell updates per second\n");
+    printf("  -roofline   measure the memory bandwidth and integer throughput of the\n"
+           "              host and report the run against them (not with -unbounded)\n");
+    printf("  -generic    always use the generic kernel, even for the board sizes with a\n"
+           "              specialized one (see SIZES in the Makefile)\n");
+    printf("  -delta file interval\n"
+           "              write every generation to file as XOR deltas against the\n"
+           "              previous one, with a keyframe every interval generations\n"
+           "              (read it back with ./decode); not with -cycles\n");
+    printf("  -rule rule  run a multi-state Generations rule in B/S/C notation, e.g.\n"
+           "              B2/S/C3 (Brian's Brain) or B2/S345/C4 (Star Wars), with 2 or\n"
+           "              4 bits per cell; only combinable with -footprint\n");
+    printf("  -rewind kB interval step\n"
+           "              keep the last kB kilobytes of history as a checkpoint every\n"
+           "              step generations, every interval-th a keyframe and the others\n"
+           "              XOR deltas, and report how fast earlier generations are\n"
+           "              restored (not with -unbounded or -cycles)\n");
+    printf("  -back gen   restore generation gen from the -rewind history after the run\n"
+           "              and print it (debug) or its population\n");
+    printf("  -query gen i j h w\n"
+           "              compute the h x w region at row i, column j of generation gen\n"
+           "              from its light cone instead of evolving the whole board; may be\n"
+           "              given up to %d times (overlapping cones are shared), only\n"
+           "              combinable with -alloc\n", CONE_MAX_QUERIES);
+    printf("  -noise pb ps\n"
+           "              stochastic Life: births happen with probability pb and\n"
+           "              survivals with probability ps, drawn per cell from a\n"
+           "              counter-based generator keyed by (seed, generation, cell), so\n"
+           "              runs match across backends and thread counts; not with\n"
+           "              -unbounded, -cycles, -separable, -inplace, -rule or -query\n");
+    printf("  -adaptive   switch between a dense, a tiled (active tiles only) and a\n"
+           "              sparse (live cell list) engine as the population and\n"
+           "              activity change, logging every switch; only combinable with\n"
+           "              -alloc and -footprint\n");
+    printf("  -incremental\n"
+           "              keep the neighbor counts of every cell and update only those\n"
+           "              around the cells that flipped, evaluating only the cells\n"
+           "              whose count or state changed (cost follows the activity, not\n"
+           "              the area); only combinable with -alloc, -footprint and -hash\n");
+    printf("  -hash every print the hash of generation 0, of every generation multiple\n"
+           "              of every (0 for none) and of the final one, to compare the\n"
+           "              backends (see results/verify.py); not with -unbounded,\n"
+           "              -cycles, -rule or -query, only 0 with -adaptive\n");
     return -1;
   }
 
@@ -43,18 +153,64 @@ int main(int argc, char const *argv[]) {
   }
 
   // Initialize arbitrary seed for random numbers (or not!)
-  if (seed < 0) {
-    srand(time(NULL));
-  } else {
-    srand((unsigned int) seed);
+  const unsigned long long key = seed < 0 ? (unsigned long long) time(NULL)
+                                          : (unsigned long long) seed;
+
+  // Multi-state rules have their own storage, filled one row at a time
+  if (opts.rule != NULL) {
+    gens_t g;
+    int i;
+    long long counts[GENS_MAX_STATES];
+    char* row = (char*) malloc(m * sizeof(char));
+    gensInit(&g, n, m, opts.born, opts.survive, opts.states);
+    for (i = 0; i < n; i++) {
+      createInitialRow(row, m, prob, key, i);
+      gensLoadRow(&g, i, row);
+    }
+    free(row);
+
+    if (debug) {
+      printf("Initial state:\n");
+      gensPrint(&g);
+    }
+
+    double t2 = get_wall_seconds();
+    gensEvolve(&g, nSteps);
+    t2 = get_wall_seconds() - t2;
+
+    if (debug) {
+      printf("Final state:\n");
+      gensPrint(&g);
+    }
+    gensCount(&g, counts);
+    fprintf(stderr, "Generations: rule %s, %d states, %d bits per cell, "
+            "%lld alive, %lld refractory\n", opts.rule, g.states, g.bits,
+            counts[1], (long long) n * m - counts[0] - counts[1]);
+    if (opts.footprint) {
+      fprintf(stderr, "Footprint: %d bits per cell, peak RSS %ld kB, %.3e "
+              "cell updates per second\n", g.bits, get_peak_rss(),
+              (double) n * m * nSteps / t2);
+    }
+    gensFree(&g);
+
+    t1 = get_wall_seconds() - t1;
+    if (debug) {
+      printf("Execution took %lf seconds\n", t1);
+    } else {
+      printf("%lf\n", t1);
+    }
+    return 0;
   }
 
   // Initialize data structures
+  if (opts.alloc >= 0) {
+    setAllocMode(opts.alloc);
+  }
   state = allocateMatrix(n, m);
-  other = allocateMatrix(n, m);
+  other = opts.inPlace || opts.incremental ? NULL : allocateMatrix(n, m);
 
   // Create initial state
-  createInitialState(state, n, m, prob);
+  createInitialState(state, n, m, prob, key);
 
   // Print initial state
   if (debug) {
@@ -62,8 +218,172 @@ int main(int argc, char const *argv[]) {
     printMatrix(state, n, m);
   }
 
+  // Queries are answered from the light cones of the initial board
+  if (opts.nQueries > 0) {
+    cone_t cn;
+    int q, r;
+    coneInit(&cn, state, n, m);
+    freeMatrix(state, n, m);
+    if (other != NULL) {
+      freeMatrix(other, n, m);
+    }
+
+    for (q = 0; q < opts.nQueries; q++) {
+      const query_t* qr = &opts.queries[q];
+      char* cells = (char*) malloc((size_t) qr->h * qr->w);
+      const long long before = cn.updates;
+      double t2 = get_wall_seconds();
+      const int full = coneQuery(&cn, qr, cells);
+      t2 = get_wall_seconds() - t2;
+      long long population = 0;
+      for (r = 0; r < qr->h * qr->w; r++) {
+        population += cells[r];
+      }
+      if (debug) {
+        char** rows = (char**) malloc(qr->h * sizeof(char*));
+        for (r = 0; r < qr->h; r++) {
+          rows[r] = cells + (size_t) r * qr->w;
+        }
+        printf("Generation %d, rows %d to %d, columns %d to %d:\n", qr->gen,
+               qr->i, qr->i + qr->h - 1, qr->j, qr->j + qr->w - 1);
+        printMatrix(rows, qr->h, qr->w);
+        free(rows);
+      }
+      fprintf(stderr, "Query %d: generation %d, %dx%d at (%d, %d), population "
+              "%lld, %s, %lld cell updates (%.2f%% of the whole board), %.3f "
+              "ms\n", q, qr->gen, qr->h, qr->w, qr->i, qr->j, population,
+              full ? "whole board" : "light cone", cn.updates - before,
+              qr->gen > 0 ? 100.0 * (cn.updates - before)
+                            / ((double) n * m * qr->gen) : 0.0, t2 * 1e3);
+      free(cells);
+    }
+    fprintf(stderr, "Light cones: %lld tiles memoized (%lld reused), %lld "
+            "cell updates\n", cn.tiles, cn.hits, cn.updates);
+    coneFree(&cn);
+    if (debug || opts.alloc >= 0) {
+      allocReport(stderr);
+    }
+
+    t1 = get_wall_seconds() - t1;
+    if (debug) {
+      printf("Execution took %lf seconds\n", t1);
+    } else {
+      printf("%lf\n", t1);
+    }
+    return 0;
+  }
+
+  // The unbounded mode has its own storage, seeded with the initial state
+  if (opts.unbounded) {
+    plane_t plane;
+    planeInit(&plane, state, n, m);
+    freeMatrix(state, n, m);
+    if (other != NULL) {
+      freeMatrix(other, n, m);
+    }
+
+    planeEvolve(&plane, nSteps);
+
+    if (debug) {
+      printf("Final state:\n");
+      planePrint(&plane);
+    }
+    fprintf(stderr, "Unbounded: population %lld, storage %dx%d, %d grows, "
+            "%d shifts, %lld cell updates\n", planePopulation(&plane),
+            plane.rows, plane.cols, plane.nGrows, plane.nShifts,
+            plane.updates);
+    planeFree(&plane);
+
+    t1 = get_wall_seconds() - t1;
+    if (debug) {
+      printf("Execution took %lf seconds\n", t1);
+    } else {
+      printf("%lf\n", t1);
+    }
+    return 0;
+  }
+
   // Evolve the system
-  evolve(n, m, nSteps);
+  history_t hist;
+  if (opts.cycles) {
+    historyInit(&hist, n, m);
+  }
+  FILE* series = NULL;
+  if (opts.stats != NULL && (series = fopen(opts.stats, "w")) == NULL) {
+    printf("Cannot create %s\n", opts.stats);
+    return -1;
+  }
+  delta_t stream;
+  if (opts.delta != NULL
+      && deltaOpen(&stream, opts.delta, n, m, opts.interval) != 0) {
+    printf("Cannot create %s\n", opts.delta);
+    return -1;
+  }
+  noise_t noise;
+  if (opts.noise) {
+    noiseInit(&noise, key, opts.pBirth, opts.pSurvive);
+  }
+  ring_t ring;
+  if (opts.rewind > 0) {
+    ringInit(&ring, n, m, opts.rewind, opts.rewindInterval, opts.rewindStep);
+  }
+  const kernel_t kernel = opts.generic ? NULL : selectKernel(n, m);
+  if (debug) {
+    fprintf(stderr, "Kernel: %s\n", opts.noise ? "stochastic"
+            : opts.separable ? "separable"
+            : kernel != NULL ? "specialized" : "generic");
+  }
+  adaptive_t ad;
+  incremental_t inc;
+  double t2 = get_wall_seconds();
+  if (opts.adaptive) {
+    if (opts.hash >= 0) {
+      hashReport(0, hashMatrix(state, n, m));
+    }
+    adaptiveInit(&ad, n, m, stderr);
+    if (adaptiveEvolve(&ad, state, other, nSteps) != state) {
+      char** restrict tmp = state;
+      state = other;
+      other = tmp;
+    }
+    if (opts.hash >= 0) {
+      hashReport(nSteps, hashMatrix(state, n, m));
+    }
+  } else if (opts.incremental) {
+    incrementalInit(&inc, state, n, m);
+    incrementalEvolve(&inc, state, nSteps, opts.hash);
+  } else {
+    evolve(n, m, nSteps, opts.cycles ? &hist : NULL, series,
+           opts.delta != NULL ? &stream : NULL,
+           opts.rewind > 0 ? &ring : NULL, opts.noise ? &noise : NULL,
+           kernel, opts.separable, opts.hash);
+  }
+  t2 = get_wall_seconds() - t2;
+  const double updates = (double) n * m * nSteps;
+  if (opts.footprint) {
+    fprintf(stderr, "Footprint: %s, peak RSS %ld kB, %.3e cell updates per "
+            "second\n", opts.incremental ? "incremental"
+                        : opts.inPlace ? "in place" : "two grids",
+            get_peak_rss(), updates / t2);
+  }
+  if (opts.cycles) {
+    historyReport(&hist);
+    historyFree(&hist);
+  }
+  if (opts.adaptive) {
+    adaptiveReport(&ad, stderr);
+    adaptiveFree(&ad);
+  }
+  if (opts.incremental) {
+    incrementalReport(&inc, stderr);
+    incrementalFree(&inc);
+  }
+  if (series != NULL) {
+    fclose(series);
+  }
+  if (opts.delta != NULL) {
+    deltaClose(&stream);
+  }
 
   // Print final state
   if (debug) {
@@ -71,9 +391,23 @@ int main(int argc, char const *argv[]) {
     printMatrix(state, n, m);
   }
 
+  // Step back through the history
+  if (opts.rewind > 0) {
+    rewindReport(&ring, n, m, nSteps, opts.back, debug,
+                 opts.noise ? &noise : NULL);
+    ringFree(&ring);
+  }
+
   // Free data structures
   freeMatrix(state, n, m);
-  freeMatrix(other, n, m);
+  if (other != NULL) {
+    freeMatrix(other, n, m);
+  }
+
+  // Report how the grids were allocated
+  if (debug || opts.alloc >= 0) {
+    allocReport(stderr);
+  }
 
   // Print time it took to run the code
   t1 = get_wall_seconds() - t1;
@@ -83,171 +417,681 @@ int main(int argc, char const *argv[]) {
     printf("%lf\n", t1);
   }
 
+  // Compare the evolution with the ceilings of the host. Bytes per update
+  // are the read of the current cell and the write of the next one (rows
+  // around it are in cache); operations per update are the eight additions
+  // of the field plus the two comparisons and selections of decide, or two
+  // plus two additions with column sums
+  if (opts.roofline) {
+    machine_t mc;
+    machineMeasure(&mc);
+    rooflineReport(stderr, &mc, opts.separable ? "separable"
+                   : opts.inPlace ? "in-place"
+                   : kernel != NULL ? "specialized" : "generic",
+                   2, opts.separable ? 8 : 12, updates, t2);
+  }
+
   return 0;
 }
 
 
 
 /*
- * Function evolve
- * ---------------
- *  Evolve the game state for a given number of iterations
+ * Function parseOptions
+ * ---------------------
+ *  Parse the optional flags given after the positional arguments
  *
- *  n: number of rows of the matrix
- *  m: number of columns of the matrix
- *  nSteps: number of iterations (assumed to be even)
+ *  argc: number of command line arguments
+ *  argv: command line arguments
+ *  opts: pointer to the structure to fill
+ *
+ *  returns: 0 on success, -1 if an option is not recognized
  */
-void evolve(const int n, const int m, const int nSteps) {
-  int k, i, j;
-  char field;
-  for (k = 0; k < nSteps; k+=2) {
-
-    // FIRST ITERATION
-    {
-    // First row (i=0)
-      // First column (j=0)
-      field = state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                  + state[0][m-1] + state[0][0] + state[0][1]
-                  + state[1][m-1] + state[1][0] + state[1][1];
-      decide(state[0][0], other, 0, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = state[n-1][j-1] + state[n-1][j] + state[n-1][j+1]
-                    + state[0][j-1] + state[0][j] + state[0][j+1]
-                    + state[1][j-1] + state[1][j] + state[1][j+1];
-        decide(state[0][j], other, 0, j, field);
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts) {
+  int a;
+  opts->unbounded = 0;
+  opts->cycles = 0;
+  opts->alloc = -1;
+  opts->stats = NULL;
+  opts->separable = 0;
+  opts->inPlace = 0;
+  opts->footprint = 0;
+  opts->roofline = 0;
+  opts->rule = NULL;
+  opts->delta = NULL;
+  opts->interval = 0;
+  opts->generic = 0;
+  opts->rewind = 0;
+  opts->rewindInterval = 0;
+  opts->rewindStep = 0;
+  opts->back = -1;
+  opts->nQueries = 0;
+  opts->noise = 0;
+  opts->adaptive = 0;
+  opts->hash = -1;
+  opts->incremental = 0;
+  for (a = 7; a < argc; a++) {
+    if (strcmp(argv[a], "-unbounded") == 0) {
+      opts->unbounded = 1;
+    } else if (strcmp(argv[a], "-cycles") == 0) {
+      opts->cycles = 1;
+    } else if (strcmp(argv[a], "-separable") == 0) {
+      opts->separable = 1;
+    } else if (strcmp(argv[a], "-inplace") == 0) {
+      opts->inPlace = 1;
+    } else if (strcmp(argv[a], "-footprint") == 0) {
+      opts->footprint = 1;
+    } else if (strcmp(argv[a], "-roofline") == 0) {
+      opts->roofline = 1;
+    } else if (strcmp(argv[a], "-adaptive") == 0) {
+      opts->adaptive = 1;
+    } else if (strcmp(argv[a], "-incremental") == 0) {
+      opts->incremental = 1;
+    } else if (strcmp(argv[a], "-alloc") == 0 && a+1 < argc) {
+      opts->alloc = parseAllocMode(argv[++a]);
+      if (opts->alloc < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-stats") == 0 && a+1 < argc) {
+      opts->stats = argv[++a];
+    } else if (strcmp(argv[a], "-rule") == 0 && a+1 < argc) {
+      opts->rule = argv[++a];
+      if (gensParseRule(opts->rule, &opts->born, &opts->survive,
+                        &opts->states) != 0) {
+        return -1;
       }
-      // Last column (j=m-1)
-      field = state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                  + state[0][m-2] + state[0][m-1] + state[0][0]
-                  + state[1][m-2] + state[1][m-1] + state[1][0];
-      decide(state[0][m-1], other, 0, m-1, field);
-
-    // Other rows (i=1 to n-2)
-    for (i = 1; i <= n-2; i++) {
-      // First column (j=0)
-      field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                  + state[i][m-1] + state[i][0] + state[i][1]
-                  + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-      decide(state[i][0], other, i, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                    + state[i][j-1] + state[i][j] + state[i][j+1]
-                    + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-        decide(state[i][j], other, i, j, field);
+    } else if (strcmp(argv[a], "-generic") == 0) {
+      opts->generic = 1;
+    } else if (strcmp(argv[a], "-delta") == 0 && a+2 < argc) {
+      opts->delta = argv[++a];
+      opts->interval = atoi(argv[++a]);
+      if (opts->interval <= 0) {
+        return -1;
       }
-      // Last column (j=m-1)
-      field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                  + state[i][m-2] + state[i][m-1] + state[i][0]
-                  + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-      decide(state[i][m-1], other, i, m-1, field);
-    }
-
-    // Last row (i=n-1)
-      // First column (j=0)
-      field = state[n-2][m-1] + state[n-2][0] + state[n-2][1]
-                  + state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                  + state[0][m-1] + state[0][0] + state[0][1];
-      decide(state[n-1][0], other, n-1, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = state[n-2][j-1] + state[n-2][j] + state[n-2][j+1]
-                    + state[n-1][j-1] + state[n-1][j]  + state[n-1][j+1]
-                    + state[0][j-1] + state[0][j] + state[0][j+1];
-        decide(state[n-1][j], other, n-1, j, field);
+    } else if (strcmp(argv[a], "-rewind") == 0 && a+3 < argc) {
+      const long kB = atol(argv[++a]);
+      opts->rewind = kB > 0 ? (size_t) kB * 1024 : 0;
+      opts->rewindInterval = atoi(argv[++a]);
+      opts->rewindStep = atoi(argv[++a]);
+      if (kB <= 0 || opts->rewindInterval <= 0 || opts->rewindStep <= 0) {
+        return -1;
       }
-      // Last column (j=m-1)
-      field = state[n-2][m-2] + state[n-2][m-1] + state[n-2][0]
-                  + state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                  + state[0][m-2] + state[0][m-1] + state[0][0];
-      decide(state[n-1][m-1], other, n-1, m-1, field);
-    }
-
-    // SECOND ITERATION
-    {
-    // First row (i=0)
-      // First column (j=0)
-      field = other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                  + other[0][m-1] + other[0][0] + other[0][1]
-                  + other[1][m-1] + other[1][0] + other[1][1];
-      decide(other[0][0], state, 0, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = other[n-1][j-1] + other[n-1][j] + other[n-1][j+1]
-                    + other[0][j-1] + other[0][j] + other[0][j+1]
-                    + other[1][j-1] + other[1][j] + other[1][j+1];
-        decide(other[0][j], state, 0, j, field);
+    } else if (strcmp(argv[a], "-query") == 0 && a+5 < argc
+               && opts->nQueries < CONE_MAX_QUERIES) {
+      query_t* q = &opts->queries[opts->nQueries++];
+      q->gen = atoi(argv[++a]);
+      q->i = atoi(argv[++a]);
+      q->j = atoi(argv[++a]);
+      q->h = atoi(argv[++a]);
+      q->w = atoi(argv[++a]);
+      if (q->gen < 0 || q->i < 0 || q->j < 0 || q->h <= 0 || q->w <= 0) {
+        return -1;
       }
-      // Last column (j=m-1)
-      field = other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                  + other[0][m-2] + other[0][m-1] + other[0][0]
-                  + other[1][m-2] + other[1][m-1] + other[1][0];
-      decide(other[0][m-1], state, 0, m-1, field);
-
-    // Other rows (i=1 to n-2)
-    for (i = 1; i <= n-2; i++) {
-      // First column (j=0)
-      field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                  + other[i][m-1] + other[i][0] + other[i][1]
-                  + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-      decide(other[i][0], state, i, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                    + other[i][j-1] + other[i][j] + other[i][j+1]
-                    + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-        decide(other[i][j], state, i, j, field);
+    } else if (strcmp(argv[a], "-noise") == 0 && a+2 < argc) {
+      opts->noise = 1;
+      opts->pBirth = atof(argv[++a]);
+      opts->pSurvive = atof(argv[++a]);
+      if (opts->pBirth < 0 || opts->pBirth > 1 || opts->pSurvive < 0
+          || opts->pSurvive > 1) {
+        return -1;
       }
-      // Last column (j=m-1)
-      field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                  + other[i][m-2] + other[i][m-1] + other[i][0]
-                  + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-      decide(other[i][m-1], state, i, m-1, field);
-    }
-
-    // Last row (i=n-1)
-      // First column (j=0)
-      field = other[n-2][m-1] + other[n-2][0] + other[n-2][1]
-                  + other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                  + other[0][m-1] + other[0][0] + other[0][1];
-      decide(other[n-1][0], state, n-1, 0, field);
-      // Other columns (j=1 to m-2)
-      for (j=1; j <= m - 2; j++) {
-        field = other[n-2][j-1] + other[n-2][j] + other[n-2][j+1]
-                    + other[n-1][j-1] + other[n-1][j]  + other[n-1][j+1]
-                    + other[0][j-1] + other[0][j] + other[0][j+1];
-        decide(other[n-1][j], state, n-1, j, field);
+    } else if (strcmp(argv[a], "-back") == 0 && a+1 < argc) {
+      opts->back = atoi(argv[++a]);
+      if (opts->back < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-hash") == 0 && a+1 < argc) {
+      opts->hash = atoi(argv[++a]);
+      if (opts->hash < 0) {
+        return -1;
+      }
+    } else {
+      return -1;
+    }
+  }
+  // The unbounded plane does not use the kernels of the model
+  if (opts->roofline && opts->unbounded) {
+    return -1;
+  }
+  // The stochastic rule only has the direct kernel on the torus
+  if (opts->noise && (opts->unbounded || opts->cycles || opts->separable
+                      || opts->inPlace || opts->rule != NULL
+                      || opts->nQueries > 0)) {
+    return -1;
+  }
+  // Queries replace the evolution
+  if (opts->nQueries > 0 && (opts->unbounded || opts->cycles
+                             || opts->stats != NULL || opts->separable
+                             || opts->inPlace || opts->footprint
+                             || opts->roofline || opts->delta != NULL
+                             || opts->rule != NULL || opts->rewind > 0)) {
+    return -1;
+  }
+  // The history is taken on the torus, one generation after another
+  if ((opts->rewind > 0 && (opts->unbounded || opts->cycles))
+      || (opts->back >= 0 && opts->rewind == 0)) {
+    return -1;
+  }
+  // The adaptive engine only has the Game of Life on the torus with two grids
+  if (opts->adaptive && (opts->unbounded || opts->cycles
+                         || opts->stats != NULL || opts->separable
+                         || opts->inPlace || opts->roofline
+                         || opts->delta != NULL || opts->rule != NULL
+                         || opts->rewind > 0 || opts->nQueries > 0
+                         || opts->noise)) {
+    return -1;
+  }
+  // The incremental engine only has the Game of Life on the torus
+  if (opts->incremental && (opts->unbounded || opts->cycles
+                            || opts->stats != NULL || opts->separable
+                            || opts->inPlace || opts->roofline
+                            || opts->delta != NULL || opts->rule != NULL
+                            || opts->rewind > 0 || opts->nQueries > 0
+                            || opts->noise || opts->adaptive
+                            || opts->generic)) {
+    return -1;
+  }
+  // The series holds every generation, which -cycles stops computing once
+  // the board repeats
+  if (opts->stats != NULL && opts->cycles) {
+    return -1;
+  }
+  // The deltas hold every generation, which -cycles stops computing once the
+  // board repeats
+  if (opts->delta != NULL && opts->cycles) {
+    return -1;
+  }
+  // Multi-state rules only have the plain torus evolution
+  if (opts->rule != NULL && (opts->unbounded || opts->cycles
+                             || opts->stats != NULL || opts->separable
+                             || opts->inPlace || opts->delta != NULL
+                             || opts->roofline || opts->rewind > 0)) {
+    return -1;
+  }
+  // Checkpoints are generations of the Game of Life actually computed on the
+  // whole torus; the adaptive engine only hands back the final state
+  if (opts->hash >= 0 && (opts->unbounded || opts->cycles
+                          || opts->rule != NULL || opts->nQueries > 0
+                          || (opts->adaptive && opts->hash > 0))) {
+    return -1;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function evolve
+ * ---------------
+ *  Evolve the game state for a given number of iterations
+ *
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nSteps: number of iterations
+ *  hist: pointer to the cycle detector, or NULL to evolve blindly. When the
+ *        board enters a cycle, only the generations needed to reach the
+ *        state at nSteps modulo the period are computed
+ *  series: stream where the statistics of every generation are written as a
+ *          time series, or NULL to skip them
+ *  stream: writer of the delta-encoded generations, or NULL to skip them
+ *  ring: snapshot ring taking a checkpoint every ring->step generations, or
+ *        NULL to keep no history
+ *  noise: stochastic rule, or NULL for the Game of Life
+ *  kernel: kernel specialized for the size of the board, or NULL. It is used
+ *          when no hashes, statistics, deltas nor noise are requested
+ *  separable: use the separable kernel (see evolveRowSeparable) instead
+ *  every: print the hash of generation 0, of every generation multiple of
+ *         every (if positive) and of the final one (see hashReport), or -1
+ *         to print none. Boards are hashed apart from the kernels, so the
+ *         specialized ones are checked too
+ *
+ *  When other is NULL the board is updated in place (see generationInPlace)
+ */
+void evolve(const int n, const int m, const int nSteps,
+            history_t* restrict hist, FILE* series, delta_t* restrict stream,
+            ring_t* restrict ring, const noise_t* restrict noise,
+            kernel_t kernel, const int separable, const int every) {
+  int k, i;
+  int last = nSteps;
+  unsigned long long hash;
+  stats_t st;
+  char** restrict tmp;
+  const int inPlace = other == NULL;
+  const int fixed = kernel != NULL && hist == NULL && series == NULL
+                    && stream == NULL && noise == NULL && !separable
+                    && !inPlace;
+  char* restrict colSum = separable ? (char*) malloc(m+2) : NULL;
+  char* restrict rows = inPlace ? (char*) malloc(3 * (size_t) m) : NULL;
+
+  statsInit(&st);
+
+  if (hist != NULL) {
+    historyStep(hist, hashMatrix(state, n, m), 0, state, n, m);
+  }
+  if (series != NULL) {
+    for (i = 0; i < n; i++) {
+      statsRow(&st, NULL, state[i], m, i);
+    }
+    statsWrite(series, 0, &st);
+  }
+  if (stream != NULL) {
+    deltaBegin(stream, 0);
+    for (i = 0; i < n; i++) {
+      deltaRow(stream, NULL, state[i], m, i);
+    }
+    deltaEnd(stream, 0);
+  }
+  if (ring != NULL) {
+    ringPush(ring, state, 0);
+  }
+  if (every >= 0) {
+    hashReport(0, hashMatrix(state, n, m));
+  }
+
+  for (k = 0; k < last; k++) {
+
+    const long long previous = st.population;
+    if (stream != NULL) deltaBegin(stream, k+1);
+    if (fixed) {
+      kernel(state, other);
+    } else if (inPlace) {
+      generationInPlace(state, n, m, hist != NULL ? &hash : NULL,
+                        series != NULL ? &st : NULL, stream, colSum, rows);
+    } else {
+      generation(state, other, n, m, hist != NULL ? &hash : NULL,
+                 series != NULL ? &st : NULL, stream, colSum, noise, k);
+    }
+    if (stream != NULL) deltaEnd(stream, k+1);
+    if (series != NULL) {
+      statsFinish(&st, previous);
+      statsWrite(series, k+1, &st);
+    }
+
+    // Make state point to other and other point to state
+    if (!inPlace) {
+      tmp = state;
+      state = other;
+      other = tmp;
+    }
+    if (ring != NULL && (k+1) % ring->step == 0) {
+      ringPush(ring, state, k+1);
+    }
+    if (every >= 0 && (k+1 == nSteps || (every > 0 && (k+1) % every == 0))) {
+      hashReport(k+1, hashMatrix(state, n, m));
+    }
+
+    // Jump ahead once the board repeats itself
+    if (hist != NULL && hist->period == 0) {
+      const int period = historyStep(hist, hash, k+1, state, n, m);
+      if (period != 0) {
+        last = k+1 + (nSteps - (k+1)) % period;
       }
-      // Last column (j=m-1)
-      field = other[n-2][m-2] + other[n-2][m-1] + other[n-2][0]
-                  + other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                  + other[0][m-2] + other[0][m-1] + other[0][0];
-      decide(other[n-1][m-1], state, n-1, m-1, field);
     }
 
   }
+
+  free(colSum);
+  free(rows);
 }
 
 
+
+/*
+ * Function generation
+ * -------------------
+ *  Compute one generation of the torus
+ *
+ *  cur: pointer to the first element of the current state matrix
+ *  next: pointer to the first element of the future state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  hash: where to store the hash of the new generation (NULL to skip it)
+ *  st: where to store the statistics of the new generation (NULL to skip
+ *      them)
+ *  stream: writer that receives the changes of every row (NULL to skip them)
+ *  colSum: scratch row of m+2 elements for the separable kernel (NULL for the
+ *          direct one)
+ *  noise: stochastic rule (NULL for the Game of Life)
+ *  gen: generation of cur (keys the draws of the stochastic rule)
+ *
+ *  Hashes, statistics and deltas are taken from every row right after it is
+ *  computed, while it is still in cache
+ */
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, unsigned long long* restrict hash,
+                       stats_t* restrict st, delta_t* restrict stream,
+                       char* restrict colSum, const noise_t* restrict noise,
+                       const int gen) {
+  int i;
+  unsigned long long h = 0;
+
+  if (st != NULL) statsInit(st);
+
+  for (i = 0; i < n; i++) {
+    // Rows above and below, wrapping around the first and last rows
+    const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+    const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+    if (noise != NULL) {
+      noiseRow(noise, gen, i, up, cur[i], down, next[i], m);
+    } else if (colSum != NULL) {
+      evolveRowSeparable(up, cur[i], down, next[i], m, colSum);
+    } else {
+      evolveRow(up, cur[i], down, next[i], m);
+    }
+    if (hash != NULL) h += hashRow(next[i], m, i);
+    if (st != NULL) statsRow(st, cur[i], next[i], m, i);
+    if (stream != NULL) deltaRow(stream, cur[i], next[i], m, i);
+  }
+
+  if (hash != NULL) *hash = h;
+}
+
+
+
+/*
+ * Function generationInPlace
+ * --------------------------
+ *  Compute one generation of the torus overwriting the current state. A new
+ *  row is computed into a scratch row and only written back once the next
+ *  row has been computed, since that one still needs the old version; the
+ *  new first row is held until the end, because the last row needs the old
+ *  one. Three scratch rows replace the second grid
+ *
+ *  mat: pointer to the first element of the state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  hash, st, stream, colSum: as in generation
+ *  rows: scratch space for three rows
+ */
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              unsigned long long* restrict hash,
+                              stats_t* restrict st, delta_t* restrict stream,
+                              char* restrict colSum, char* restrict rows) {
+  int i;
+  unsigned long long h = 0;
+  char* restrict first = rows;  // New first row
+  char* restrict pending[2] = {rows + m, rows + 2*m};  // New rows i-1 and i
+
+  if (st != NULL) statsInit(st);
+
+  for (i = 0; i < n; i++) {
+    const char* restrict up = i == 0 ? mat[n-1] : mat[i-1];
+    const char* restrict down = i == n-1 ? mat[0] : mat[i+1];
+    char* restrict out = i == 0 ? first : pending[i%2];
+    if (colSum != NULL) {
+      evolveRowSeparable(up, mat[i], down, out, m, colSum);
+    } else {
+      evolveRow(up, mat[i], down, out, m);
+    }
+    if (hash != NULL) h += hashRow(out, m, i);
+    if (st != NULL) statsRow(st, mat[i], out, m, i);
+    if (stream != NULL) deltaRow(stream, mat[i], out, m, i);
+    // The old row i-1 is not needed anymore
+    if (i >= 2) {
+      memcpy(mat[i-1], pending[(i-1)%2], m);
+    }
+  }
+  if (n >= 2) {
+    memcpy(mat[n-1], pending[(n-1)%2], m);
+  }
+  memcpy(mat[0], first, m);
+
+  if (hash != NULL) *hash = h;
+}
+
+
+
+/*
+ * Function fixedGeneration
+ * ------------------------
+ *  Compute one generation of the torus for a size known at compile time.
+ *  It is inlined into every specialized kernel with constant n and m, so
+ *  the row loops have constant trip counts and, for power-of-two heights,
+ *  the row wrap-around is a mask
+ *
+ *  cur: pointer to the first element of the current state matrix
+ *  next: pointer to the first element of the future state matrix
+ *  n: number of rows of the matrix (a constant)
+ *  m: number of columns of the matrix (a constant)
+ */
+static inline void fixedGeneration(char** restrict cur, char** restrict next,
+                                   const int n, const int m) {
+  const int pow2 = (n & (n-1)) == 0;
+  int i;
+  for (i = 0; i < n; i++) {
+    const int iUp = pow2 ? (i-1) & (n-1) : (i == 0 ? n-1 : i-1);
+    const int iDown = pow2 ? (i+1) & (n-1) : (i == n-1 ? 0 : i+1);
+    evolveRow(cur[iUp], cur[i], cur[iDown], next[i], m);
+  }
+}
+
+
+
+/*
+ * Function selectKernel
+ * ---------------------
+ *  Find the kernel specialized for a board size
+ *
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *
+ *  returns: the kernel, or NULL if the size has none (use the generic one)
+ */
+static kernel_t selectKernel(const int n, const int m) {
+#ifdef FIXED_SIZES
+#define SIZE(N, M) if (n == N && m == M) return generation_##N##_##M;
+  FIXED_SIZES
+#undef SIZE
+#endif
+  return NULL;
+}
+
+
+
+/*
+ * Function evolveRow
+ * ------------------
+ *  Compute the future state of one row of the torus
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ */
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m) {
+  int j;
+  char field;
+  // First column (j=0)
+  field = up[m-1] + up[0] + up[1]
+              + mid[m-1] + mid[0] + mid[1]
+              + down[m-1] + down[0] + down[1];
+  out[0] = decide(mid[0], field);
+  // Other columns (j=1 to m-2)
+  for (j = 1; j <= m - 2; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+                + mid[j-1] + mid[j] + mid[j+1]
+                + down[j-1] + down[j] + down[j+1];
+    out[j] = decide(mid[j], field);
+  }
+  // Last column (j=m-1)
+  field = up[m-2] + up[m-1] + up[0]
+              + mid[m-2] + mid[m-1] + mid[0]
+              + down[m-2] + down[m-1] + down[0];
+  out[m-1] = decide(mid[m-1], field);
+}
+
+
+/*
+ * Function evolveRowSeparable
+ * ---------------------------
+ *  Compute the future state of one row of the torus from column sums: the
+ *  three rows are first added vertically, once per column, and the field of
+ *  every cell is the sum of three neighboring column sums. That is three
+ *  loads per cell instead of nine, and both loops vectorize
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ *  colSum: scratch row of m+2 elements
+ */
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum) {
+  int j;
+  // Column sums, shifted by one so the wrapped columns fit at both ends
+  for (j = 0; j < m; j++) {
+    colSum[j+1] = up[j] + mid[j] + down[j];
+  }
+  colSum[0] = colSum[m];
+  colSum[m+1] = colSum[1];
+  // Horizontal window over the column sums
+  for (j = 0; j < m; j++) {
+    out[j] = decide(mid[j], colSum[j] + colSum[j+1] + colSum[j+2]);
+  }
+}
+
+
+
 /*
  * Function decide
  * ---------------
  *  Decide wether a cell lives or dies
  *
  *  alive: current state of the cell
- *  future: pointer to the first element of the future state matrix
- *  i: index for row
- *  j: index for column
  *  field: number of alive neighbors + the cell itself
+ *
+ *  returns: the future state of the cell
  */
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field) {
+static inline char decide(const char alive, const char field) {
   if (field == 3) {
-    future[i][j] = 1;
+    return 1;
   } else if (field == 4) {
-    future[i][j] = alive;
+    return alive;
   } else {
-    future[i][j] = 0;
+    return 0;
+  }
+}
+
+
+
+/*
+ * Function rewindReport
+ * ---------------------
+ *  Restore generations spread over the window of a snapshot ring and report
+ *  the ring and how long restoring took. A generation restored on request is
+ *  printed (debug) or summarized by its population
+ *
+ *  rg: pointer to the ring
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  nSteps: generation the run ended at
+ *  back: generation to restore on request (-1 for none)
+ *  debug: whether to print the restored generation
+ *  noise: stochastic rule of the run (NULL for the Game of Life)
+ */
+static void rewindReport(ring_t* restrict rg, const int n, const int m,
+                         const int nSteps, const int back, const int debug,
+                         const noise_t* restrict noise) {
+  // Generations restored to measure the latency
+  const int maxSamples = 64;
+  const int first = ringFirst(rg);
+  const int span = nSteps - first + 1;
+  const int samples = span < maxSamples ? span : maxSamples;
+  double* latency = (double*) malloc(samples * sizeof(double));
+  char** restrict a = allocateMatrix(n, m);
+  char** restrict b = allocateMatrix(n, m);
+  int s;
+
+  for (s = 0; s < samples; s++) {
+    const int gen = first + (samples > 1 ? (int) ((long long) s * (span - 1)
+                                                  / (samples - 1)) : 0);
+    const double t = get_wall_seconds();
+    rewindTo(rg, gen, a, b, n, m, noise);
+    latency[s] = get_wall_seconds() - t;
+  }
+  qsort(latency, samples, sizeof(double), compareDoubles);
+  ringReport(rg, nSteps);
+  fprintf(stderr, "Rewind latency: min %.3f ms, median %.3f ms, max %.3f ms "
+          "over %d generations (at most %d evolved again)\n",
+          latency[0] * 1e3, latency[samples/2] * 1e3,
+          latency[samples-1] * 1e3, samples, rg->step - 1);
+
+  if (back >= 0) {
+    if (back < first || back > nSteps) {
+      fprintf(stderr, "Generation %d is outside the history (%d to %d)\n",
+              back, first, nSteps);
+    } else {
+      char** restrict mat = rewindTo(rg, back, a, b, n, m, noise);
+      long long population = 0;
+      int i, j;
+      for (i = 0; i < n; i++) {
+        for (j = 0; j < m; j++) {
+          population += mat[i][j];
+        }
+      }
+      if (debug) {
+        printf("Generation %d:\n", back);
+        printMatrix(mat, n, m);
+      }
+      fprintf(stderr, "Generation %d: population %lld\n", back, population);
+    }
+  }
+
+  free(latency);
+  freeMatrix(a, n, m);
+  freeMatrix(b, n, m);
+}
+
+
+
+/*
+ * Function rewindTo
+ * -----------------
+ *  Restore a generation: decode the last checkpoint at or before it and
+ *  evolve the board the remaining generations
+ *
+ *  rg: pointer to the ring
+ *  gen: generation to restore (inside the window of the ring)
+ *  a, b: boards to work in
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  noise: stochastic rule of the run (NULL for the Game of Life)
+ *
+ *  returns: a or b, whichever holds the generation
+ */
+static char** rewindTo(ring_t* restrict rg, const int gen,
+                       char** restrict a, char** restrict b, const int n,
+                       const int m, const noise_t* restrict noise) {
+  char** restrict tmp;
+  int g;
+  for (g = ringRestore(rg, gen, a); g < gen; g++) {
+    generation(a, b, n, m, NULL, NULL, NULL, NULL, noise, g);
+    tmp = a;
+    a = b;
+    b = tmp;
   }
+  return a;
+}
+
+
+
+/*
+ * Function compareDoubles
+ * -----------------------
+ *  Order two doubles for qsort
+ *
+ *  returns: negative, zero or positive if a is lower, equal or greater
+ */
+static int compareDoubles(const void* a, const void* b) {
+  const double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
 }
@@ -1,6 +1,81 @@
 #ifndef GOL_H
 #define GOL_H
 
-void evolve(const int n, const int m, const int nSteps);
+#include <stdio.h>
+#include "cone.h"
+#include "delta.h"
+#include "hash.h"
+#include "noise.h"
+#include "ring.h"
+
+/*
+ * Structure options
+ * -----------------
+ *  Optional flags given after the positional arguments
+ *
+ *  unbounded: evolve on the infinite plane instead of the n x m torus
+ *  cycles: detect when the board repeats itself and skip to the final state
+ *  alloc: grid allocation strategy (-1 for the default one)
+ *  stats: path of the per-generation statistics (NULL if not requested)
+ *  separable: compute the fields from column sums (see evolveRowSeparable)
+ *  inPlace: update a single grid in place instead of two
+ *  footprint: report peak memory and throughput
+ *  roofline: report the run against the bandwidth and integer throughput of
+ *            the host
+ *  delta: path of the delta-encoded generation stream (NULL if not requested)
+ *  interval: generations between keyframes of the delta stream
+ *  generic: use the generic kernel even if a specialized one exists
+ *  rule: multi-state rule in B/S/C notation (NULL for the Game of Life)
+ *  born, survive, states: parsed rule (see gensParseRule)
+ *  rewind: bytes of the snapshot ring (0 if not requested)
+ *  rewindInterval: checkpoints between keyframes of the snapshot ring
+ *  rewindStep: generations between checkpoints of the snapshot ring
+ *  back: generation to restore from the snapshot ring after the run (-1 for
+ *        none)
+ *  queries, nQueries: regions to compute from their light cones instead of
+ *                     evolving the whole board
+ *  noise: run the stochastic rule (see noise.h)
+ *  pBirth, pSurvive: probabilities of a birth and of a survival
+ *  adaptive: switch engines as the board evolves (see adaptive.h)
+ *  incremental: update neighbor counts around the cells that flipped (see
+ *               incremental.h)
+ *  hash: generations between printed hashes (0 for the first and final ones
+ *        only, -1 if not requested)
+ */
+typedef struct options {
+  int unbounded;
+  int cycles;
+  int alloc;
+  const char* stats;
+  int separable;
+  int inPlace;
+  int footprint;
+  int roofline;
+  const char* delta;
+  int interval;
+  int generic;
+  const char* rule;
+  unsigned born, survive;
+  int states;
+  size_t rewind;
+  int rewindInterval;
+  int rewindStep;
+  int back;
+  query_t queries[CONE_MAX_QUERIES];
+  int nQueries;
+  int noise;
+  double pBirth, pSurvive;
+  int adaptive;
+  int hash;
+  int incremental;
+} options_t;
+
+// Kernel computing one generation of a board of a fixed size
+typedef void (*kernel_t)(char** restrict cur, char** restrict next);
+
+void evolve(const int n, const int m, const int nSteps,
+            history_t* restrict hist, FILE* series, delta_t* restrict stream,
+            ring_t* restrict ring, const noise_t* restrict noise,
+            kernel_t kernel, const int separable, const int every);
 
 #endif
@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "hash.h"
+#include "incremental.h"
+#include "utils.h"
+
+
+// Forward declaration of static methods
+static void evaluate(incremental_t* restrict inc);
+static void apply(incremental_t* restrict inc);
+static void applyEdge(unsigned char* restrict cells, long long* restrict queue,
+                      const int n, const int m, const long long key,
+                      const int delta, long long* restrict nQueue);
+static void writeBack(const incremental_t* restrict inc, char** restrict mat);
+static long long* reserve(long long* list, long long* restrict cap,
+                          const long long count);
+
+
+// Whether a cell flips, by its state and count (the low five bits of its
+// byte): births with 3 neighbors, deaths with fewer than 2 or more than 3
+static const unsigned char flips[32] = {
+  0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+};
+
+
+
+/*
+ * Function incrementalInit
+ * ------------------------
+ *  Set up the incremental engine, counting the live neighbors of every cell
+ *  of the board once
+ *
+ *  inc: pointer to the engine
+ *  mat: pointer to the first element of the matrix holding the initial state
+ *  n, m: dimensions of the board
+ */
+void incrementalInit(incremental_t* restrict inc, char** restrict mat,
+                     const int n, const int m) {
+  const double t = get_wall_seconds();
+  int i, j, di, dj;
+  long long population = 0;
+
+  inc->n = n;
+  inc->m = m;
+  inc->cells = (unsigned char*) malloc((size_t) n * m);
+  for (i = 0; i < n; i++) {
+    const char* restrict up = mat[i == 0 ? n-1 : i-1];
+    const char* restrict mid = mat[i];
+    const char* restrict down = mat[i == n-1 ? 0 : i+1];
+    unsigned char* restrict row = inc->cells + (size_t) i * m;
+    const int border = i == 0 || i == n-1;
+    for (j = 0; j < m; j++) {
+      const int l = j == 0 ? m-1 : j-1;
+      const int r = j == m-1 ? 0 : j+1;
+      row[j] = (up[l] + up[j] + up[r] + mid[l] + mid[r]
+                + down[l] + down[j] + down[r]) | (mid[j] ? INC_ALIVE : 0)
+               | (border || j == 0 || j == m-1 ? INC_EDGE : 0);
+      population += mid[j];
+    }
+  }
+  for (di = 0; di < 3; di++) {
+    for (dj = 0; dj < 3; dj++) {
+      inc->offsets[3*di + dj] = (long long) (di-1) * m + (dj-1);
+    }
+  }
+
+  inc->changes = NULL;
+  inc->nChanges = inc->capChanges = 0;
+  inc->queue = NULL;
+  inc->nQueue = inc->capQueue = 0;
+  inc->full = 1;
+  inc->population = population;
+  inc->gens = 0;
+  inc->flips = 0;
+  inc->evaluated = 0;
+  inc->peak = 0;
+  inc->seconds = 0;
+  inc->setup = get_wall_seconds() - t;
+}
+
+
+
+/*
+ * Function incrementalEvolve
+ * --------------------------
+ *  Evolve the board for a given number of iterations. The first generation
+ *  evaluates every cell; from then on a generation costs the cells flipped
+ *  by the previous one and their neighbors, whatever the size of the board
+ *
+ *  inc: pointer to the engine
+ *  mat: pointer to the first element of the matrix, holding the final state
+ *       on return
+ *  nSteps: number of iterations
+ *  every: print the hash of generation 0, of every generation multiple of
+ *         every (if positive) and of the final one (see hashReport), or -1
+ *         to print none
+ */
+void incrementalEvolve(incremental_t* restrict inc, char** restrict mat,
+                       const int nSteps, const int every) {
+  int k;
+
+  if (every >= 0) {
+    hashReport(0, hashMatrix(mat, inc->n, inc->m));
+  }
+
+  for (k = 0; k < nSteps; k++) {
+    const double t = get_wall_seconds();
+    const int full = inc->full;
+    const long long queued = inc->nQueue;
+    evaluate(inc);
+    apply(inc);
+    if (full) {
+      inc->setup += get_wall_seconds() - t;
+    } else {
+      inc->seconds += get_wall_seconds() - t;
+      inc->gens++;
+      inc->flips += inc->nChanges;
+      inc->evaluated += queued;
+      if (inc->nChanges > inc->peak) inc->peak = inc->nChanges;
+    }
+
+    if (every > 0 && (k+1) % every == 0 && k+1 != nSteps) {
+      writeBack(inc, mat);
+      hashReport(k+1, hashMatrix(mat, inc->n, inc->m));
+    }
+  }
+
+  writeBack(inc, mat);
+  if (every >= 0) {
+    hashReport(nSteps, hashMatrix(mat, inc->n, inc->m));
+  }
+}
+
+
+
+/*
+ * Function incrementalReport
+ * --------------------------
+ *  Print the activity of the run and the cost of the generations after the
+ *  first one, which are the ones that depend on the activity
+ *
+ *  inc: pointer to the engine
+ *  f: stream to print to
+ */
+void incrementalReport(const incremental_t* restrict inc, FILE* f) {
+  const double cells = (double) inc->n * inc->m;
+  const double gens = inc->gens > 0 ? inc->gens : 1;
+  const double flipped = inc->flips > 0 ? inc->flips : 1;
+  fprintf(f, "Incremental: %lld generations after the first, %.4f%% of the "
+          "cells flipped per generation (peak %.4f%%), %.2f cells evaluated "
+          "and %.1f ns per flip, setup and first generation %.3f ms, final "
+          "population %lld\n", inc->gens, 100 * inc->flips / gens / cells,
+          100 * inc->peak / cells, inc->evaluated / flipped,
+          inc->seconds / flipped * 1e9, inc->setup * 1e3, inc->population);
+}
+
+
+
+/*
+ * Function incrementalFree
+ * ------------------------
+ *  Free the memory of the incremental engine (not the grid)
+ *
+ *  inc: pointer to the engine
+ */
+void incrementalFree(incremental_t* restrict inc) {
+  free(inc->cells);
+  free(inc->changes);
+  free(inc->queue);
+}
+
+
+
+/*
+ * Function evaluate
+ * -----------------
+ *  List the cells that flip in the next generation, among every cell of the
+ *  board the first time and among the queued ones afterwards (a cell whose
+ *  count and state did not change keeps its state, since it kept it in the
+ *  previous generation). The queued flags are cleared on the way
+ *
+ *  inc: pointer to the engine
+ */
+static void evaluate(incremental_t* restrict inc) {
+  unsigned char* restrict cells = inc->cells;
+  long long c, q;
+  long long count = 0;
+
+  if (inc->full) {
+    const long long total = (long long) inc->n * inc->m;
+    for (c = 0; c < total; c++) {
+      if (count == inc->capChanges) {
+        inc->changes = reserve(inc->changes, &inc->capChanges, count + 1);
+      }
+      inc->changes[count] = c;
+      count += flips[cells[c] & (INC_ALIVE | INC_COUNT)];
+    }
+    inc->full = 0;
+  } else {
+    // A cell flips at most once, so the queue bounds the changes. Appends
+    // are branch-free: the slot is only kept if the cell flips
+    inc->changes = reserve(inc->changes, &inc->capChanges, inc->nQueue);
+    long long* restrict changes = inc->changes;
+    const long long* restrict queue = inc->queue;
+    const long long nQueue = inc->nQueue;
+    for (q = 0; q < nQueue; q++) {
+      c = queue[q];
+      const unsigned char cell = cells[c] & ~INC_QUEUED;
+      cells[c] = cell;
+      changes[count] = c;
+      count += flips[cell & (INC_ALIVE | INC_COUNT)];
+    }
+  }
+  inc->nChanges = count;
+}
+
+
+
+/*
+ * Function apply
+ * --------------
+ *  Flip the listed cells, adding 1 to the counts of the neighbors of every
+ *  cell born and subtracting 1 from those of every cell that dies. Every
+ *  flipped cell and every neighbor is queued once for the next generation.
+ *  Counts stay within 0 to 8, so the updates never carry into the flags
+ *
+ *  inc: pointer to the engine
+ */
+static void apply(incremental_t* restrict inc) {
+  const int n = inc->n, m = inc->m;
+  const long long total = (long long) n * m;
+  unsigned char* restrict cells = inc->cells;
+  const long long* restrict off = inc->offsets;
+  long long c;
+  int o;
+
+  // One more slot than the cells queued for the branch-free appends
+  inc->queue = reserve(inc->queue, &inc->capQueue,
+                       (9 * inc->nChanges < total ? 9 * inc->nChanges : total)
+                       + 1);
+  long long* restrict queue = inc->queue;
+  const long long* restrict changes = inc->changes;
+  const long long nChanges = inc->nChanges;
+  long long nQueue = 0;
+  long long population = inc->population;
+
+  for (c = 0; c < nChanges; c++) {
+    const long long key = changes[c];
+    const unsigned char cell = cells[key] ^ INC_ALIVE;
+    cells[key] = cell;
+    const int delta = 2 * ((cell & INC_ALIVE) != 0) - 1;
+    population += delta;
+    if (cell & INC_EDGE) {
+      applyEdge(cells, queue, n, m, key, delta, &nQueue);
+      continue;
+    }
+    // The 3x3 block does not wrap around: fixed offsets, the center is only
+    // queued, appends as in evaluate
+    const unsigned char add = (unsigned char) delta;
+    for (o = 0; o < 9; o++) {
+      const long long nb = key + off[o];
+      const unsigned char v = cells[nb];
+      queue[nQueue] = nb;
+      nQueue += !(v & INC_QUEUED);
+      cells[nb] = (unsigned char) (v + (o == 4 ? 0 : add)) | INC_QUEUED;
+    }
+  }
+  inc->nQueue = nQueue;
+  inc->population = population;
+}
+
+
+
+/*
+ * Function applyEdge
+ * ------------------
+ *  Update the neighbors of a flipped cell on the border of the board, whose
+ *  3x3 block wraps around the torus
+ *
+ *  cells: count, state and flags of every cell
+ *  queue: cells to evaluate in the next generation
+ *  n, m: dimensions of the board
+ *  key: index of the cell
+ *  delta: 1 if the cell was born, -1 if it died
+ *  nQueue: pointer to the number of queued cells, updated
+ */
+static void applyEdge(unsigned char* restrict cells, long long* restrict queue,
+                      const int n, const int m, const long long key,
+                      const int delta, long long* restrict nQueue) {
+  const int i = (int) (key / m), j = (int) (key - (long long) i * m);
+  // Rows and columns around the cell, wrapping around the torus
+  const long long rows[3] = {(long long) (i == 0 ? n-1 : i-1) * m,
+                             (long long) i * m,
+                             (long long) (i == n-1 ? 0 : i+1) * m};
+  const int cols[3] = {j == 0 ? m-1 : j-1, j, j == m-1 ? 0 : j+1};
+  int di, dj;
+  for (di = 0; di < 3; di++) {
+    for (dj = 0; dj < 3; dj++) {
+      const long long nb = rows[di] + cols[dj];
+      if (di != 1 || dj != 1) cells[nb] += delta;
+      if (!(cells[nb] & INC_QUEUED)) {
+        cells[nb] |= INC_QUEUED;
+        queue[(*nQueue)++] = nb;
+      }
+    }
+  }
+}
+
+
+
+/*
+ * Function writeBack
+ * ------------------
+ *  Copy the states held in the cells to the grid
+ *
+ *  inc: pointer to the engine
+ *  mat: pointer to the first element of the matrix
+ */
+static void writeBack(const incremental_t* restrict inc, char** restrict mat) {
+  const int n = inc->n, m = inc->m;
+  int i, j;
+  for (i = 0; i < n; i++) {
+    const unsigned char* restrict row = inc->cells + (size_t) i * m;
+    char* restrict out = mat[i];
+    for (j = 0; j < m; j++) {
+      out[j] = (row[j] & INC_ALIVE) != 0;
+    }
+  }
+}
+
+
+
+/*
+ * Function reserve
+ * ----------------
+ *  Make room in a list of cells
+ *
+ *  list: pointer to the first element of the list
+ *  cap: pointer to the capacity of the list, updated
+ *  count: number of cells the list must hold
+ *
+ *  returns: pointer to the first element of the list, moved if it grew
+ */
+static long long* reserve(long long* list, long long* restrict cap,
+                          const long long count) {
+  if (count <= *cap) return list;
+  *cap = 2 * count;
+  return (long long*) realloc(list, *cap * sizeof(long long));
+}
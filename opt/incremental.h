@@ -0,0 +1,63 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdio.h>
+
+// Fields of the byte kept for every cell: live neighbors in the low bits,
+// then the state of the cell, whether it is queued for evaluation and
+// whether it lies on the border of the board (its neighbors wrap around)
+#define INC_COUNT 0x0F
+#define INC_ALIVE 0x10
+#define INC_QUEUED 0x20
+#define INC_EDGE 0x40
+
+/*
+ * Structure incremental
+ * ---------------------
+ *  Torus evolved from persistent neighbor counts: only the cells that
+ *  flipped in the last generation update the counts of their neighbors, and
+ *  only the cells whose count or state changed are evaluated again. Cells
+ *  are indices i*m + j. The cells hold the board while it evolves; the grid
+ *  is written back at the checkpoints and at the end
+ *
+ *  n, m: dimensions of the board
+ *  cells: count, state and flags of every cell (see INC_COUNT)
+ *  offsets: distances from a cell off the border to its 3x3 block
+ *  changes, nChanges, capChanges: cells flipped by the current generation
+ *  queue, nQueue, capQueue: cells to evaluate in the next generation
+ *  full: whether every cell is evaluated in the next generation (the first
+ *        one, before any change is known)
+ *  population: live cells of the board
+ *  gens: generations computed after the first
+ *  flips: cells flipped over those generations
+ *  evaluated: cells evaluated over those generations
+ *  peak: most cells flipped by one of them
+ *  setup: time spent building the counts and computing the first generation
+ *  seconds: time spent in the other generations
+ */
+typedef struct incremental {
+  int n, m;
+  unsigned char* cells;
+  long long offsets[9];
+  long long* changes;
+  long long nChanges, capChanges;
+  long long* queue;
+  long long nQueue, capQueue;
+  int full;
+  long long population;
+  long long gens;
+  long long flips;
+  long long evaluated;
+  long long peak;
+  double setup;
+  double seconds;
+} incremental_t;
+
+void incrementalInit(incremental_t* restrict inc, char** restrict mat,
+                     const int n, const int m);
+void incrementalEvolve(incremental_t* restrict inc, char** restrict mat,
+                       const int nSteps, const int every);
+void incrementalReport(const incremental_t* restrict inc, FILE* f);
+void incrementalFree(incremental_t* restrict inc);
+
+#endif
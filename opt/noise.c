@@ -0,0 +1,143 @@
+#include "noise.h"
+
+
+// Forward declaration of static methods
+static inline unsigned long long splitMix(unsigned long long x);
+static inline unsigned mix32(unsigned x);
+static inline char fate(const char alive, const char field, const unsigned r,
+                        const int birth, const int survive);
+
+
+
+/*
+ * Function noiseInit
+ * ------------------
+ *  Set up the stochastic rule
+ *
+ *  nz: pointer to the rule
+ *  seed: key of the generator
+ *  pBirth: probability of a birth when three neighbors are alive
+ *  pSurvive: probability of a live cell with two or three live neighbors
+ *            surviving
+ */
+void noiseInit(noise_t* restrict nz, const unsigned long long seed,
+               const double pBirth, const double pSurvive) {
+  nz->seed = seed;
+  nz->birth = (int) (pBirth * (1 << 24) + 0.5);
+  nz->survive = (int) (pSurvive * (1 << 24) + 0.5);
+}
+
+
+
+/*
+ * Function noiseRow
+ * -----------------
+ *  Compute the future state of one row of the torus under the stochastic
+ *  rule. The row gets a 64-bit key from the seed, the generation and its
+ *  index; the draw of column j is two keyed rounds of a 32-bit integer hash
+ *  of j, only shifts, XORs and 32-bit multiplications, so the loop over the
+ *  columns is vectorized like the deterministic one
+ *
+ *  nz: pointer to the rule
+ *  gen: generation the row is computed from
+ *  i: index of the row
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the row
+ */
+void noiseRow(const noise_t* restrict nz, const int gen, const int i,
+              const char* restrict up, const char* restrict mid,
+              const char* restrict down, char* restrict out, const int m) {
+  const unsigned long long key = splitMix(splitMix(splitMix(nz->seed)
+                                                   ^ (unsigned) gen)
+                                          ^ (unsigned) i);
+  const unsigned k0 = (unsigned) key, k1 = (unsigned) (key >> 32);
+  const int birth = nz->birth, survive = nz->survive;
+  int j;
+  char field;
+
+  // First column (j=0)
+  field = up[m-1] + up[0] + up[1]
+          + mid[m-1] + mid[0] + mid[1]
+          + down[m-1] + down[0] + down[1];
+  out[0] = fate(mid[0], field, mix32(mix32(0 ^ k0) ^ k1), birth, survive);
+  // Other columns (j=1 to m-2)
+  for (j = 1; j <= m - 2; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+            + mid[j-1] + mid[j] + mid[j+1]
+            + down[j-1] + down[j] + down[j+1];
+    out[j] = fate(mid[j], field, mix32(mix32((unsigned) j ^ k0) ^ k1), birth,
+                  survive);
+  }
+  // Last column (j=m-1)
+  field = up[m-2] + up[m-1] + up[0]
+          + mid[m-2] + mid[m-1] + mid[0]
+          + down[m-2] + down[m-1] + down[0];
+  out[m-1] = fate(mid[m-1], field, mix32(mix32((unsigned) (m-1) ^ k0) ^ k1),
+                  birth, survive);
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator, used to derive the key of a row
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+
+/*
+ * Function mix32
+ * --------------
+ *  32-bit integer hash (lowbias32), a bijection with good avalanche
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned mix32(unsigned x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352DU;
+  x ^= x >> 15;
+  x *= 0x846CA68BU;
+  x ^= x >> 16;
+  return x;
+}
+
+
+
+/*
+ * Function fate
+ * -------------
+ *  Decide the future state of a cell under the stochastic rule. The field
+ *  includes the cell: 3 is a birth for a dead cell and a survival for a live
+ *  one, 4 a survival for a live cell
+ *
+ *  alive: current state of the cell
+ *  field: number of live cells in the 3x3 block around the cell
+ *  r: draw of the cell
+ *  birth, survive: thresholds of the top 24 bits of the draw
+ *
+ *  returns: the future state of the cell
+ */
+static inline char fate(const char alive, const char field, const unsigned r,
+                        const int birth, const int survive) {
+  // Branch-free (masks instead of selections), so the loops over the
+  // columns are vectorized
+  const int threshold = birth + ((survive - birth) & -(int) alive);
+  const char chance = (int) (r >> 8) < threshold;
+  return ((field == 3) | ((field == 4) & alive)) & chance;
+}
@@ -0,0 +1,29 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+/*
+ * Structure noise
+ * ---------------
+ *  Stochastic Game of Life: a cell whose neighbors would bring it to life is
+ *  born with probability pBirth, and a live cell whose neighbors would keep
+ *  it alive survives with probability pSurvive. Every cell of every
+ *  generation draws one random number from a counter-based generator keyed
+ *  by (seed, generation, row, column), so the evolution only depends on the
+ *  seed, whatever computes it and in whatever order
+ *
+ *  seed: key of the generator
+ *  birth, survive: thresholds of the top 24 bits of a draw (probability
+ *                  times 2^24)
+ */
+typedef struct noise {
+  unsigned long long seed;
+  int birth, survive;
+} noise_t;
+
+void noiseInit(noise_t* restrict nz, const unsigned long long seed,
+               const double pBirth, const double pSurvive);
+void noiseRow(const noise_t* restrict nz, const int gen, const int i,
+              const char* restrict up, const char* restrict mid,
+              const char* restrict down, char* restrict out, const int m);
+
+#endif
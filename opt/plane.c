@@ -0,0 +1,340 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "plane.h"
+
+
+// Margin (in cells) that must separate the live box from the storage edges:
+// one for the cells that can be born next to the box, one for their neighbors
+#define PLANE_MARGIN 2
+
+
+// Forward declaration of static methods
+static inline char decide(const char alive, const char field);
+static void clearStale(plane_t* restrict p, const int t, const int b,
+                       const int l, const int r);
+static void fit(plane_t* restrict p);
+static void place(plane_t* restrict p, char* restrict dst, const int rows,
+                  const int cols);
+
+
+
+/*
+ * Function planeInit
+ * ------------------
+ *  Load a finite pattern into an unbounded plane. The pattern occupies world
+ *  rows [0, n) and columns [0, m)
+ *
+ *  p: pointer to the plane to initialize
+ *  mat: pointer to the first element of the pattern matrix
+ *  n: number of rows of the pattern
+ *  m: number of columns of the pattern
+ */
+void planeInit(plane_t* restrict p, char** restrict mat, const int n,
+               const int m) {
+  int i, j;
+  p->rows = 2*n + 4*PLANE_MARGIN;
+  p->cols = 2*m + 4*PLANE_MARGIN;
+  p->cells = (char*) calloc((size_t) p->rows * p->cols, sizeof(char));
+  p->next = (char*) calloc((size_t) p->rows * p->cols, sizeof(char));
+  p->r0 = -(p->rows - n)/2;
+  p->c0 = -(p->cols - m)/2;
+  p->top = p->left = 0;
+  p->bot = p->right = -1;
+  p->ntop = p->nleft = 0;
+  p->nbot = p->nright = -1;
+  p->nGrows = p->nShifts = 0;
+  p->updates = 0;
+
+  // Copy the pattern and find its bounding box
+  int first = 1;
+  for (i = 0; i < n; i++) {
+    char* restrict row = p->cells + (size_t) (i - p->r0) * p->cols - p->c0;
+    for (j = 0; j < m; j++) {
+      row[j] = mat[i][j];
+      if (mat[i][j]) {
+        if (first) {
+          p->top = p->bot = i - p->r0;
+          p->left = p->right = j - p->c0;
+          first = 0;
+        }
+        if (i - p->r0 > p->bot) p->bot = i - p->r0;
+        if (j - p->c0 < p->left) p->left = j - p->c0;
+        if (j - p->c0 > p->right) p->right = j - p->c0;
+      }
+    }
+  }
+}
+
+
+
+/*
+ * Function planeEvolve
+ * --------------------
+ *  Evolve an unbounded plane for a given number of iterations. Only the live
+ *  bounding box plus a one-cell margin is computed at every generation, and
+ *  the storage is shifted or grown (doubling) whenever the box gets too close
+ *  to its edges
+ *
+ *  p: pointer to the plane
+ *  nSteps: number of iterations
+ */
+void planeEvolve(plane_t* restrict p, const int nSteps) {
+  int k, i, j;
+  char field;
+  for (k = 0; k < nSteps; k++) {
+
+    // An empty plane stays empty
+    if (p->top > p->bot) {
+      break;
+    }
+
+    // Make sure the neighbors of the computed region exist in storage
+    if (p->top < PLANE_MARGIN || p->bot >= p->rows - PLANE_MARGIN
+        || p->left < PLANE_MARGIN || p->right >= p->cols - PLANE_MARGIN) {
+      fit(p);
+    }
+
+    // Region to compute: live box plus a one-cell margin
+    const int t = p->top - 1, b = p->bot + 1;
+    const int l = p->left - 1, r = p->right + 1;
+    const int cols = p->cols;
+    clearStale(p, t, b, l, r);
+
+    int top = p->rows, bot = -1, left = cols, right = -1;
+    for (i = t; i <= b; i++) {
+      const char* restrict up = p->cells + (size_t) (i-1) * cols;
+      const char* restrict mid = up + cols;
+      const char* restrict down = mid + cols;
+      char* restrict out = p->next + (size_t) i * cols;
+      for (j = l; j <= r; j++) {
+        field = up[j-1] + up[j] + up[j+1]
+                    + mid[j-1] + mid[j] + mid[j+1]
+                    + down[j-1] + down[j] + down[j+1];
+        out[j] = decide(mid[j], field);
+      }
+      // Update the bounding box while the row is still in cache
+      for (j = l; j <= r && !out[j]; j++);
+      if (j <= r) {
+        if (i < top) top = i;
+        bot = i;
+        if (j < left) left = j;
+        for (j = r; !out[j]; j--);
+        if (j > right) right = j;
+      }
+    }
+    p->updates += (long long) (b - t + 1) * (r - l + 1);
+
+    // Make cells point to next and next point to cells
+    char* restrict tmp = p->cells;
+    p->cells = p->next;
+    p->next = tmp;
+    p->ntop = p->top;
+    p->nbot = p->bot;
+    p->nleft = p->left;
+    p->nright = p->right;
+    if (bot < 0) {
+      p->top = p->left = 0;
+      p->bot = p->right = -1;
+    } else {
+      p->top = top;
+      p->bot = bot;
+      p->left = left;
+      p->right = right;
+    }
+  }
+}
+
+
+
+/*
+ * Function planePopulation
+ * ------------------------
+ *  Count the live cells of an unbounded plane
+ *
+ *  p: pointer to the plane
+ *
+ *  returns: the number of live cells
+ */
+long long planePopulation(const plane_t* restrict p) {
+  int i, j;
+  long long count = 0;
+  for (i = p->top; i <= p->bot; i++) {
+    const char* restrict row = p->cells + (size_t) i * p->cols;
+    for (j = p->left; j <= p->right; j++) {
+      count += row[j];
+    }
+  }
+  return count;
+}
+
+
+
+/*
+ * Function planePrint
+ * -------------------
+ *  Print the live bounding box of an unbounded plane to console
+ *
+ *  p: pointer to the plane
+ */
+void planePrint(const plane_t* restrict p) {
+  int i, j;
+  if (p->top > p->bot) {
+    printf("Empty plane\n");
+    return;
+  }
+  printf("Bounding box: rows [%lld, %lld], columns [%lld, %lld]\n",
+         p->r0 + p->top, p->r0 + p->bot, p->c0 + p->left, p->c0 + p->right);
+  for (i = p->top; i <= p->bot; i++) {
+    const char* restrict row = p->cells + (size_t) i * p->cols;
+    printf("[ ");
+    for (j = p->left; j <= p->right; j++) {
+      printf("%d ", row[j]);
+    }
+    printf("]\n");
+  }
+}
+
+
+
+/*
+ * Function planeFree
+ * ------------------
+ *  Free memory occupied by an unbounded plane
+ *
+ *  p: pointer to the plane
+ */
+void planeFree(plane_t* restrict p) {
+  free(p->cells);
+  free(p->next);
+  p->cells = p->next = NULL;
+}
+
+
+
+/*
+ * Function clearStale
+ * -------------------
+ *  Zero the cells of the next buffer that lie outside the region about to be
+ *  computed, so that only the freshly computed cells can be alive
+ *
+ *  p: pointer to the plane
+ *  t, b: first and last row of the computed region (inclusive)
+ *  l, r: first and last column of the computed region (inclusive)
+ */
+static void clearStale(plane_t* restrict p, const int t, const int b,
+                       const int l, const int r) {
+  int i;
+  const size_t w = p->nright >= p->nleft ? p->nright - p->nleft + 1 : 0;
+  for (i = p->ntop; i <= p->nbot && w > 0; i++) {
+    char* restrict row = p->next + (size_t) i * p->cols;
+    if (i < t || i > b) {
+      memset(row + p->nleft, 0, w);
+    } else {
+      if (p->nleft < l) {
+        const int last = p->nright < l ? p->nright : l - 1;
+        memset(row + p->nleft, 0, (size_t) (last - p->nleft + 1));
+      }
+      if (p->nright > r) {
+        const int first = p->nleft > r ? p->nleft : r + 1;
+        memset(row + first, 0, (size_t) (p->nright - first + 1));
+      }
+    }
+  }
+  p->ntop = p->nleft = 0;
+  p->nbot = p->nright = -1;
+}
+
+
+
+/*
+ * Function fit
+ * ------------
+ *  Recenter the live box in storage, doubling the storage dimensions until
+ *  the box takes at most half of each one. Doubling keeps the amortized cost
+ *  of reallocation proportional to the extent of the pattern
+ *
+ *  p: pointer to the plane
+ */
+static void fit(plane_t* restrict p) {
+  const int h = p->bot - p->top + 1;
+  const int w = p->right - p->left + 1;
+  int rows = p->rows, cols = p->cols;
+  while (rows < 2*h + 4*PLANE_MARGIN) rows *= 2;
+  while (cols < 2*w + 4*PLANE_MARGIN) cols *= 2;
+
+  if (rows == p->rows && cols == p->cols) {
+    // Shift through the scratch buffer, touching only the live box
+    clearStale(p, 0, -1, 0, -1);
+    place(p, p->next, rows, cols);
+    char* restrict tmp = p->cells;
+    p->cells = p->next;
+    p->next = tmp;
+    p->nShifts++;
+  } else {
+    // Grow both buffers
+    char* restrict cells = (char*) calloc((size_t) rows * cols, sizeof(char));
+    place(p, cells, rows, cols);
+    free(p->cells);
+    free(p->next);
+    p->cells = cells;
+    p->next = (char*) calloc((size_t) rows * cols, sizeof(char));
+    p->rows = rows;
+    p->cols = cols;
+    p->nGrows++;
+  }
+}
+
+
+
+/*
+ * Function place
+ * --------------
+ *  Copy the live box to the center of a zeroed buffer, clear it from the
+ *  current one and update the coordinates of the plane accordingly
+ *
+ *  p: pointer to the plane
+ *  dst: pointer to the first element of the destination buffer
+ *  rows, cols: dimensions of the destination buffer
+ */
+static void place(plane_t* restrict p, char* restrict dst, const int rows,
+                  const int cols) {
+  int i;
+  const int h = p->bot - p->top + 1;
+  const int w = p->right - p->left + 1;
+  const int top = (rows - h)/2;
+  const int left = (cols - w)/2;
+  for (i = 0; i < h; i++) {
+    char* restrict src = p->cells + (size_t) (p->top + i) * p->cols + p->left;
+    memcpy(dst + (size_t) (top + i) * cols + left, src, w);
+    memset(src, 0, w);
+  }
+  p->r0 += p->top - top;
+  p->c0 += p->left - left;
+  p->top = top;
+  p->bot = top + h - 1;
+  p->left = left;
+  p->right = left + w - 1;
+}
+
+
+
+/*
+ * Function decide
+ * ---------------
+ *  Decide wether a cell lives or dies
+ *
+ *  alive: current state of the cell
+ *  field: number of alive neighbors + the cell itself
+ *
+ *  returns: the future state of the cell
+ */
+static inline char decide(const char alive, const char field) {
+  if (field == 3) {
+    return 1;
+  } else if (field == 4) {
+    return alive;
+  } else {
+    return 0;
+  }
+}
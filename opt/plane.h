@@ -0,0 +1,38 @@
+#ifndef PLANE_H
+#define PLANE_H
+
+/*
+ * Structure plane
+ * ---------------
+ *  Window of the unbounded plane that holds every live cell
+ *
+ *  cells: current generation (rows x cols, row-major)
+ *  next: scratch buffer for the next generation (same shape as cells)
+ *  rows, cols: dimensions of the backing storage
+ *  r0, c0: world coordinates of storage cell (0, 0)
+ *  top, bot, left, right: live bounding box in storage coordinates
+ *                         (inclusive, empty when top > bot)
+ *  ntop, nbot, nleft, nright: bounding box of the cells still set in next
+ *  nGrows: number of times the storage was reallocated
+ *  nShifts: number of times the pattern was recentered without growing
+ *  updates: number of cell updates actually computed
+ */
+typedef struct plane {
+  char* restrict cells;
+  char* restrict next;
+  int rows, cols;
+  long long r0, c0;
+  int top, bot, left, right;
+  int ntop, nbot, nleft, nright;
+  int nGrows, nShifts;
+  long long updates;
+} plane_t;
+
+void planeInit(plane_t* restrict p, char** restrict mat, const int n,
+               const int m);
+void planeEvolve(plane_t* restrict p, const int nSteps);
+long long planePopulation(const plane_t* restrict p);
+void planePrint(const plane_t* restrict p);
+void planeFree(plane_t* restrict p);
+
+#endif
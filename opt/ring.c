@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ring.h"
+
+
+// Forward declaration of static methods
+static void dropOldest(ring_t* restrict rg);
+static size_t encode(const unsigned char* restrict in, const size_t len,
+                     unsigned char* restrict out);
+static void decode(const unsigned char* restrict in, const size_t len,
+                   unsigned char* restrict out, const size_t total,
+                   const int key);
+static inline size_t putVarint(unsigned char* restrict p,
+                               unsigned long long v);
+static inline size_t getVarint(const unsigned char* restrict p,
+                               unsigned long long* v);
+
+
+
+/*
+ * Function ringInit
+ * -----------------
+ *  Create an empty snapshot ring
+ *
+ *  rg: pointer to the ring
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  budget: bytes the checkpoints may take
+ *  interval: checkpoints between keyframes
+ *  step: generations between checkpoints
+ */
+void ringInit(ring_t* restrict rg, const int n, const int m,
+              const size_t budget, const int interval, const int step) {
+  const size_t total = (size_t) n * ((m + 63) / 64);
+  rg->n = n;
+  rg->m = m;
+  rg->words = (m + 63) / 64;
+  rg->step = step;
+  rg->interval = interval;
+  rg->budget = budget;
+  rg->cap = 64;
+  rg->cps = (checkpoint_t*) malloc(rg->cap * sizeof(checkpoint_t));
+  rg->first = rg->count = 0;
+  rg->bytes = 0;
+  rg->sinceKey = 0;
+  rg->last = (unsigned long long*) calloc(total, sizeof(unsigned long long));
+  rg->packed = (unsigned long long*) malloc(total
+                                            * sizeof(unsigned long long));
+  rg->buf = (unsigned char*) malloc(total * sizeof(unsigned long long)
+                                    + total / 8 + 32);
+  rg->taken = rg->evicted = 0;
+}
+
+
+
+/*
+ * Function ringPush
+ * -----------------
+ *  Take a checkpoint of a board. The board is bit-packed (cell j of a row is
+ *  bit j%64 of word j/64), XORed with the last checkpoint unless a keyframe
+ *  is due, and compressed as a sequence of groups: the number of zero bytes,
+ *  the number of literal bytes (varints) and the literal bytes. A delta of a
+ *  settling board is mostly zero bytes, so it takes a few percent of the
+ *  packed board. The oldest keyframes are then dropped until the ring fits
+ *  its budget (the current keyframe and its deltas are always kept)
+ *
+ *  rg: pointer to the ring
+ *  mat: pointer to the first element of the board
+ *  gen: generation of the board (the next multiple of step)
+ */
+void ringPush(ring_t* restrict rg, char** restrict mat, const int gen) {
+  const int m = rg->m, words = rg->words;
+  const size_t total = (size_t) rg->n * words;
+  unsigned long long* restrict packed = rg->packed;
+  unsigned long long* restrict last = rg->last;
+  unsigned long long x;
+  size_t w;
+  int i, c, k, j;
+
+  // Bit-pack the board: cells are 0 or 1, so eight of them read as a word
+  // are packed into eight bits with one multiplication
+  for (i = 0; i < rg->n; i++) {
+    const char* restrict row = mat[i];
+    unsigned long long* restrict out = packed + (size_t) i * words;
+    for (c = 0; c < words; c++) {
+      const int base = 64*c;
+      unsigned long long bits = 0;
+      for (k = 0; k < 8 && base + 8*k + 8 <= m; k++) {
+        memcpy(&x, row + base + 8*k, 8);
+        bits |= ((x * 0x0102040810204080ULL) >> 56) << (8*k);
+      }
+      for (j = base + 8*k; j < m && j < base + 64; j++) {
+        bits |= (unsigned long long) row[j] << (j - base);
+      }
+      out[c] = bits;
+    }
+  }
+
+  // Keep the packed board for the next delta, and encode the delta in its
+  // place
+  const int key = rg->sinceKey == 0;
+  for (w = 0; w < total; w++) {
+    const unsigned long long b = packed[w];
+    packed[w] = key ? b : b ^ last[w];
+    last[w] = b;
+  }
+  rg->sinceKey = (rg->sinceKey + 1) % rg->interval;
+  const size_t len = encode((const unsigned char*) packed,
+                            total * sizeof(unsigned long long), rg->buf);
+
+  // Append the checkpoint, moving the window to the front of the array or
+  // growing it when the end is reached
+  if (rg->first + rg->count == rg->cap) {
+    if (rg->first > 0) {
+      memmove(rg->cps, rg->cps + rg->first,
+              rg->count * sizeof(checkpoint_t));
+      rg->first = 0;
+    } else {
+      rg->cap *= 2;
+      rg->cps = (checkpoint_t*) realloc(rg->cps,
+                                        rg->cap * sizeof(checkpoint_t));
+    }
+  }
+  checkpoint_t* cp = &rg->cps[rg->first + rg->count];
+  cp->gen = gen;
+  cp->key = key;
+  cp->len = len;
+  cp->data = (unsigned char*) malloc(len > 0 ? len : 1);
+  memcpy(cp->data, rg->buf, len);
+  rg->count++;
+  rg->bytes += len;
+  rg->taken++;
+
+  while (rg->bytes > rg->budget) {
+    const int before = rg->count;
+    dropOldest(rg);
+    if (rg->count == before) {
+      break;
+    }
+  }
+}
+
+
+
+/*
+ * Function ringFirst
+ * ------------------
+ *  Earliest generation that can be restored
+ *
+ *  rg: pointer to the ring
+ *
+ *  returns: the generation of the oldest checkpoint, or -1 if there is none
+ */
+int ringFirst(const ring_t* restrict rg) {
+  return rg->count > 0 ? rg->cps[rg->first].gen : -1;
+}
+
+
+
+/*
+ * Function ringRestore
+ * --------------------
+ *  Decode the last checkpoint at or before a generation: its keyframe is
+ *  decompressed and the deltas up to it are XORed in. The caller evolves the
+ *  board the remaining (fewer than step) generations
+ *
+ *  rg: pointer to the ring
+ *  gen: generation to go back to
+ *  mat: pointer to the first element of the board to fill
+ *
+ *  returns: the generation of the decoded checkpoint, or -1 if gen is before
+ *           the window
+ */
+int ringRestore(ring_t* restrict rg, const int gen, char** restrict mat) {
+  const int m = rg->m, words = rg->words;
+  const size_t total = (size_t) rg->n * words * sizeof(unsigned long long);
+  int c, k, i, j;
+  if (rg->count == 0 || gen < rg->cps[rg->first].gen) {
+    return -1;
+  }
+  c = (gen - rg->cps[rg->first].gen) / rg->step;
+  if (c >= rg->count) {
+    c = rg->count - 1;
+  }
+  c += rg->first;
+  // The window always starts with a keyframe
+  for (k = c; !rg->cps[k].key; k--);
+  for (; k <= c; k++) {
+    decode(rg->cps[k].data, rg->cps[k].len, (unsigned char*) rg->packed,
+           total, rg->cps[k].key);
+  }
+  for (i = 0; i < rg->n; i++) {
+    const unsigned long long* restrict in = rg->packed + (size_t) i * words;
+    char* restrict row = mat[i];
+    for (j = 0; j < m; j++) {
+      row[j] = (char) ((in[j/64] >> (j%64)) & 1);
+    }
+  }
+  return rg->cps[c].gen;
+}
+
+
+
+/*
+ * Function ringReport
+ * -------------------
+ *  Report the window of a snapshot ring and its size against bit-packed
+ *  boards
+ *
+ *  rg: pointer to the ring
+ *  last: generation the run ended at
+ */
+void ringReport(const ring_t* restrict rg, const int last) {
+  const double packed = (double) rg->count * rg->n * rg->words
+                        * sizeof(unsigned long long);
+  int c, keys = 0;
+  for (c = rg->first; c < rg->first + rg->count; c++) {
+    keys += rg->cps[c].key;
+  }
+  fprintf(stderr, "Rewind: generations %d to %d, %d checkpoints (%d "
+          "keyframes) every %d generations, %.1f of %.1f kB, %.2f%% of "
+          "bit-packed boards, %lld of %lld checkpoints dropped\n",
+          ringFirst(rg), last, rg->count, keys, rg->step, rg->bytes / 1024.0,
+          rg->budget / 1024.0, packed > 0 ? 100.0 * rg->bytes / packed : 0.0,
+          rg->evicted, rg->taken);
+}
+
+
+
+/*
+ * Function ringFree
+ * -----------------
+ *  Free the checkpoints and buffers of a snapshot ring
+ *
+ *  rg: pointer to the ring
+ */
+void ringFree(ring_t* restrict rg) {
+  int c;
+  for (c = rg->first; c < rg->first + rg->count; c++) {
+    free(rg->cps[c].data);
+  }
+  free(rg->cps);
+  free(rg->last);
+  free(rg->packed);
+  free(rg->buf);
+}
+
+
+
+/*
+ * Function dropOldest
+ * -------------------
+ *  Drop the oldest keyframe and the deltas that depend on it, unless it is
+ *  the last keyframe of the window
+ *
+ *  rg: pointer to the ring
+ */
+static void dropOldest(ring_t* restrict rg) {
+  const int end = rg->first + rg->count;
+  int c = rg->first + 1;
+  while (c < end && !rg->cps[c].key) {
+    c++;
+  }
+  if (c == end) {
+    return;
+  }
+  for (; rg->first < c; rg->first++, rg->count--) {
+    rg->bytes -= rg->cps[rg->first].len;
+    free(rg->cps[rg->first].data);
+    rg->evicted++;
+  }
+}
+
+
+
+/*
+ * Function encode
+ * ---------------
+ *  Compress bytes as groups of zero bytes and literal bytes. A literal run
+ *  ends at two zero bytes in a row, so isolated zeros do not cost a group
+ *
+ *  in: pointer to the first byte to compress
+ *  len: number of bytes to compress
+ *  out: pointer to room for len + len/64 + 32 bytes (a group of more than
+ *       127 literals may cost one byte more than it covers)
+ *
+ *  returns: the length of the compressed bytes
+ */
+static size_t encode(const unsigned char* restrict in, const size_t len,
+                     unsigned char* restrict out) {
+  size_t i = 0, o = 0, z, l;
+  while (i < len) {
+    for (z = i; z < len && in[z] == 0; z++);
+    for (l = z; l < len && (in[l] != 0 || (l+1 < len && in[l+1] != 0)); l++);
+    o += putVarint(out + o, z - i);
+    o += putVarint(out + o, l - z);
+    memcpy(out + o, in + z, l - z);
+    o += l - z;
+    i = l;
+  }
+  return o;
+}
+
+
+
+/*
+ * Function decode
+ * ---------------
+ *  Decompress the bytes of a checkpoint into a board (keyframes) or XOR them
+ *  into the previous one (deltas)
+ *
+ *  in: pointer to the first compressed byte
+ *  len: number of compressed bytes
+ *  out: pointer to the first byte of the board
+ *  total: number of bytes of the board
+ *  key: whether the checkpoint is a keyframe
+ */
+static void decode(const unsigned char* restrict in, const size_t len,
+                   unsigned char* restrict out, const size_t total,
+                   const int key) {
+  unsigned long long zeros, literals;
+  size_t i = 0, o = 0, b;
+  if (key) {
+    memset(out, 0, total);
+  }
+  while (i < len) {
+    i += getVarint(in + i, &zeros);
+    i += getVarint(in + i, &literals);
+    o += zeros;
+    if (key) {
+      memcpy(out + o, in + i, literals);
+    } else {
+      for (b = 0; b < literals; b++) {
+        out[o + b] ^= in[i + b];
+      }
+    }
+    i += literals;
+    o += literals;
+  }
+}
+
+
+
+/*
+ * Function putVarint
+ * ------------------
+ *  Write a varint to a buffer
+ *
+ *  p: pointer to the first byte to write
+ *  v: value to write
+ *
+ *  returns: the number of bytes written
+ */
+static inline size_t putVarint(unsigned char* restrict p,
+                               unsigned long long v) {
+  size_t k = 0;
+  while (v >= 0x80) {
+    p[k++] = (unsigned char) (v | 0x80);
+    v >>= 7;
+  }
+  p[k++] = (unsigned char) v;
+  return k;
+}
+
+
+
+/*
+ * Function getVarint
+ * ------------------
+ *  Read a varint from a buffer
+ *
+ *  p: pointer to the first byte to read
+ *  v: where to store the value
+ *
+ *  returns: the number of bytes read
+ */
+static inline size_t getVarint(const unsigned char* restrict p,
+                               unsigned long long* v) {
+  size_t k = 0;
+  int shift = 0;
+  *v = 0;
+  do {
+    *v |= (unsigned long long) (p[k] & 0x7F) << shift;
+    shift += 7;
+  } while (p[k++] & 0x80);
+  return k;
+}
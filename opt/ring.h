@@ -0,0 +1,70 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+
+/*
+ * Structure checkpoint
+ * --------------------
+ *  One compressed board of a snapshot ring
+ *
+ *  gen: generation of the board
+ *  key: whether it is a keyframe (the board itself) or a delta (its XOR with
+ *       the previous checkpoint)
+ *  data, len: compressed bit-packed board or delta (see ringPush)
+ */
+typedef struct checkpoint {
+  int gen;
+  int key;
+  unsigned char* data;
+  size_t len;
+} checkpoint_t;
+
+/*
+ * Structure ring
+ * --------------
+ *  Bounded-memory history of a run, for stepping back to earlier generations.
+ *  A checkpoint is taken every step generations and every interval-th
+ *  checkpoint is a keyframe. When the checkpoints take more than the budget,
+ *  the oldest keyframe is dropped together with the deltas that follow it,
+ *  so the window of reachable generations slides forward
+ *
+ *  n, m: dimensions of the board
+ *  words: 64-bit words per bit-packed row
+ *  step: generations between checkpoints
+ *  interval: checkpoints between keyframes
+ *  budget: bytes the checkpoints may take
+ *  cps: checkpoints, the window being cps[first] to cps[first+count-1]
+ *  cap: room of cps
+ *  bytes: bytes taken by the checkpoints of the window
+ *  sinceKey: checkpoints taken since the last keyframe
+ *  last: bit-packed board of the last checkpoint
+ *  packed: bit-packed board being encoded or decoded
+ *  buf: room for the worst case of an encoded board
+ *  taken, evicted: checkpoints taken and dropped so far
+ */
+typedef struct ring {
+  int n, m;
+  int words;
+  int step;
+  int interval;
+  size_t budget;
+  checkpoint_t* cps;
+  int first, count, cap;
+  size_t bytes;
+  int sinceKey;
+  unsigned long long* last;
+  unsigned long long* packed;
+  unsigned char* buf;
+  long long taken, evicted;
+} ring_t;
+
+void ringInit(ring_t* restrict rg, const int n, const int m,
+              const size_t budget, const int interval, const int step);
+void ringPush(ring_t* restrict rg, char** restrict mat, const int gen);
+int ringFirst(const ring_t* restrict rg);
+int ringRestore(ring_t* restrict rg, const int gen, char** restrict mat);
+void ringReport(const ring_t* restrict rg, const int last);
+void ringFree(ring_t* restrict rg);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <stdio.h>
+
+/*
+ * Structure machine
+ * -----------------
+ *  Ceilings of the host measured by machineMeasure
+ *
+ *  bandwidth: sustainable memory bandwidth (bytes per second)
+ *  intRate: peak byte-wide integer throughput (operations per second)
+ */
+typedef struct machine {
+  double bandwidth;
+  double intRate;
+} machine_t;
+
+void machineMeasure(machine_t* restrict mc);
+void rooflineReport(FILE* f, const machine_t* restrict mc,
+                    const char* kernel, const double bytes, const double ops,
+                    const double updates, const double seconds);
+
+#endif
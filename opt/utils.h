@@ -5,7 +5,10 @@ void printMatrix(char** restrict mat, const int nRows, const int nCols);
 char** allocateMatrix(const int nRows, const int nCols);
 void freeMatrix(char** restrict mat, const int nRows, const int nCols);
 void createInitialState(char** restrict mat, const int nRows, const int nCols,
-                        const double prob);
+                        const double prob, const unsigned long long seed);
+void createInitialRow(char* restrict row, const int m, const double prob,
+                      const unsigned long long seed, const int i);
 double get_wall_seconds();
+long get_peak_rss();
 
 #endif
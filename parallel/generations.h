@@ -0,0 +1,52 @@
+#ifndef GENERATIONS_H
+#define GENERATIONS_H
+
+#include "gol.h"
+
+// Largest number of states of a rule (four bits per cell)
+#define GENS_MAX_STATES 16
+
+/*
+ * Structure gens
+ * --------------
+ *  Torus of a multi-state "Generations" automaton. State 0 is dead, 1 alive
+ *  and 2 to states-1 are the refractory states a dying cell goes through
+ *  before it is dead again. Only alive cells count as neighbors, and only
+ *  dead cells can be born
+ *
+ *  Cells take 2 bits (up to 4 states) or 4 bits (up to 16 states), stored
+ *  bit-sliced: every row is made of bits planes of words words, plane p
+ *  holding bit p of the state of 64 cells per word. The padding bits of the
+ *  last word of every plane are always zero
+ *
+ *  n, m: dimensions of the torus
+ *  states: number of states of the rule
+ *  bits: bits (planes) per cell
+ *  words: words per plane of a row
+ *  born: bit c set if a dead cell with c alive neighbors is born
+ *  survive: bit c set if an alive cell with c alive neighbors survives
+ *  cells: current generation (n rows of bits * words words)
+ *  next: scratch buffer for the next generation (same shape as cells)
+ */
+typedef struct gens {
+  int n, m;
+  int states;
+  int bits;
+  int words;
+  unsigned born, survive;
+  unsigned long long* restrict cells;
+  unsigned long long* restrict next;
+} gens_t;
+
+int gensParseRule(const char* rule, unsigned* born, unsigned* survive,
+                  int* states);
+void gensInit(gens_t* restrict g, const int n, const int m,
+              const unsigned born, const unsigned survive, const int states);
+void gensLoadRow(gens_t* restrict g, const int i, const char* restrict row);
+void gensEvolve(gens_t* restrict g, const int nSteps, const int nThreads,
+                const tdata_t* restrict threadData);
+void gensCount(const gens_t* restrict g, long long* restrict counts);
+void gensPrint(const gens_t* restrict g);
+void gensFree(gens_t* restrict g);
+
+#endif
@@ -1,19 +1,61 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <omp.h>
+#include "alloc.h"
+#include "generations.h"
 #include "gol.h"
+#include "noise.h"
+#include "pyramid.h"
+#include "stats.h"
 #include "utils.h"
 
 
 
 // Static function declarations
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field);
-
-
-char** restrict state; // State at even times (0, 2, 4, etc.)
-char** restrict other; // State at odd times (1, 3, 5, etc.)
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts);
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, const int nThreads,
+                       const tdata_t* restrict threadData, const int tid,
+                       unsigned long long* restrict hash,
+                       stats_t* restrict st, char* restrict colSum,
+                       const noise_t* restrict noise, const int gen);
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              const int nThreads,
+                              const tdata_t* restrict threadData,
+                              const int tid, unsigned long long* restrict hash,
+                              stats_t* restrict st, char* restrict colSum,
+                              char* restrict rows);
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m);
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum);
+static unsigned long long hashBand(char** restrict mat, const int n,
+                                   const int m, const int nThreads,
+                                   const tdata_t* restrict threadData,
+                                   const int tid);
+static inline unsigned long long combineHash(const int nThreads,
+                                             const tdata_t* restrict threadData,
+                                             const int slot);
+static inline int allSame(const int nThreads,
+                          const tdata_t* restrict threadData);
+static void statsBand(stats_t* restrict st, char** restrict mat, const int n,
+                      const int m, const int nThreads,
+                      const tdata_t* restrict threadData, const int tid);
+static void combineStats(stats_t* restrict st, const int nThreads,
+                         const tdata_t* restrict threadData, const int slot);
+static inline char decide(const char alive, const char field);
+
+
+char** restrict state; // Current state
+char** restrict other; // Scratch buffer for the next state
 tdata_t* restrict threadData;  // Data for the threads to operate
 
 
@@ -24,8 +66,38 @@ int main(int argc, char const *argv[]) {
   double t1 = get_wall_seconds();
 
   // Check that arguments are provided
-  if (argc != 8) {
-    printf("Usage: %s n m prob nSteps seed nThreads debug\n", argv[0]);
+  options_t opts;
+  if (argc < 8 || parseOptions(argc, argv, &opts) != 0) {
+    printf("Usage: %s n m prob nSteps seed nThreads debug [options]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -cycles     stop computing once the board repeats itself\n");
+    printf("  -alloc mode grid allocation: legacy (one malloc per row), aligned\n"
+           "              (default), huge (MAP_HUGETLB) or thp (madvise)\n");
+    printf("  -stats file write population, births, deaths and bounding box of every\n"
+           "              generation to file (not with -cycles)\n");
+    printf("  -separable  compute neighbor counts from vertical column sums reused by a\n"
+           "              horizontal sliding window\n");
+    printf("  -inplace    update a single grid in place with a few rolling rows per\n"
+           "              thread instead of a second grid (half the memory)\n");
+    printf("  -footprint  report peak RSS and cell updates per second\n");
+    printf("  -pyramid prefix\n"
+           "              write the overview pyramid of the final state as\n"
+           "              prefix.<level>.pgm images (block density per pixel)\n");
+    printf("  -view level row col height width\n"
+           "              print the live cell counts of a viewport of the final state\n"
+           "              at a zoom level (blocks of 2^level x 2^level cells)\n");
+    printf("  -rule rule  run a multi-state Generations rule in B/S/C notation, e.g.\n"
+           "              B2/S/C3 (Brian's Brain) or B2/S345/C4 (Star Wars), with 2 or\n"
+           "              4 bits per cell; only combinable with -footprint\n");
+    printf("  -noise pb ps\n"
+           "              stochastic Life: births happen with probability pb and\n"
+           "              survivals with probability ps, drawn per cell from a\n"
+           "              counter-based generator keyed by (seed, generation, cell), so\n"
+           "              runs match across backends and thread counts; not with\n"
+           "              -cycles, -separable, -inplace or -rule\n");
+    printf("  -hash every print the hash of generation 0, of every generation multiple\n"
+           "              of every (0 for none) and of the final one, to compare the\n"
+           "              backends (see results/verify.py); not with -cycles or -rule\n");
     return -1;
   }
 
@@ -46,15 +118,8 @@ int main(int argc, char const *argv[]) {
   }
 
   // Initialize arbitrary seed for random numbers (or not!)
-  if (seed < 0) {
-    srand(time(NULL));
-  } else {
-    srand((unsigned int) seed);
-  }
-
-  // Initialize data structures
-  state = allocateMatrix(n, m);
-  other = allocateMatrix(n, m);
+  const unsigned long long key = seed < 0 ? (unsigned long long) time(NULL)
+                                          : (unsigned long long) seed;
 
   // Prepare data for threads
   threadData = (tdata_t*) malloc(nThreads*sizeof(tdata_t));
@@ -71,8 +136,61 @@ int main(int argc, char const *argv[]) {
     threadData[i].i1 = remainder + (i+1)*elePerThread + 1;
   }
 
+  // Multi-state rules have their own storage, filled one row at a time
+  if (opts.rule != NULL) {
+    gens_t g;
+    long long counts[GENS_MAX_STATES];
+    char* row = (char*) malloc(m * sizeof(char));
+    gensInit(&g, n, m, opts.born, opts.survive, opts.states);
+    for (i = 0; i < n; i++) {
+      createInitialRow(row, m, prob, key, i);
+      gensLoadRow(&g, i, row);
+    }
+    free(row);
+
+    if (debug) {
+      printf("Initial state:\n");
+      gensPrint(&g);
+    }
+
+    double t2 = get_wall_seconds();
+    gensEvolve(&g, nSteps, nThreads, threadData);
+    t2 = get_wall_seconds() - t2;
+
+    if (debug) {
+      printf("Final state:\n");
+      gensPrint(&g);
+    }
+    gensCount(&g, counts);
+    fprintf(stderr, "Generations: rule %s, %d states, %d bits per cell, "
+            "%lld alive, %lld refractory\n", opts.rule, g.states, g.bits,
+            counts[1], (long long) n * m - counts[0] - counts[1]);
+    if (opts.footprint) {
+      fprintf(stderr, "Footprint: %d bits per cell, peak RSS %ld kB, %.3e "
+              "cell updates per second\n", g.bits, get_peak_rss(),
+              (double) n * m * nSteps / t2);
+    }
+    gensFree(&g);
+    free(threadData);
+
+    t1 = get_wall_seconds() - t1;
+    if (debug) {
+      printf("Execution took %lf seconds\n", t1);
+    } else {
+      printf("%lf\n", t1);
+    }
+    return 0;
+  }
+
+  // Initialize data structures
+  if (opts.alloc >= 0) {
+    setAllocMode(opts.alloc);
+  }
+  state = allocateMatrix(n, m);
+  other = opts.inPlace ? NULL : allocateMatrix(n, m);
+
   // Create initial state
-  createInitialState(state, n, m, prob);
+  createInitialState(state, n, m, prob, key);
 
   // Print initial state
   if (debug) {
@@ -81,7 +199,35 @@ int main(int argc, char const *argv[]) {
   }
 
   // Evolve the system
-  evolve(n, m, nSteps, nThreads, threadData);
+  history_t hist;
+  if (opts.cycles) {
+    historyInit(&hist, n, m);
+  }
+  FILE* series = NULL;
+  if (opts.stats != NULL && (series = fopen(opts.stats, "w")) == NULL) {
+    printf("Cannot create %s\n", opts.stats);
+    return -1;
+  }
+  noise_t noise;
+  if (opts.noise) {
+    noiseInit(&noise, key, opts.pBirth, opts.pSurvive);
+  }
+  double t2 = get_wall_seconds();
+  evolve(n, m, nSteps, nThreads, threadData, opts.cycles ? &hist : NULL,
+         series, opts.noise ? &noise : NULL, opts.separable, opts.hash);
+  t2 = get_wall_seconds() - t2;
+  if (opts.footprint) {
+    fprintf(stderr, "Footprint: %s, peak RSS %ld kB, %.3e cell updates per "
+            "second\n", opts.inPlace ? "in place" : "two grids",
+            get_peak_rss(), (double) n * m * nSteps / t2);
+  }
+  if (opts.cycles) {
+    historyReport(&hist);
+    historyFree(&hist);
+  }
+  if (series != NULL) {
+    fclose(series);
+  }
 
   // Print final state
   if (debug) {
@@ -89,11 +235,36 @@ int main(int argc, char const *argv[]) {
     printMatrix(state, n, m);
   }
 
+  // Build the overview of the final state when it is needed
+  if (opts.pyramid != NULL || opts.view[0] >= 0) {
+    pyramid_t pyr;
+    double t2 = get_wall_seconds();
+    pyramidBuild(&pyr, state, n, m, nThreads);
+    t2 = get_wall_seconds() - t2;
+    fprintf(stderr, "Pyramid: %d levels down to %d x %d, built in %lf seconds\n",
+            pyr.nLevels, pyr.rows[pyr.nLevels-1], pyr.cols[pyr.nLevels-1], t2);
+    if (opts.view[0] >= 0) {
+      pyramidPrintView(&pyr, state, opts.view[0], opts.view[1], opts.view[2],
+                       opts.view[3], opts.view[4]);
+    }
+    if (opts.pyramid != NULL && pyramidWrite(&pyr, opts.pyramid) != 0) {
+      fprintf(stderr, "Cannot write the pyramid images to %s\n", opts.pyramid);
+    }
+    pyramidFree(&pyr);
+  }
+
   // Free data structures
   freeMatrix(state, n, m);
-  freeMatrix(other, n, m);
+  if (other != NULL) {
+    freeMatrix(other, n, m);
+  }
   free(threadData);
 
+  // Report how the grids were allocated
+  if (debug || opts.alloc >= 0) {
+    allocReport(stderr);
+  }
+
   // Print time it took to run the code
   t1 = get_wall_seconds() - t1;
   if (debug) {
@@ -107,6 +278,105 @@ int main(int argc, char const *argv[]) {
 
 
 
+/*
+ * Function parseOptions
+ * ---------------------
+ *  Parse the optional flags given after the positional arguments
+ *
+ *  argc: number of command line arguments
+ *  argv: command line arguments
+ *  opts: pointer to the structure to fill
+ *
+ *  returns: 0 on success, -1 if an option is not recognized
+ */
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts) {
+  int a;
+  opts->cycles = 0;
+  opts->alloc = -1;
+  opts->stats = NULL;
+  opts->separable = 0;
+  opts->inPlace = 0;
+  opts->footprint = 0;
+  opts->pyramid = NULL;
+  opts->view[0] = -1;
+  opts->rule = NULL;
+  opts->noise = 0;
+  opts->hash = -1;
+  for (a = 8; a < argc; a++) {
+    if (strcmp(argv[a], "-cycles") == 0) {
+      opts->cycles = 1;
+    } else if (strcmp(argv[a], "-separable") == 0) {
+      opts->separable = 1;
+    } else if (strcmp(argv[a], "-inplace") == 0) {
+      opts->inPlace = 1;
+    } else if (strcmp(argv[a], "-footprint") == 0) {
+      opts->footprint = 1;
+    } else if (strcmp(argv[a], "-alloc") == 0 && a+1 < argc) {
+      opts->alloc = parseAllocMode(argv[++a]);
+      if (opts->alloc < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-stats") == 0 && a+1 < argc) {
+      opts->stats = argv[++a];
+    } else if (strcmp(argv[a], "-rule") == 0 && a+1 < argc) {
+      opts->rule = argv[++a];
+      if (gensParseRule(opts->rule, &opts->born, &opts->survive,
+                        &opts->states) != 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-noise") == 0 && a+2 < argc) {
+      opts->noise = 1;
+      opts->pBirth = atof(argv[++a]);
+      opts->pSurvive = atof(argv[++a]);
+      if (opts->pBirth < 0 || opts->pBirth > 1 || opts->pSurvive < 0
+          || opts->pSurvive > 1) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-hash") == 0 && a+1 < argc) {
+      opts->hash = atoi(argv[++a]);
+      if (opts->hash < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-pyramid") == 0 && a+1 < argc) {
+      opts->pyramid = argv[++a];
+    } else if (strcmp(argv[a], "-view") == 0 && a+5 < argc) {
+      int v;
+      for (v = 0; v < 5; v++) {
+        opts->view[v] = atoi(argv[++a]);
+      }
+      if (opts->view[0] < 0) {
+        return -1;
+      }
+    } else {
+      return -1;
+    }
+  }
+  // The series holds every generation, which -cycles stops computing once
+  // the board repeats
+  if (opts->stats != NULL && opts->cycles) {
+    return -1;
+  }
+  // Multi-state rules only have the plain torus evolution
+  if (opts->rule != NULL && (opts->cycles || opts->stats != NULL
+                             || opts->separable || opts->inPlace
+                             || opts->pyramid != NULL || opts->view[0] >= 0)) {
+    return -1;
+  }
+  // The stochastic rule only has the direct kernel with two grids
+  if (opts->noise && (opts->cycles || opts->separable || opts->inPlace
+                      || opts->rule != NULL)) {
+    return -1;
+  }
+  // Checkpoints are generations of the Game of Life actually computed
+  if (opts->hash >= 0 && (opts->cycles || opts->rule != NULL)) {
+    return -1;
+  }
+  return 0;
+}
+
+
+
 /*
  * Function evolve
  * ---------------
@@ -114,279 +384,474 @@ int main(int argc, char const *argv[]) {
  *
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
- *  nSteps: number of iterations (assumed to be even)
+ *  nSteps: number of iterations
  *  nThreads: number of threads
  *  threadData: pointer to the first element of the array containing thread data
+ *  hist: pointer to the cycle detector, or NULL to evolve blindly. When the
+ *        board enters a cycle, only the generations needed to reach the
+ *        state at nSteps modulo the period are computed
+ *  series: stream where the statistics of every generation are written as a
+ *          time series by thread 0, or NULL to skip them
+ *  noise: stochastic rule, or NULL for the Game of Life
+ *  separable: use the separable kernel (see evolveRowSeparable)
+ *  every: print the hash of generation 0, of every generation multiple of
+ *         every (if positive) and of the final one (see hashReport), or -1
+ *         to print none. The partial hashes of the checkpoints are taken
+ *         like those of the cycle detector and combined by thread 0
+ *
+ *  When other is NULL the board is updated in place (see generationInPlace)
  */
 void evolve(const int n, const int m, const int nSteps, const int nThreads,
-            tdata_t* restrict threadData) {
-  int k, i, j;
-  char field;
+            tdata_t* restrict threadData, history_t* restrict hist,
+            FILE* series, const noise_t* restrict noise,
+            const int separable, const int every) {
+  int k;
   int tid;
+  int last;
+  int report;
+  history_t local;  // Private copy of the cycle detector
+  stats_t st;  // Combined statistics (thread 0)
+  const int inPlace = other == NULL;
 
-  #pragma omp parallel num_threads(nThreads) private(field, k, i, j, tid)
+  #pragma omp parallel num_threads(nThreads) private(k, tid, last, report, local)
   {
-
     tid = omp_get_thread_num();
+    last = nSteps;
+    // Rows of the thread, as in generation
+    const int first = tid == 0 ? 0 : threadData[tid].i0;
+    const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+    char* restrict colSum = separable ? (char*) malloc(m+2) : NULL;
+    char* restrict rows = inPlace ? (char*) malloc(4 * (size_t) m) : NULL;
+
+    if (hist != NULL || every >= 0) {
+      threadData[tid].hash[0] = hashBand(state, n, m, nThreads, threadData,
+                                         tid);
+      #pragma omp barrier
+      if (hist != NULL) {
+        local = *hist;
+        historyCheck(&local, combineHash(nThreads, threadData, 0), 0);
+      }
+      if (every >= 0 && tid == 0) {
+        hashReport(0, combineHash(nThreads, threadData, 0));
+      }
+    }
 
-    if (tid == 0) {
-      for (k = 0; k < nSteps; k+=2) {
-
-        // FIRST ITERATION
-        {
-        // First row (i=0)
-          // First column (j=0)
-          field = state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                      + state[0][m-1] + state[0][0] + state[0][1]
-                      + state[1][m-1] + state[1][0] + state[1][1];
-          decide(state[0][0], other, 0, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = state[n-1][j-1] + state[n-1][j] + state[n-1][j+1]
-                        + state[0][j-1] + state[0][j] + state[0][j+1]
-                        + state[1][j-1] + state[1][j] + state[1][j+1];
-            decide(state[0][j], other, 0, j, field);
-          }
-          // Last column (j=m-1)
-          field = state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                      + state[0][m-2] + state[0][m-1] + state[0][0]
-                      + state[1][m-2] + state[1][m-1] + state[1][0];
-          decide(state[0][m-1], other, 0, m-1, field);
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                      + state[i][m-1] + state[i][0] + state[i][1]
-                      + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-          decide(state[i][0], other, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                        + state[i][j-1] + state[i][j] + state[i][j+1]
-                        + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-            decide(state[i][j], other, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                      + state[i][m-2] + state[i][m-1] + state[i][0]
-                      + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-          decide(state[i][m-1], other, i, m-1, field);
-        }
+    if (series != NULL) {
+      statsBand(&threadData[tid].stats[0], state, n, m, nThreads, threadData,
+                tid);
+      #pragma omp barrier
+      if (tid == 0) {
+        combineStats(&st, nThreads, threadData, 0);
+        statsWrite(series, 0, &st);
+      }
+    }
 
-        }
+    for (k = 0; k < last; k++) {
+      report = every >= 0
+               && (k+1 == nSteps || (every > 0 && (k+1) % every == 0));
+
+      // Generation k goes from state to other when k is even, and back when odd
+      if (inPlace) {
+        generationInPlace(state, n, m, nThreads, threadData, tid,
+                          hist != NULL || report
+                          ? &threadData[tid].hash[(k+1)%2] : NULL,
+                          series != NULL ? &threadData[tid].stats[(k+1)%2]
+                                         : NULL, colSum, rows);
+      } else if (k % 2 == 0) {
+        generation(state, other, n, m, nThreads, threadData, tid,
+                   hist != NULL || report ? &threadData[tid].hash[1] : NULL,
+                   series != NULL ? &threadData[tid].stats[1] : NULL, colSum,
+                   noise, k);
+      } else {
+        generation(other, state, n, m, nThreads, threadData, tid,
+                   hist != NULL || report ? &threadData[tid].hash[0] : NULL,
+                   series != NULL ? &threadData[tid].stats[0] : NULL, colSum,
+                   noise, k);
+      }
 
-        #pragma omp barrier
-
-        // SECOND ITERATION
-        {
-        // First row (i=0)
-          // First column (j=0)
-          field = other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                      + other[0][m-1] + other[0][0] + other[0][1]
-                      + other[1][m-1] + other[1][0] + other[1][1];
-          decide(other[0][0], state, 0, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = other[n-1][j-1] + other[n-1][j] + other[n-1][j+1]
-                        + other[0][j-1] + other[0][j] + other[0][j+1]
-                        + other[1][j-1] + other[1][j] + other[1][j+1];
-            decide(other[0][j], state, 0, j, field);
-          }
-          // Last column (j=m-1)
-          field = other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                      + other[0][m-2] + other[0][m-1] + other[0][0]
-                      + other[1][m-2] + other[1][m-1] + other[1][0];
-          decide(other[0][m-1], state, 0, m-1, field);
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                      + other[i][m-1] + other[i][0] + other[i][1]
-                      + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-          decide(other[i][0], state, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                        + other[i][j-1] + other[i][j] + other[i][j+1]
-                        + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-            decide(other[i][j], state, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                      + other[i][m-2] + other[i][m-1] + other[i][0]
-                      + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-          decide(other[i][m-1], state, i, m-1, field);
-        }
+      #pragma omp barrier
 
+      // Thread 0 reduces the partial statistics while the others move on
+      if (series != NULL && tid == 0) {
+        const long long previous = st.population;
+        combineStats(&st, nThreads, threadData, (k+1)%2);
+        statsFinish(&st, previous);
+        statsWrite(series, k+1, &st);
+      }
+      if (report && tid == 0) {
+        hashReport(k+1, combineHash(nThreads, threadData, (k+1)%2));
+      }
+
+      // Every thread combines the partial hashes itself and takes the same
+      // decision, so no further synchronization is needed. Partial hashes are
+      // double buffered because the next generation overwrites the other slot.
+      // A proposed period is checked on the cells: every thread holds and
+      // compares its own rows, and the verdicts are combined after a barrier
+      if (hist != NULL && local.period == 0) {
+        char** restrict board = inPlace || k % 2 == 1 ? state : other;
+        if (historyDue(&local, k+1)) {
+          threadData[tid].same = historySame(&local, board, first, end, m);
+          #pragma omp barrier
+          historyConfirm(&local, k+1, allSame(nThreads, threadData));
         }
+        const int period = historyCheck(&local,
+                                        combineHash(nThreads, threadData, (k+1)%2),
+                                        k+1);
+        if (period == 0 && local.held == k+1) {
+          historyHold(&local, board, first, end, m);
+        }
+        if (period != 0) {
+          last = k+1 + (nSteps - (k+1)) % period;
+        }
+      }
 
-        #pragma omp barrier
+    }
+
+    free(colSum);
+    free(rows);
 
+    // Leave the final state in state
+    #pragma omp single
+    {
+      if (last % 2 == 1 && !inPlace) {
+        char** restrict tmp = state;
+        state = other;
+        other = tmp;
       }
-    } else if (tid == nThreads-1) {
-      for (k = 0; k < nSteps; k+=2) {
-
-        // FIRST ITERATION
-        {
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                      + state[i][m-1] + state[i][0] + state[i][1]
-                      + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-          decide(state[i][0], other, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                        + state[i][j-1] + state[i][j] + state[i][j+1]
-                        + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-            decide(state[i][j], other, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                      + state[i][m-2] + state[i][m-1] + state[i][0]
-                      + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-          decide(state[i][m-1], other, i, m-1, field);
-        }
+      if (hist != NULL) {
+        *hist = local;
+      }
+    }
+  }
+}
 
-        // Last row (i=n-1)
-          // First column (j=0)
-          field = state[n-2][m-1] + state[n-2][0] + state[n-2][1]
-                      + state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                      + state[0][m-1] + state[0][0] + state[0][1];
-          decide(state[n-1][0], other, n-1, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = state[n-2][j-1] + state[n-2][j] + state[n-2][j+1]
-                        + state[n-1][j-1] + state[n-1][j]  + state[n-1][j+1]
-                        + state[0][j-1] + state[0][j] + state[0][j+1];
-            decide(state[n-1][j], other, n-1, j, field);
-          }
-          // Last column (j=m-1)
-          field = state[n-2][m-2] + state[n-2][m-1] + state[n-2][0]
-                      + state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                      + state[0][m-2] + state[0][m-1] + state[0][0];
-          decide(state[n-1][m-1], other, n-1, m-1, field);
 
-        }
 
-        #pragma omp barrier
-
-        // SECOND ITERATION
-        {
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                      + other[i][m-1] + other[i][0] + other[i][1]
-                      + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-          decide(other[i][0], state, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                        + other[i][j-1] + other[i][j] + other[i][j+1]
-                        + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-            decide(other[i][j], state, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                      + other[i][m-2] + other[i][m-1] + other[i][0]
-                      + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-          decide(other[i][m-1], state, i, m-1, field);
-        }
+/*
+ * Function generation
+ * -------------------
+ *  Compute the rows of one generation that belong to a thread
+ *
+ *  cur: pointer to the first element of the current state matrix
+ *  next: pointer to the first element of the future state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ *  hash: where to store the partial hash of the rows of the thread (NULL to
+ *        skip it)
+ *  st: where to store the partial statistics of the rows of the thread (NULL
+ *      to skip them)
+ *  colSum: scratch row of m+2 elements of the thread for the separable
+ *          kernel (NULL for the direct one)
+ *  noise: stochastic rule (NULL for the Game of Life)
+ *  gen: generation of cur (keys the draws of the stochastic rule)
+ *
+ *  Hashes and statistics are taken from every row right after it is
+ *  computed, while it is still in cache
+ */
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, const int nThreads,
+                       const tdata_t* restrict threadData, const int tid,
+                       unsigned long long* restrict hash,
+                       stats_t* restrict st, char* restrict colSum,
+                       const noise_t* restrict noise, const int gen) {
+  int i;
+  unsigned long long h = 0;
+
+  // Rows i0 to i1 of the thread, plus the first row (i=0) for the first
+  // thread and the last row (i=n-1) for the last one (both if there is just
+  // 1 thread!)
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+
+  if (st != NULL) statsInit(st);
+
+  for (i = first; i < end; i++) {
+    // Rows above and below, wrapping around the first and last rows
+    const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+    const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+    if (noise != NULL) {
+      noiseRow(noise, gen, i, up, cur[i], down, next[i], m);
+    } else if (colSum != NULL) {
+      evolveRowSeparable(up, cur[i], down, next[i], m, colSum);
+    } else {
+      evolveRow(up, cur[i], down, next[i], m);
+    }
+    if (hash != NULL) h += hashRow(next[i], m, i);
+    if (st != NULL) statsRow(st, cur[i], next[i], m, i);
+  }
 
-        // Last row (i=n-1)
-          // First column (j=0)
-          field = other[n-2][m-1] + other[n-2][0] + other[n-2][1]
-                      + other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                      + other[0][m-1] + other[0][0] + other[0][1];
-          decide(other[n-1][0], state, n-1, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = other[n-2][j-1] + other[n-2][j] + other[n-2][j+1]
-                        + other[n-1][j-1] + other[n-1][j]  + other[n-1][j+1]
-                        + other[0][j-1] + other[0][j] + other[0][j+1];
-            decide(other[n-1][j], state, n-1, j, field);
-          }
-          // Last column (j=m-1)
-          field = other[n-2][m-2] + other[n-2][m-1] + other[n-2][0]
-                      + other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                      + other[0][m-2] + other[0][m-1] + other[0][0];
-          decide(other[n-1][m-1], state, n-1, m-1, field);
+  if (hash != NULL) *hash = h;
+}
 
-        }
 
-        #pragma omp barrier
 
-      }
+/*
+ * Function generationInPlace
+ * --------------------------
+ *  Compute the rows of one generation that belong to a thread, overwriting
+ *  the current state. Every thread first copies the rows just above and
+ *  below its band, which its neighbors are about to overwrite. Inside the
+ *  band a new row is computed into a scratch row and only written back once
+ *  the next row has been computed, since that one still needs the old
+ *  version. Four scratch rows per thread replace the second grid
+ *
+ *  mat: pointer to the first element of the state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads, threadData, tid, hash, st, colSum: as in generation
+ *  rows: scratch space for four rows of the thread
+ */
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              const int nThreads,
+                              const tdata_t* restrict threadData,
+                              const int tid, unsigned long long* restrict hash,
+                              stats_t* restrict st, char* restrict colSum,
+                              char* restrict rows) {
+  int i;
+  unsigned long long h = 0;
+  char* restrict above = rows;  // Old row above the band
+  char* restrict below = rows + m;  // Old row below the band
+  char* restrict pending[2] = {rows + 2*m, rows + 3*m};  // New rows i-1, i
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+
+  if (st != NULL) statsInit(st);
+
+  if (first < end) {
+    memcpy(above, mat[first == 0 ? n-1 : first-1], m);
+    memcpy(below, mat[end == n ? 0 : end], m);
+  }
+  #pragma omp barrier
+
+  for (i = first; i < end; i++) {
+    const char* restrict up = i == first ? above : mat[i-1];
+    const char* restrict down = i == end-1 ? below : mat[i+1];
+    char* restrict out = pending[i%2];
+    if (colSum != NULL) {
+      evolveRowSeparable(up, mat[i], down, out, m, colSum);
     } else {
-      for (k = 0; k < nSteps; k+=2) {
-
-        // FIRST ITERATION
-        {
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                      + state[i][m-1] + state[i][0] + state[i][1]
-                      + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-          decide(state[i][0], other, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                        + state[i][j-1] + state[i][j] + state[i][j+1]
-                        + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-            decide(state[i][j], other, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                      + state[i][m-2] + state[i][m-1] + state[i][0]
-                      + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-          decide(state[i][m-1], other, i, m-1, field);
-        }
+      evolveRow(up, mat[i], down, out, m);
+    }
+    if (hash != NULL) h += hashRow(out, m, i);
+    if (st != NULL) statsRow(st, mat[i], out, m, i);
+    // The old row i-1 is not needed anymore
+    if (i > first) {
+      memcpy(mat[i-1], pending[(i-1)%2], m);
+    }
+  }
+  if (first < end) {
+    memcpy(mat[end-1], pending[(end-1)%2], m);
+  }
 
-        }
+  if (hash != NULL) *hash = h;
+}
 
-        #pragma omp barrier
-
-        // SECOND ITERATION
-        {
-
-        // Other rows (i=1 to n-2) - Note the separation for each thread
-        for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-          // First column (j=0)
-          field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                      + other[i][m-1] + other[i][0] + other[i][1]
-                      + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-          decide(other[i][0], state, i, 0, field);
-          // Other columns (j=1 to m-2)
-          for (j=1; j <= m - 2; j++) {
-            field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                        + other[i][j-1] + other[i][j] + other[i][j+1]
-                        + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-            decide(other[i][j], state, i, j, field);
-          }
-          // Last column (j=m-1)
-          field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                      + other[i][m-2] + other[i][m-1] + other[i][0]
-                      + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-          decide(other[i][m-1], state, i, m-1, field);
-        }
 
-        }
 
-        #pragma omp barrier
+/*
+ * Function evolveRow
+ * ------------------
+ *  Compute the future state of one row of the torus
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ */
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m) {
+  int j;
+  char field;
+  // First column (j=0)
+  field = up[m-1] + up[0] + up[1]
+              + mid[m-1] + mid[0] + mid[1]
+              + down[m-1] + down[0] + down[1];
+  out[0] = decide(mid[0], field);
+  // Other columns (j=1 to m-2)
+  for (j = 1; j <= m - 2; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+                + mid[j-1] + mid[j] + mid[j+1]
+                + down[j-1] + down[j] + down[j+1];
+    out[j] = decide(mid[j], field);
+  }
+  // Last column (j=m-1)
+  field = up[m-2] + up[m-1] + up[0]
+              + mid[m-2] + mid[m-1] + mid[0]
+              + down[m-2] + down[m-1] + down[0];
+  out[m-1] = decide(mid[m-1], field);
+}
 
-      }
-    }
 
+
+/*
+ * Function evolveRowSeparable
+ * ---------------------------
+ *  Compute the future state of one row of the torus from column sums: the
+ *  three rows are first added vertically, once per column, and the field of
+ *  every cell is the sum of three neighboring column sums. That is three
+ *  loads per cell instead of nine, and both loops vectorize
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ *  colSum: scratch row of m+2 elements
+ */
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum) {
+  int j;
+  // Column sums, shifted by one so the wrapped columns fit at both ends
+  for (j = 0; j < m; j++) {
+    colSum[j+1] = up[j] + mid[j] + down[j];
+  }
+  colSum[0] = colSum[m];
+  colSum[m+1] = colSum[1];
+  // Horizontal window over the column sums
+  for (j = 0; j < m; j++) {
+    out[j] = decide(mid[j], colSum[j] + colSum[j+1] + colSum[j+2]);
+  }
+}
+
+
+
+/*
+ * Function hashBand
+ * -----------------
+ *  Compute the partial hash of the rows that belong to a thread
+ *
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ *
+ *  returns: the partial hash
+ */
+static unsigned long long hashBand(char** restrict mat, const int n,
+                                   const int m, const int nThreads,
+                                   const tdata_t* restrict threadData,
+                                   const int tid) {
+  int i;
+  unsigned long long h = 0;
+  if (tid == 0) {
+    h += hashRow(mat[0], m, 0);
+  }
+  for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
+    h += hashRow(mat[i], m, i);
+  }
+  if (tid == nThreads-1) {
+    h += hashRow(mat[n-1], m, n-1);
+  }
+  return h;
+}
+
+
+
+/*
+ * Function combineHash
+ * --------------------
+ *  Combine the partial hashes of all threads into the hash of the board. The
+ *  sum does not depend on the order, so the result is the same for any
+ *  number of threads
+ *
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  slot: which of the two partial hashes of every thread to combine
+ *
+ *  returns: the hash of the board
+ */
+static inline unsigned long long combineHash(const int nThreads,
+                                             const tdata_t* restrict threadData,
+                                             const int slot) {
+  int t;
+  unsigned long long h = 0;
+  for (t = 0; t < nThreads; t++) {
+    h += threadData[t].hash[slot];
   }
+  return h;
+}
 
+
+
+/*
+ * Function allSame
+ * ----------------
+ *  Combine the verdicts of all threads on the board held by the cycle
+ *  detector (see historySame)
+ *
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *
+ *  returns: 1 if the rows of every thread matched, 0 otherwise
+ */
+static inline int allSame(const int nThreads,
+                          const tdata_t* restrict threadData) {
+  int t;
+  for (t = 0; t < nThreads; t++) {
+    if (!threadData[t].same) return 0;
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function statsBand
+ * ------------------
+ *  Compute the partial statistics of the rows that belong to a thread in the
+ *  initial state
+ *
+ *  st: where to store the partial statistics
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ */
+static void statsBand(stats_t* restrict st, char** restrict mat, const int n,
+                      const int m, const int nThreads,
+                      const tdata_t* restrict threadData, const int tid) {
+  int i;
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+  statsInit(st);
+  for (i = first; i < end; i++) {
+    statsRow(st, NULL, mat[i], m, i);
+  }
+}
+
+
+
+/*
+ * Function combineStats
+ * ---------------------
+ *  Reduce the partial statistics of all threads into the statistics of the
+ *  board
+ *
+ *  st: where to store the statistics of the board
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  slot: which of the two partial statistics of every thread to combine
+ */
+static void combineStats(stats_t* restrict st, const int nThreads,
+                         const tdata_t* restrict threadData, const int slot) {
+  int t;
+  statsInit(st);
+  for (t = 0; t < nThreads; t++) {
+    statsMerge(st, &threadData[t].stats[slot]);
+  }
 }
 
 
@@ -396,18 +861,16 @@ void evolve(const int n, const int m, const int nSteps, const int nThreads,
  *  Decide wether a cell lives or dies
  *
  *  alive: current state of the cell
- *  future: pointer to the first element of the future state matrix
- *  i: index for row
- *  j: index for column
  *  field: number of alive neighbors + the cell itself
+ *
+ *  returns: the future state of the cell
  */
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field) {
+static inline char decide(const char alive, const char field) {
   if (field == 3) {
-    future[i][j] = 1;
+    return 1;
   } else if (field == 4) {
-    future[i][j] = alive;
+    return alive;
   } else {
-    future[i][j] = 0;
+    return 0;
   }
 }
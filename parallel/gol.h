@@ -1,6 +1,49 @@
 #ifndef GOL_H
 #define GOL_H
 
+#include <stdio.h>
+#include "hash.h"
+#include "noise.h"
+#include "stats.h"
+
+/*
+ * Structure options
+ * -----------------
+ *  Optional flags given after the positional arguments
+ *
+ *  cycles: detect when the board repeats itself and skip to the final state
+ *  alloc: grid allocation strategy (-1 for the default one)
+ *  stats: path of the per-generation statistics (NULL if not requested)
+ *  separable: compute the fields from column sums (see evolveRowSeparable)
+ *  inPlace: update a single grid in place instead of two
+ *  footprint: report peak memory and throughput
+ *  pyramid: path prefix of the overview images (NULL if not requested)
+ *  view: level, first row, first column, height and width of the viewport
+ *        to print (level -1 if not requested)
+ *  rule: multi-state rule in B/S/C notation (NULL for the Game of Life)
+ *  born, survive, states: parsed rule (see gensParseRule)
+ *  noise: run the stochastic rule (see noise.h)
+ *  pBirth, pSurvive: probabilities of a birth and of a survival
+ *  hash: generations between printed hashes (0 for the first and final ones
+ *        only, -1 if not requested)
+ */
+typedef struct options {
+  int cycles;
+  int alloc;
+  const char* stats;
+  int separable;
+  int inPlace;
+  int footprint;
+  const char* pyramid;
+  int view[5];
+  const char* rule;
+  unsigned born, survive;
+  int states;
+  int noise;
+  double pBirth, pSurvive;
+  int hash;
+} options_t;
+
 /*
  * Structure tdata
  * ---------------
@@ -8,13 +51,22 @@
  *
  *  i0: starting index (inclusive)
  *  i1: ending index (exclusive)
+ *  hash: partial hashes of the rows of the thread (even/odd generations)
+ *  stats: partial statistics of the rows of the thread (even/odd generations)
+ *  same: whether the rows of the thread matched the board held by the cycle
+ *        detector (see historySame)
  */
 typedef struct tdata {
   int i0;  // Inclusive
   int i1;  // Exclusive
+  unsigned long long hash[2];
+  stats_t stats[2];
+  int same;
 } tdata_t;
 
 void evolve(const int n, const int m, const int nSteps, const int nThreads,
-            tdata_t* restrict threadData);
+            tdata_t* restrict threadData, history_t* restrict hist,
+            FILE* series, const noise_t* restrict noise,
+            const int separable, const int every);
 
 #endif
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pyramid.h"
+
+
+// Forward declaration of static methods
+static void halveBoard(char** restrict mat, const int n, const int m,
+                       unsigned int* restrict out, const int nThreads);
+static void halveLevel(const unsigned int* restrict in, const int rows,
+                       const int cols, unsigned int* restrict out,
+                       const int nThreads);
+static inline int blockArea(const pyramid_t* restrict pyr, const int level,
+                            const int r, const int c);
+
+
+
+/*
+ * Function pyramidBuild
+ * ---------------------
+ *  Build the overview pyramid of a board. Every level is computed in
+ *  parallel from the previous one, so the board is read only once
+ *
+ *  pyr: pointer to the pyramid to fill
+ *  mat: pointer to the first element of the board
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  nThreads: number of threads
+ */
+void pyramidBuild(pyramid_t* restrict pyr, char** restrict mat, const int n,
+                  const int m, const int nThreads) {
+  int l = 0;
+  pyr->n = n;
+  pyr->m = m;
+  pyr->rows[0] = n;
+  pyr->cols[0] = m;
+  pyr->counts[0] = NULL;
+  while ((pyr->rows[l] > PYRAMID_THUMB || pyr->cols[l] > PYRAMID_THUMB)
+         && l+1 < PYRAMID_LEVELS) {
+    l++;
+    pyr->rows[l] = (pyr->rows[l-1] + 1) / 2;
+    pyr->cols[l] = (pyr->cols[l-1] + 1) / 2;
+    pyr->counts[l] = (unsigned int*) malloc((size_t) pyr->rows[l]
+                                            * pyr->cols[l]
+                                            * sizeof(unsigned int));
+    if (l == 1) {
+      halveBoard(mat, n, m, pyr->counts[1], nThreads);
+    } else {
+      halveLevel(pyr->counts[l-1], pyr->rows[l-1], pyr->cols[l-1],
+                 pyr->counts[l], nThreads);
+    }
+  }
+  pyr->nLevels = l+1;
+}
+
+
+
+/*
+ * Function halveBoard
+ * -------------------
+ *  Count the live cells of every 2x2 block of the board. The two rows of a
+ *  block are added first, with unit stride, so the sums vectorize
+ *
+ *  mat: pointer to the first element of the board
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  out: where to store the (n+1)/2 x (m+1)/2 counts
+ *  nThreads: number of threads
+ */
+static void halveBoard(char** restrict mat, const int n, const int m,
+                       unsigned int* restrict out, const int nThreads) {
+  const int rows = (n + 1) / 2, cols = (m + 1) / 2;
+  int r;
+  #pragma omp parallel num_threads(nThreads)
+  {
+    unsigned char* restrict pair = (unsigned char*) malloc(m + 1);
+    int j, c;
+    #pragma omp for schedule(static)
+    for (r = 0; r < rows; r++) {
+      const char* restrict a = mat[2*r];
+      if (2*r+1 < n) {
+        const char* restrict b = mat[2*r+1];
+        for (j = 0; j < m; j++) {
+          pair[j] = a[j] + b[j];
+        }
+      } else {
+        for (j = 0; j < m; j++) {
+          pair[j] = a[j];
+        }
+      }
+      pair[m] = 0;  // Padding for an odd number of columns
+      unsigned int* restrict o = out + (size_t) r * cols;
+      for (c = 0; c < cols; c++) {
+        o[c] = pair[2*c] + pair[2*c+1];
+      }
+    }
+    free(pair);
+  }
+}
+
+
+
+/*
+ * Function halveLevel
+ * -------------------
+ *  Add the counts of every 2x2 block of a level to obtain the next one
+ *
+ *  in: pointer to the first count of the level
+ *  rows: number of rows of the level
+ *  cols: number of columns of the level
+ *  out: where to store the (rows+1)/2 x (cols+1)/2 counts
+ *  nThreads: number of threads
+ */
+static void halveLevel(const unsigned int* restrict in, const int rows,
+                       const int cols, unsigned int* restrict out,
+                       const int nThreads) {
+  const int outRows = (rows + 1) / 2, outCols = (cols + 1) / 2;
+  int r;
+  #pragma omp parallel for num_threads(nThreads) schedule(static)
+  for (r = 0; r < outRows; r++) {
+    const unsigned int* restrict a = in + (size_t) 2*r * cols;
+    const unsigned int* restrict b = 2*r+1 < rows ? a + cols : NULL;
+    unsigned int* restrict o = out + (size_t) r * outCols;
+    int c;
+    for (c = 0; c < cols/2; c++) {
+      o[c] = a[2*c] + a[2*c+1] + (b != NULL ? b[2*c] + b[2*c+1] : 0);
+    }
+    if (cols % 2 == 1) {
+      o[outCols-1] = a[cols-1] + (b != NULL ? b[cols-1] : 0);
+    }
+  }
+}
+
+
+
+/*
+ * Function pyramidView
+ * --------------------
+ *  Extract a rectangular viewport of one level. Only the rows of the level
+ *  inside the viewport are read, so the cost is proportional to the number
+ *  of pixels requested
+ *
+ *  pyr: pointer to the pyramid
+ *  mat: pointer to the first element of the board (read for level 0)
+ *  level: zoom level (0 is the board, every level halves the resolution)
+ *  r0, c0: first row and column of the viewport, in pixels of the level
+ *  h, w: height and width of the viewport, in pixels of the level
+ *  out: where to store the h x w live cell counts, row by row
+ *
+ *  returns: 0 on success, -1 if the viewport is not inside the level
+ */
+int pyramidView(const pyramid_t* restrict pyr, char** restrict mat,
+                const int level, const int r0, const int c0, const int h,
+                const int w, unsigned int* restrict out) {
+  int r, c;
+  if (level < 0 || level >= pyr->nLevels || r0 < 0 || c0 < 0 || h <= 0
+      || w <= 0 || r0 + h > pyr->rows[level] || c0 + w > pyr->cols[level]) {
+    return -1;
+  }
+  for (r = 0; r < h; r++) {
+    if (level == 0) {
+      const char* restrict row = mat[r0+r] + c0;
+      for (c = 0; c < w; c++) {
+        out[(size_t) r*w + c] = row[c];
+      }
+    } else {
+      const unsigned int* restrict row = pyr->counts[level]
+                                         + (size_t) (r0+r) * pyr->cols[level]
+                                         + c0;
+      for (c = 0; c < w; c++) {
+        out[(size_t) r*w + c] = row[c];
+      }
+    }
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function pyramidPrintView
+ * -------------------------
+ *  Print a viewport of one level to console, one row of counts per line
+ *
+ *  pyr: pointer to the pyramid
+ *  mat: pointer to the first element of the board
+ *  level, r0, c0, h, w: viewport, as in pyramidView
+ */
+void pyramidPrintView(const pyramid_t* restrict pyr, char** restrict mat,
+                      const int level, const int r0, const int c0,
+                      const int h, const int w) {
+  unsigned int* view = (unsigned int*) malloc((size_t) h * w
+                                              * sizeof(unsigned int));
+  int r, c;
+  if (pyramidView(pyr, mat, level, r0, c0, h, w, view) != 0) {
+    printf("Viewport outside level %d (%d x %d pixels, %d levels)\n", level,
+           level < pyr->nLevels && level >= 0 ? pyr->rows[level] : 0,
+           level < pyr->nLevels && level >= 0 ? pyr->cols[level] : 0,
+           pyr->nLevels);
+    free(view);
+    return;
+  }
+  printf("Level %d viewport (%d, %d) %d x %d:\n", level, r0, c0, h, w);
+  for (r = 0; r < h; r++) {
+    printf("[ ");
+    for (c = 0; c < w; c++) {
+      printf("%u ", view[(size_t) r*w + c]);
+    }
+    printf("]\n");
+  }
+  free(view);
+}
+
+
+
+/*
+ * Function pyramidWrite
+ * ---------------------
+ *  Write every level but the board as a greyscale PGM image named
+ *  prefix.<level>.pgm, where the shade of a pixel is the density of its block
+ *
+ *  pyr: pointer to the pyramid
+ *  prefix: path prefix of the images
+ *
+ *  returns: 0 on success, -1 if an image cannot be written
+ */
+int pyramidWrite(const pyramid_t* restrict pyr, const char* prefix) {
+  char path[4096];
+  int l, r, c;
+  for (l = 1; l < pyr->nLevels; l++) {
+    snprintf(path, sizeof(path), "%s.%d.pgm", prefix, l);
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+      return -1;
+    }
+    fprintf(f, "P5\n%d %d\n255\n", pyr->cols[l], pyr->rows[l]);
+    unsigned char* line = (unsigned char*) malloc(pyr->cols[l]);
+    for (r = 0; r < pyr->rows[l]; r++) {
+      const unsigned int* restrict row = pyr->counts[l]
+                                         + (size_t) r * pyr->cols[l];
+      for (c = 0; c < pyr->cols[l]; c++) {
+        line[c] = (unsigned char) (255.0 * row[c] / blockArea(pyr, l, r, c));
+      }
+      fwrite(line, 1, pyr->cols[l], f);
+    }
+    free(line);
+    fclose(f);
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function blockArea
+ * ------------------
+ *  Number of cells of the board covered by a pixel (blocks on the last row
+ *  or column may be cut by the edge of the board)
+ *
+ *  pyr: pointer to the pyramid
+ *  level: level of the pixel
+ *  r, c: row and column of the pixel
+ *
+ *  returns: the number of cells of the block
+ */
+static inline int blockArea(const pyramid_t* restrict pyr, const int level,
+                            const int r, const int c) {
+  const int side = 1 << level;
+  const int h = pyr->n - r*side < side ? pyr->n - r*side : side;
+  const int w = pyr->m - c*side < side ? pyr->m - c*side : side;
+  return h * w;
+}
+
+
+
+/*
+ * Function pyramidFree
+ * --------------------
+ *  Free the levels of a pyramid
+ *
+ *  pyr: pointer to the pyramid
+ */
+void pyramidFree(pyramid_t* restrict pyr) {
+  int l;
+  for (l = 1; l < pyr->nLevels; l++) {
+    free(pyr->counts[l]);
+  }
+  pyr->nLevels = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include <stdio.h>
+
+// Maximum number of levels (level l has blocks of 2^l x 2^l cells)
+#define PYRAMID_LEVELS 32
+// The pyramid stops at the first level that fits in a thumbnail of this side
+#define PYRAMID_THUMB 64
+
+/*
+ * Structure pyramid
+ * -----------------
+ *  Multi-resolution overview of a board. Level 0 is the board itself and
+ *  every other level holds the number of live cells of each 2^l x 2^l block
+ *
+ *  n, m: dimensions of the board
+ *  nLevels: number of levels, including the board
+ *  rows, cols: dimensions of every level
+ *  counts: live cells per block of every level, row by row (NULL for level 0)
+ */
+typedef struct pyramid {
+  int n, m;
+  int nLevels;
+  int rows[PYRAMID_LEVELS];
+  int cols[PYRAMID_LEVELS];
+  unsigned int* counts[PYRAMID_LEVELS];
+} pyramid_t;
+
+void pyramidBuild(pyramid_t* restrict pyr, char** restrict mat, const int n,
+                  const int m, const int nThreads);
+int pyramidView(const pyramid_t* restrict pyr, char** restrict mat,
+                const int level, const int r0, const int c0, const int h,
+                const int w, unsigned int* restrict out);
+void pyramidPrintView(const pyramid_t* restrict pyr, char** restrict mat,
+                      const int level, const int r0, const int c0,
+                      const int h, const int w);
+int pyramidWrite(const pyramid_t* restrict pyr, const char* prefix);
+void pyramidFree(pyramid_t* restrict pyr);
+
+#endif
@@ -0,0 +1,124 @@
+#include <string.h>
+#include "stats.h"
+
+
+
+/*
+ * Function statsInit
+ * ------------------
+ *  Reset the statistics of a generation
+ *
+ *  st: pointer to the statistics
+ */
+void statsInit(stats_t* restrict st) {
+  st->population = st->births = st->deaths = 0;
+  st->top = st->left = 0x7FFFFFFF;
+  st->bot = st->right = -1;
+}
+
+
+
+/*
+ * Function statsRow
+ * -----------------
+ *  Accumulate population, births and bounding box of one freshly computed
+ *  row. It is called right after the row is computed, so both rows are still
+ *  in cache. Deaths follow from the populations (see statsFinish)
+ *
+ *  st: pointer to the statistics
+ *  prev: pointer to the first element of the row in the previous generation
+ *        (NULL for the initial state, which has no births nor deaths)
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  i: index of the row
+ */
+void statsRow(stats_t* restrict st, const char* restrict prev,
+              const char* restrict row, const int m, const int i) {
+  int j;
+  long long population = 0, births = 0;
+  unsigned long long x, y;
+  // Cells are 0 or 1, so a popcount of eight cells read as one word counts
+  // the live ones
+  for (j = 0; j + 8 <= m; j += 8) {
+    memcpy(&x, row + j, 8);
+    population += __builtin_popcountll(x);
+    if (prev != NULL) {
+      memcpy(&y, prev + j, 8);
+      births += __builtin_popcountll(x & ~y);
+    }
+  }
+  for (; j < m; j++) {
+    population += row[j];
+    if (prev != NULL) {
+      births += row[j] & ~prev[j];
+    }
+  }
+  st->births += births;
+  st->population += population;
+
+  if (population > 0) {
+    if (i < st->top) st->top = i;
+    if (i > st->bot) st->bot = i;
+    for (j = 0; !row[j]; j++);
+    if (j < st->left) st->left = j;
+    for (j = m-1; !row[j]; j--);
+    if (j > st->right) st->right = j;
+  }
+}
+
+
+
+/*
+ * Function statsFinish
+ * --------------------
+ *  Complete the statistics of a generation once all its rows are accounted
+ *  for: every cell alive in the previous generation either survived or died
+ *
+ *  st: pointer to the statistics
+ *  previous: population of the previous generation
+ */
+void statsFinish(stats_t* restrict st, const long long previous) {
+  st->deaths = previous - (st->population - st->births);
+}
+
+
+
+/*
+ * Function statsMerge
+ * -------------------
+ *  Add the statistics of a group of rows to the ones of another group
+ *
+ *  st: pointer to the statistics to update
+ *  other: pointer to the statistics to add
+ */
+void statsMerge(stats_t* restrict st, const stats_t* restrict other) {
+  st->population += other->population;
+  st->births += other->births;
+  st->deaths += other->deaths;
+  if (other->top < st->top) st->top = other->top;
+  if (other->bot > st->bot) st->bot = other->bot;
+  if (other->left < st->left) st->left = other->left;
+  if (other->right > st->right) st->right = other->right;
+}
+
+
+
+/*
+ * Function statsWrite
+ * -------------------
+ *  Write the statistics of a generation as one line of the time series:
+ *  generation, population, births, deaths and bounding box (top, bottom,
+ *  left, right; -1 when the board is empty)
+ *
+ *  f: output stream
+ *  gen: generation number
+ *  st: pointer to the statistics
+ */
+void statsWrite(FILE* f, const int gen, const stats_t* restrict st) {
+  if (st->population == 0) {
+    fprintf(f, "%d 0 %lld %lld -1 -1 -1 -1\n", gen, st->births, st->deaths);
+  } else {
+    fprintf(f, "%d %lld %lld %lld %d %d %d %d\n", gen, st->population,
+            st->births, st->deaths, st->top, st->bot, st->left, st->right);
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/*
+ * Structure stats
+ * ---------------
+ *  Statistics of one generation
+ *
+ *  population: number of live cells
+ *  births: number of cells that became alive
+ *  deaths: number of cells that died
+ *  top, bot, left, right: live bounding box (inclusive, empty if top > bot)
+ */
+typedef struct stats {
+  long long population;
+  long long births;
+  long long deaths;
+  int top, bot, left, right;
+} stats_t;
+
+void statsInit(stats_t* restrict st);
+void statsRow(stats_t* restrict st, const char* restrict prev,
+              const char* restrict row, const int m, const int i);
+void statsFinish(stats_t* restrict st, const long long previous);
+void statsMerge(stats_t* restrict st, const stats_t* restrict other);
+void statsWrite(FILE* f, const int gen, const stats_t* restrict st);
+
+#endif
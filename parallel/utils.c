@@ -1,19 +1,22 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <sys/resource.h>
+#include "alloc.h"
 #include "utils.h"
 #include "gol.h"
 
 
 // Forward declaration of static methods
-static inline double cRandom();
+static inline unsigned long long splitMix(unsigned long long x);
 
 
 
 /*
  * Function allocateMatrix
  * -----------------------
- *  Allocate memory for a matrix
+ *  Allocate memory for a matrix with the current allocation strategy (see
+ *  alloc.h)
  *
  *  nRows: number of rows of the matrix
  *  nCols: number of columns of the matrix
@@ -21,12 +24,7 @@ static inline double cRandom();
  *  returns: a pointer to the first element of the matrix
  */
 char** allocateMatrix(const int nRows, const int nCols) {
-  char** mat = (char**) malloc(nRows * sizeof(char*));
-  int i;
-  for (i = 0; i < nRows; i++) {
-    mat[i] = (char*) malloc(nCols * sizeof(char));
-  }
-  return mat;
+  return (char**) gridAlloc(nRows, nCols * sizeof(char));
 }
 
 
@@ -41,11 +39,7 @@ char** allocateMatrix(const int nRows, const int nCols) {
  *  nCols: number of columns of the matrix
  */
 void freeMatrix(char** restrict mat, const int nRows, const int nCols) {
-  int i;
-  for (i = 0; i < nRows; i++) {
-    free(mat[i]);
-  }
-  free(mat);
+  gridFree((void**) mat);
 }
 
 
@@ -59,29 +53,59 @@ void freeMatrix(char** restrict mat, const int nRows, const int nCols) {
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
  *  prob: probability of a cell being alive
+ *  seed: key of the draws (see createInitialRow)
  */
 void createInitialState(char** restrict mat, const int n, const int m,
-                        const double prob) {
-  int i, j;
+                        const double prob, const unsigned long long seed) {
+  int i;
   for (i = 0; i < n; i++) {
-    for (j = 0; j < m; j++) {
-      mat[i][j] = cRandom() <= prob ? 1 : 0;
-    }
+    createInitialRow(mat[i], m, prob, seed, i);
   }
 }
 
 
 
 /*
- * Function cRandom
- * ----------------
- *  Generate a uniform random number in range [0, 1]
+ * Function createInitialRow
+ * -------------------------
+ *  Draw one row of the initial state from a counter-based generator: the row
+ *  gets a key from the seed and its index, and cell j is alive when the top
+ *  53 bits of the mix of the key and j fall below prob, so a board depends
+ *  only on the seed (the same in every variant, whatever the order in which
+ *  the rows are drawn)
  *
- *  returns: the generated number
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  prob: probability of a cell being alive
+ *  seed: key of the draws
+ *  i: index of the row
  */
-static inline double cRandom() {
-  // https://stackoverflow.com/questions/6218399/how-to-generate-a-random-number-between-0-and-1
-  return (double) rand() / (double) RAND_MAX;
+void createInitialRow(char* restrict row, const int m, const double prob,
+                      const unsigned long long seed, const int i) {
+  const unsigned long long key = splitMix(splitMix(seed) ^ (unsigned) i);
+  const unsigned long long threshold = (unsigned long long) (prob * 0x1p53);
+  int j;
+  for (j = 0; j < m; j++) {
+    row[j] = splitMix(key + (unsigned) j) >> 11 < threshold;
+  }
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator
+ *
+ *  x: value to mix
+ *
+ *  returns: the mixed value
+ */
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
 }
 
 
@@ -121,3 +145,18 @@ double get_wall_seconds() {
   double seconds = tv.tv_sec + (double)tv.tv_usec / 1000000;
   return seconds;
 }
+
+
+
+/*
+* Function: get_peak_rss
+* ----------------------
+*  Fetch the peak resident set size of the process
+*
+*  returns: the peak resident set size in kilobytes
+*/
+long get_peak_rss() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
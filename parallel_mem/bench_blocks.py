@@ -0,0 +1,37 @@
+import subprocess
+
+
+# Row bands against the automatic 2D block grid on wide, tall and square
+# boards of about 49M cells
+output_file = 'blocks_result.txt'
+grid = [('1000', '49000'), ('49000', '1000'), ('7000', '7000')]
+prob = '0.5'
+nsteps = '100'
+debug = '0'
+n_threads = [4, 8, 16, 24]
+n_reps = 10
+
+layouts = ['', '-blocks auto']
+times = [[' ' for j in range(n_reps)]
+         for i in range(len(grid) * len(n_threads) * len(layouts))]
+
+row = 0
+for n, m in grid:
+    for t in n_threads:
+        for layout in layouts:
+            for j in range(n_reps):
+                seed = str(j+1)
+                command = ' '.join(['./gol', n, m, prob, nsteps, seed, str(t),
+                                    debug, layout])
+                proc = subprocess.Popen(command, shell=True,
+                                        stdout=subprocess.PIPE)
+                subprocess_return = proc.stdout.read().strip()
+                times[row][j] = str(float(subprocess_return))
+            med = sorted(float(x) for x in times[row])[n_reps // 2]
+            print('{}x{} {} threads {}: median {} s'.format(
+                n, m, t, layout or 'rows', med))
+            row += 1
+
+# One line per board, thread count and layout (rows, blocks)
+with open(output_file, 'w') as f:
+    f.writelines([' '.join(line) + '\n' for line in times])
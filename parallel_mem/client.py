@@ -0,0 +1,46 @@
+import os
+import socket
+import subprocess
+import time
+
+
+output_file = 'daemon_result.txt'
+socket_path = '/tmp/gol.sock'
+grids = ['500', '1000', '2000', '4000', '7000']
+prob = '0.5'
+nsteps = '100'
+n_threads = '16'
+n_reps = 10
+
+# Start the daemon and wait for its socket
+daemon = subprocess.Popen(['./gol', '-daemon', n_threads, socket_path])
+while not os.path.exists(socket_path):
+    time.sleep(0.01)
+
+conn = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+conn.connect(socket_path)
+replies = conn.makefile('r')
+
+# Replay the sweep of test.py: one job per grid size and seed
+times = [[' ' for j in range(n_reps)] for i in grids]
+for index_i, grid in enumerate(grids):
+    for j in range(n_reps):
+        seed = str(j+1)
+        request = ' '.join([grid, grid, prob, nsteps, seed, 'none'])
+        t = time.time()
+        conn.sendall((request + '\n').encode())
+        reply = replies.readline().split()
+        t = time.time() - t
+#        print(reply)
+        fields = dict(field.split('=') for field in reply[1:])
+        times[index_i][j] = '{:f}/{}'.format(t, fields['compute'])
+    print('{}% complete!'.format(((index_i+1)/len(grids))*100))
+
+conn.sendall(b'quit\n')
+conn.close()
+daemon.wait()
+
+# Every entry is the round-trip latency seen by the client and the compute
+# time reported by the daemon
+with open(output_file, 'w') as f:
+    f.writelines([' '.join(line) + '\n' for line in times])
@@ -0,0 +1,413 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>
+#include "daemon.h"
+#include "gol.h"
+#include "utils.h"
+
+
+// Kinds of result a job can ask for
+#define OUT_NONE 0
+#define OUT_POP 1
+#define OUT_HASH 2
+#define OUT_MATRIX 3
+
+
+/*
+ * Structure job
+ * -------------
+ *  Simulation requested by a client
+ *
+ *  n, m, prob, nSteps, seed: same meaning as the command line arguments
+ *  output: kind of result to send back (OUT_*)
+ *  status: 1 to run the job, 0 to skip it (bad request), -1 to shut down
+ *  fresh: whether the grids were just allocated and must be pre-faulted
+ *  tArrive, tStart, tDone: wall times at which the request was read, the
+ *                          computation started and finished
+ */
+typedef struct job {
+  int n, m;
+  double prob;
+  int nSteps;
+  int seed;
+  int output;
+  int status;
+  int fresh;
+  double tArrive, tStart, tDone;
+} job_t;
+
+
+/*
+ * Structure slot
+ * --------------
+ *  Pair of grids kept alive in the pool
+ *
+ *  n, m: dimensions of the grids (0 if the slot is empty)
+ *  a, b: the grids
+ *  lastUsed: wall time of the last job that used them
+ */
+typedef struct slot {
+  int n, m;
+  char** a;
+  char** b;
+  double lastUsed;
+} slot_t;
+
+
+// Globals of gol.c the engine works on
+extern char** restrict state;
+extern char** restrict other;
+extern tdata_t* restrict threadData;
+
+
+// Forward declaration of static methods
+static int readJob(job_t* restrict job, FILE* in, FILE* out);
+static void acquire(slot_t* restrict pool, job_t* restrict job,
+                    const int nThreads);
+static void touchBand(char** restrict mat, const int n, const int m,
+                      const int nThreads, const int tid);
+static void reply(FILE* out, const job_t* restrict job,
+                  const long long pop, const unsigned long long hash);
+static int compareDoubles(const void* a, const void* b);
+
+
+
+/*
+ * Function runDaemon
+ * ------------------
+ *  Serve simulation jobs until told to stop. The thread team and the grids
+ *  of recent board sizes stay alive between jobs, so a job only pays for its
+ *  own generations. Requests are lines "n m prob nSteps seed [output]" where
+ *  output is none, pop (default), hash or matrix; "quit" stops the daemon.
+ *  Every request gets a line "ok key=value..." with its latency breakdown
+ *  (followed by the matrix if requested) or "error ..."
+ *
+ *  nThreads: number of threads
+ *  socketPath: path of the Unix domain socket to listen on, or NULL to read
+ *              requests from standard input and answer on standard output
+ *
+ *  returns: 0 on a clean shutdown, -1 if the socket cannot be set up
+ */
+int runDaemon(const int nThreads, const char* socketPath) {
+  int listener = -1, conn = -1;
+  FILE* in = stdin;
+  FILE* out = stdout;
+  slot_t pool[POOL_SIZE];
+  job_t job;
+  long long pop = 0;
+  unsigned long long hash = 0;
+  int nJobs = 0, capacity = 1024;
+  double* latencies = (double*) malloc(capacity * sizeof(double));
+  int i;
+
+  if (socketPath != NULL) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    unlink(socketPath);
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0
+        || bind(listener, (struct sockaddr*) &addr, sizeof(addr)) != 0
+        || listen(listener, 8) != 0) {
+      perror("socket");
+      return -1;
+    }
+    in = out = NULL;
+  }
+
+  for (i = 0; i < POOL_SIZE; i++) {
+    pool[i].n = pool[i].m = 0;
+  }
+  threadData = (tdata_t*) malloc(nThreads*sizeof(tdata_t));
+  fprintf(stderr, "Daemon ready with %d threads\n", nThreads);
+
+  #pragma omp parallel num_threads(nThreads)
+  {
+    const int tid = omp_get_thread_num();
+    while (1) {
+
+      // Wait for the next request (the rest of the team waits at the barrier)
+      #pragma omp single
+      {
+        job.status = 0;
+        while (job.status == 0) {
+          if (in == NULL) {
+            conn = accept(listener, NULL, NULL);
+            if (conn < 0) {
+              job.status = -1;
+              break;
+            }
+            in = fdopen(conn, "r");
+            out = fdopen(dup(conn), "w");
+          }
+          job.status = readJob(&job, in, out);
+          if (job.status == -2 && socketPath != NULL) {
+            // Client gone: wait for the next one
+            fclose(in);
+            fclose(out);
+            in = out = NULL;
+            job.status = 0;
+          } else if (job.status == -2) {
+            job.status = -1;
+          }
+        }
+        if (job.status == 1) {
+          acquire(pool, &job, nThreads);
+          pop = 0;
+          hash = 0;
+        }
+      }
+      if (job.status < 0) {
+        break;
+      }
+
+      // Pre-fault new grids with the same threads that will use their rows
+      if (job.fresh) {
+        touchBand(state, job.n, job.m, nThreads, tid);
+        touchBand(other, job.n, job.m, nThreads, tid);
+      }
+
+      createInitialState(state, job.n, job.m, job.prob,
+                         (unsigned long long) job.seed, nThreads, threadData);
+      #pragma omp barrier
+      #pragma omp single
+      job.tStart = get_wall_seconds();
+
+      evolve(job.n, job.m, job.nSteps, nThreads, threadData, NULL, NULL,
+             NULL, NULL, 0, 0, -1);
+
+      // Reduce the requested result in parallel
+      if (job.output == OUT_POP) {
+        #pragma omp for reduction(+:pop)
+        for (i = 0; i < job.n; i++) {
+          int j;
+          for (j = 0; j < job.m; j++) {
+            pop += state[i][j];
+          }
+        }
+      } else if (job.output == OUT_HASH) {
+        #pragma omp for reduction(+:hash)
+        for (i = 0; i < job.n; i++) {
+          hash += hashRow(state[i], job.m, i);
+        }
+      }
+
+      #pragma omp single
+      {
+        job.tDone = get_wall_seconds();
+        reply(out, &job, pop, hash);
+        if (nJobs == capacity) {
+          capacity *= 2;
+          latencies = (double*) realloc(latencies, capacity * sizeof(double));
+        }
+        latencies[nJobs++] = job.tDone - job.tArrive;
+      }
+    }
+  }
+
+  // Summary of the latencies
+  if (nJobs > 0) {
+    double sum = 0;
+    for (i = 0; i < nJobs; i++) {
+      sum += latencies[i];
+    }
+    qsort(latencies, nJobs, sizeof(double), compareDoubles);
+    fprintf(stderr, "Served %d jobs: latency mean %lf s, median %lf s, "
+            "p95 %lf s, max %lf s\n", nJobs, sum / nJobs,
+            latencies[nJobs/2], latencies[(int) (0.95 * (nJobs-1))],
+            latencies[nJobs-1]);
+  }
+
+  // Free data structures
+  for (i = 0; i < POOL_SIZE; i++) {
+    if (pool[i].n > 0) {
+      freeMatrix(pool[i].a, pool[i].n, pool[i].m);
+      freeMatrix(pool[i].b, pool[i].n, pool[i].m);
+    }
+  }
+  free(threadData);
+  free(latencies);
+  if (socketPath != NULL) {
+    if (in != NULL) {
+      fclose(in);
+      fclose(out);
+    }
+    close(listener);
+    unlink(socketPath);
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function readJob
+ * ----------------
+ *  Read and validate the next request
+ *
+ *  job: pointer to the job to fill
+ *  in: stream the requests come from
+ *  out: stream where errors are reported
+ *
+ *  returns: 1 for a valid job, 0 for a bad request (already answered), -1
+ *           for a shutdown request and -2 at the end of the stream
+ */
+static int readJob(job_t* restrict job, FILE* in, FILE* out) {
+  char line[256];
+  char output[16] = "pop";
+  if (fgets(line, sizeof(line), in) == NULL) {
+    return -2;
+  }
+  job->tArrive = get_wall_seconds();
+  if (strncmp(line, "quit", 4) == 0) {
+    return -1;
+  }
+  const int nRead = sscanf(line, "%d %d %lf %d %d %15s", &job->n, &job->m,
+                           &job->prob, &job->nSteps, &job->seed, output);
+  if (nRead < 5 || job->n < 2 || job->m < 2 || job->nSteps <= 0
+      || job->prob < 0 || job->prob > 1 || job->seed < 0) {
+    fprintf(out, "error expected \"n m prob nSteps seed [output]\" with "
+            "n, m >= 2, nSteps > 0, prob in [0, 1] and seed >= 0\n");
+    fflush(out);
+    return 0;
+  }
+  if (strcmp(output, "none") == 0) {
+    job->output = OUT_NONE;
+  } else if (strcmp(output, "pop") == 0) {
+    job->output = OUT_POP;
+  } else if (strcmp(output, "hash") == 0) {
+    job->output = OUT_HASH;
+  } else if (strcmp(output, "matrix") == 0) {
+    job->output = OUT_MATRIX;
+  } else {
+    fprintf(out, "error output must be none, pop, hash or matrix\n");
+    fflush(out);
+    return 0;
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function acquire
+ * ----------------
+ *  Point state and other to a pair of grids of the size of a job, reusing
+ *  the pool when possible and evicting the least recently used pair when it
+ *  is full, and distribute the rows among the threads
+ *
+ *  pool: pointer to the first slot of the pool
+ *  job: pointer to the job
+ *  nThreads: number of threads
+ */
+static void acquire(slot_t* restrict pool, job_t* restrict job,
+                    const int nThreads) {
+  int i, victim = 0;
+  for (i = 0; i < POOL_SIZE; i++) {
+    if (pool[i].n == job->n && pool[i].m == job->m) {
+      break;
+    }
+    if (pool[i].n == 0 || (pool[victim].n != 0
+                           && pool[i].lastUsed < pool[victim].lastUsed)) {
+      victim = i;
+    }
+  }
+  job->fresh = i == POOL_SIZE;
+  if (job->fresh) {
+    i = victim;
+    if (pool[i].n > 0) {
+      freeMatrix(pool[i].a, pool[i].n, pool[i].m);
+      freeMatrix(pool[i].b, pool[i].n, pool[i].m);
+    }
+    pool[i].n = job->n;
+    pool[i].m = job->m;
+    pool[i].a = allocateMatrix(job->n, job->m);
+    pool[i].b = allocateMatrix(job->n, job->m);
+  }
+  pool[i].lastUsed = get_wall_seconds();
+  state = pool[i].a;
+  other = pool[i].b;
+  distributeRows(job->n, nThreads, threadData);
+}
+
+
+
+/*
+ * Function touchBand
+ * ------------------
+ *  Write the rows of a grid that belong to a thread, so that their pages are
+ *  faulted in (and placed) by that thread
+ *
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  tid: id of the calling thread
+ */
+static void touchBand(char** restrict mat, const int n, const int m,
+                      const int nThreads, const int tid) {
+  int i;
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+  for (i = first; i < end; i++) {
+    memset(mat[i], 0, m);
+  }
+}
+
+
+
+/*
+ * Function reply
+ * --------------
+ *  Answer a job with its latency breakdown and requested result: wait is the
+ *  time spent getting the grids ready, compute the time spent evolving and
+ *  total the time since the request was read
+ *
+ *  out: stream to answer on
+ *  job: pointer to the job
+ *  pop: population of the final state (if requested)
+ *  hash: hash of the final state (if requested)
+ */
+static void reply(FILE* out, const job_t* restrict job,
+                  const long long pop, const unsigned long long hash) {
+  int i, j;
+  fprintf(out, "ok setup=%lf compute=%lf total=%lf", job->tStart - job->tArrive,
+          job->tDone - job->tStart, job->tDone - job->tArrive);
+  if (job->output == OUT_POP) {
+    fprintf(out, " pop=%lld", pop);
+  } else if (job->output == OUT_HASH) {
+    fprintf(out, " hash=%016llx", hash);
+  }
+  fprintf(out, "\n");
+  if (job->output == OUT_MATRIX) {
+    for (i = 0; i < job->n; i++) {
+      fprintf(out, "[ ");
+      for (j = 0; j < job->m; j++) {
+        fprintf(out, "%d ", state[i][j]);
+      }
+      fprintf(out, "]\n");
+    }
+  }
+  fflush(out);
+}
+
+
+
+/*
+ * Function compareDoubles
+ * -----------------------
+ *  Comparison function for qsort
+ *
+ *  a, b: pointers to the doubles to compare
+ *
+ *  returns: negative, zero or positive as a is smaller, equal or larger
+ */
+static int compareDoubles(const void* a, const void* b) {
+  const double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
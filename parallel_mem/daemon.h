@@ -0,0 +1,9 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+// Number of grid pairs kept alive between jobs
+#define POOL_SIZE 8
+
+int runDaemon(const int nThreads, const char* socketPath);
+
+#endif
@@ -1,19 +1,71 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <omp.h>
+#include "alloc.h"
+#include "daemon.h"
 #include "gol.h"
+#include "life3d.h"
+#include "live.h"
+#include "noise.h"
+#include "roofline.h"
+#include "stats.h"
 #include "utils.h"
 
 
 
 // Static function declarations
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field);
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts);
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, const int nThreads,
+                       const tdata_t* restrict threadData, const int tid,
+                       unsigned long long* restrict hash,
+                       stats_t* restrict st, char* restrict colSum,
+                       const noise_t* restrict noise, const int gen);
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              const int nThreads,
+                              const tdata_t* restrict threadData,
+                              const int tid, unsigned long long* restrict hash,
+                              stats_t* restrict st, char* restrict colSum,
+                              char* restrict rows);
+static void generationBlock(char** restrict cur, char** restrict next,
+                            const int n, const int m,
+                            const tdata_t* restrict td);
+static inline void evolveSegment(const char* restrict up,
+                                 const char* restrict mid,
+                                 const char* restrict down,
+                                 char* restrict out, const int m,
+                                 const int j0, const int j1);
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m);
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum);
+static unsigned long long hashBand(char** restrict mat, const int n,
+                                   const int m, const int nThreads,
+                                   const tdata_t* restrict threadData,
+                                   const int tid);
+static inline unsigned long long combineHash(const int nThreads,
+                                             const tdata_t* restrict threadData,
+                                             const int slot);
+static inline int allSame(const int nThreads,
+                          const tdata_t* restrict threadData);
+static void statsBand(stats_t* restrict st, char** restrict mat, const int n,
+                      const int m, const int nThreads,
+                      const tdata_t* restrict threadData, const int tid);
+static void combineStats(stats_t* restrict st, const int nThreads,
+                         const tdata_t* restrict threadData, const int slot);
+static inline char decide(const char alive, const char field);
 
 
-char** restrict state; // State at even times (0, 2, 4, etc.)
-char** restrict other; // State at odd times (1, 3, 5, etc.)
+char** restrict state; // Current state
+char** restrict other; // Scratch buffer for the next state
 tdata_t* restrict threadData;  // Data for the threads to operate
 
 
@@ -23,9 +75,54 @@ int main(int argc, char const *argv[]) {
   // Take initial time
   double t1 = get_wall_seconds();
 
+  // Serve jobs instead of running a single simulation
+  if (argc >= 3 && argc <= 4 && strcmp(argv[1], "-daemon") == 0
+      && atoi(argv[2]) > 0) {
+    return runDaemon(atoi(argv[2]), argc == 4 ? argv[3] : NULL);
+  }
+
   // Check that arguments are provided
-  if (argc != 8) {
-    printf("Usage: %s n m prob nSteps seed nThreads debug\n", argv[0]);
+  options_t opts;
+  if (argc < 8 || parseOptions(argc, argv, &opts) != 0) {
+    printf("Usage: %s n m prob nSteps seed nThreads debug [options]\n", argv[0]);
+    printf("Options:\n");
+    printf("  -cycles     stop computing once the board repeats itself\n");
+    printf("  -alloc mode grid allocation: legacy (one malloc per row), aligned\n"
+           "              (default), huge (MAP_HUGETLB) or thp (madvise)\n");
+    printf("  -stats file write population, births, deaths and bounding box of every\n"
+           "              generation to file (not with -cycles)\n");
+    printf("  -separable  compute neighbor counts from vertical column sums reused by a\n"
+           "              horizontal sliding window\n");
+    printf("  -inplace    update a single grid in place with a few rolling rows per\n"
+           "              thread instead of a second grid (half the memory); not\n"
+           "              combinable with -blocks, -noise nor -3d\n");
+    printf("  -blocks layout\n"
+           "              split the board among the threads in a 2D grid of blocks\n"
+           "              instead of row bands: auto or PxQ (P blocks along the rows,\n"
+           "              Q along the columns, P*Q = nThreads); not combinable with\n"
+           "              -cycles, -stats, -separable nor -inplace\n");
+    printf("  -roofline   measure the memory bandwidth and integer throughput of the\n"
+           "              host and report the run against them\n");
+    printf("  -live name interval\n"
+           "              publish every interval-th generation bit-packed in the POSIX\n"
+           "              shared-memory object name (e.g. /gol), read with ./view\n");
+    printf("  -3d rule depth\n"
+           "              run a 3D automaton with 26 neighbors on the n x m x depth torus,\n"
+           "              the rule in Bays notation (e.g. 4555 or 5766: survive with\n"
+           "              El..Eu neighbors, born with Fl..Fu; 4,5,5,5 also works);\n"
+           "              threads split the planes; not combinable with other options\n");
+    printf("  -hash every print the hash of generation 0, of every generation multiple\n"
+           "              of every (0 for none) and of the final one, to compare the\n"
+           "              backends (see results/verify.py); not with -cycles or -3d\n");
+    printf("  -noise pb ps\n"
+           "              stochastic Life: births happen with probability pb and\n"
+           "              survivals with probability ps, drawn per cell from a\n"
+           "              counter-based generator keyed by (seed, generation, cell), so\n"
+           "              runs match across backends and thread counts; not with\n"
+           "              -cycles, -separable, -inplace, -blocks or -3d\n");
+    printf("   or: %s -daemon nThreads [socket]\n", argv[0]);
+    printf("  serve \"n m prob nSteps seed [none|pop|hash|matrix]\" jobs read from\n"
+           "  socket (a Unix domain socket path) or standard input until \"quit\"\n");
     return -1;
   }
 
@@ -46,35 +143,101 @@ int main(int argc, char const *argv[]) {
   }
 
   // Initialize arbitrary seed for random numbers (or not!)
-  if (seed < 0) {
-    srand(time(NULL));
-  } else {
-    srand((unsigned int) seed);
+  const unsigned long long key = seed < 0 ? (unsigned long long) time(NULL)
+                                          : (unsigned long long) seed;
+
+  // 3D automata have their own bit-packed storage, split in slabs of planes
+  if (opts.rule3d != NULL) {
+    life3d_t lf;
+    life3dInit(&lf, n, m, opts.depth, opts.survive, opts.born);
+    threadData = (tdata_t*) malloc(nThreads*sizeof(tdata_t));
+    distributeRows(opts.depth, nThreads, threadData);
+    const unsigned base = seed < 0 ? (unsigned) time(NULL) : (unsigned) seed;
+    double t2 = 0;
+    #pragma omp parallel num_threads(nThreads)
+    {
+      life3dFill(&lf, prob, base, nThreads, threadData);
+
+      #pragma omp barrier
+
+      #pragma omp single
+      {
+        if (debug) {
+          printf("Initial state:\n");
+          life3dPrint(&lf);
+        }
+        t2 = get_wall_seconds();
+      }
+
+      life3dEvolve(&lf, nSteps, nThreads, threadData);
+    }
+    t2 = get_wall_seconds() - t2;
+
+    if (debug) {
+      printf("Final state:\n");
+      life3dPrint(&lf);
+    }
+    fprintf(stderr, "Life 3D: rule %s, %dx%dx%d torus, population %lld, "
+            "%.3e cell updates per second\n", opts.rule3d, n, m, opts.depth,
+            life3dPopulation(&lf), (double) n * m * opts.depth * nSteps / t2);
+    life3dFree(&lf);
+    free(threadData);
+
+    t1 = get_wall_seconds() - t1;
+    if (debug) {
+      printf("Execution took %lf seconds\n", t1);
+    } else {
+      printf("%lf\n", t1);
+    }
+    return 0;
   }
 
   // Initialize data structures
+  if (opts.alloc >= 0) {
+    setAllocMode(opts.alloc);
+  }
   state = allocateMatrix(n, m);
-  other = allocateMatrix(n, m);
+  other = opts.inPlace ? NULL : allocateMatrix(n, m);
 
   // Prepare data for threads
   threadData = (tdata_t*) malloc(nThreads*sizeof(tdata_t));
-  // Distribute work evenly for (rows 2 to n-2)
-  const int elePerThread = (n-2)/nThreads;
-  const int remainder = (n-2)%nThreads;
-  int i;
-  for (i = 0; i < remainder; i++) {
-    threadData[i].i0 = i*(elePerThread+1)+1;
-    threadData[i].i1 = (i+1)*(elePerThread+1)+1;
+  distributeRows(n, nThreads, threadData);
+  if (opts.blocks) {
+    if (opts.px * opts.py != 0 && opts.px * opts.py != nThreads) {
+      printf("Usage:\n  -blocks PxQ needs P*Q = nThreads\n");
+      return -1;
+    }
+    distributeBlocks(n, m, nThreads, &opts.px, &opts.py, threadData);
+    if (debug) {
+      fprintf(stderr, "Blocks: %d x %d\n", opts.px, opts.py);
+    }
   }
-  for (i = remainder; i < nThreads; i++) {
-    threadData[i].i0 = remainder + i*elePerThread + 1;
-    threadData[i].i1 = remainder + (i+1)*elePerThread + 1;
+
+  live_t live;
+  if (opts.live != NULL
+      && liveCreate(&live, opts.live, n, m, opts.interval) != 0) {
+    printf("Cannot create the shared-memory object %s\n", opts.live);
+    return -1;
+  }
+  FILE* series = NULL;
+  if (opts.stats != NULL && (series = fopen(opts.stats, "w")) == NULL) {
+    printf("Cannot create %s\n", opts.stats);
+    return -1;
   }
 
+  history_t hist;
+  if (opts.cycles) {
+    historyInit(&hist, n, m);
+  }
+  noise_t noise;
+  if (opts.noise) {
+    noiseInit(&noise, key, opts.pBirth, opts.pSurvive);
+  }
+  double t2 = 0;
   #pragma omp parallel num_threads(nThreads)
   {
     // Create initial state
-    createInitialState(state, n, m, prob, nThreads, threadData);
+    createInitialState(state, n, m, prob, key, nThreads, threadData);
 
     #pragma omp barrier
 
@@ -85,10 +248,24 @@ int main(int argc, char const *argv[]) {
         printf("Initial state:\n");
         printMatrix(state, n, m);
       }
+      t2 = get_wall_seconds();
     }
 
     // Evolve the system
-    evolve(n, m, nSteps, nThreads, threadData);
+    evolve(n, m, nSteps, nThreads, threadData, opts.cycles ? &hist : NULL,
+           series, opts.live != NULL ? &live : NULL,
+           opts.noise ? &noise : NULL, opts.separable, opts.blocks, opts.hash);
+  }
+  t2 = get_wall_seconds() - t2;
+  if (opts.cycles) {
+    historyReport(&hist);
+    historyFree(&hist);
+  }
+  if (series != NULL) {
+    fclose(series);
+  }
+  if (opts.live != NULL) {
+    liveClose(&live);
   }
 
   // Print final state
@@ -99,9 +276,16 @@ int main(int argc, char const *argv[]) {
 
   // Free data structures
   freeMatrix(state, n, m);
-  freeMatrix(other, n, m);
+  if (other != NULL) {
+    freeMatrix(other, n, m);
+  }
   free(threadData);
 
+  // Report how the grids were allocated
+  if (debug || opts.alloc >= 0) {
+    allocReport(stderr);
+  }
+
   // Print time it took to run the code
   t1 = get_wall_seconds() - t1;
   if (debug) {
@@ -110,6 +294,132 @@ int main(int argc, char const *argv[]) {
     printf("%lf\n", t1);
   }
 
+  // Compare the evolution with the ceilings of the host. Bytes per update
+  // are the read of the current cell and the write of the next one (rows
+  // around it are in cache); operations per update are the eight additions
+  // of the field plus the two comparisons and selections of decide, or two
+  // plus two additions with column sums
+  if (opts.roofline) {
+    machine_t mc;
+    machineMeasure(&mc, nThreads);
+    rooflineReport(stderr, &mc, opts.separable ? "separable"
+                   : opts.blocks ? "block" : "row band", 2,
+                   opts.separable ? 8 : 12, (double) n * m * nSteps, t2);
+  }
+
+  return 0;
+}
+
+
+
+/*
+ * Function parseOptions
+ * ---------------------
+ *  Parse the optional flags given after the positional arguments
+ *
+ *  argc: number of command line arguments
+ *  argv: command line arguments
+ *  opts: pointer to the structure to fill
+ *
+ *  returns: 0 on success, -1 if an option is not recognized
+ */
+static int parseOptions(const int argc, char const *argv[],
+                        options_t* restrict opts) {
+  int a;
+  opts->cycles = 0;
+  opts->alloc = -1;
+  opts->stats = NULL;
+  opts->separable = 0;
+  opts->inPlace = 0;
+  opts->roofline = 0;
+  opts->live = NULL;
+  opts->interval = 0;
+  opts->blocks = 0;
+  opts->px = opts->py = 0;
+  opts->rule3d = NULL;
+  opts->depth = 0;
+  opts->hash = -1;
+  opts->noise = 0;
+  for (a = 8; a < argc; a++) {
+    if (strcmp(argv[a], "-cycles") == 0) {
+      opts->cycles = 1;
+    } else if (strcmp(argv[a], "-separable") == 0) {
+      opts->separable = 1;
+    } else if (strcmp(argv[a], "-inplace") == 0) {
+      opts->inPlace = 1;
+    } else if (strcmp(argv[a], "-roofline") == 0) {
+      opts->roofline = 1;
+    } else if (strcmp(argv[a], "-live") == 0 && a+2 < argc) {
+      opts->live = argv[++a];
+      opts->interval = atoi(argv[++a]);
+      if (opts->interval <= 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-blocks") == 0 && a+1 < argc) {
+      opts->blocks = 1;
+      a++;
+      if (strcmp(argv[a], "auto") != 0
+          && (sscanf(argv[a], "%dx%d", &opts->px, &opts->py) != 2
+              || opts->px <= 0 || opts->py <= 0)) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-3d") == 0 && a+2 < argc) {
+      opts->rule3d = argv[++a];
+      opts->depth = atoi(argv[++a]);
+      if (life3dParseRule(opts->rule3d, &opts->survive, &opts->born) != 0
+          || opts->depth < 3) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-alloc") == 0 && a+1 < argc) {
+      opts->alloc = parseAllocMode(argv[++a]);
+      if (opts->alloc < 0) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-stats") == 0 && a+1 < argc) {
+      opts->stats = argv[++a];
+    } else if (strcmp(argv[a], "-noise") == 0 && a+2 < argc) {
+      opts->noise = 1;
+      opts->pBirth = atof(argv[++a]);
+      opts->pSurvive = atof(argv[++a]);
+      if (opts->pBirth < 0 || opts->pBirth > 1 || opts->pSurvive < 0
+          || opts->pSurvive > 1) {
+        return -1;
+      }
+    } else if (strcmp(argv[a], "-hash") == 0 && a+1 < argc) {
+      opts->hash = atoi(argv[++a]);
+      if (opts->hash < 0) {
+        return -1;
+      }
+    } else {
+      return -1;
+    }
+  }
+  // The series holds every generation, which -cycles stops computing once
+  // the board repeats
+  if (opts->stats != NULL && opts->cycles) {
+    return -1;
+  }
+  if (opts->blocks && (opts->cycles || opts->stats != NULL
+                       || opts->separable || opts->inPlace)) {
+    return -1;
+  }
+  // The 3D engine only has the plain torus evolution
+  if (opts->rule3d != NULL && (opts->cycles || opts->alloc >= 0
+                               || opts->stats != NULL
+                               || opts->separable || opts->inPlace
+                               || opts->blocks || opts->roofline
+                               || opts->live != NULL)) {
+    return -1;
+  }
+  // The stochastic rule only has the direct kernel on row bands
+  if (opts->noise && (opts->cycles || opts->separable || opts->inPlace
+                      || opts->blocks || opts->rule3d != NULL)) {
+    return -1;
+  }
+  // Checkpoints are generations of the 2D board actually computed
+  if (opts->hash >= 0 && (opts->cycles || opts->rule3d != NULL)) {
+    return -1;
+  }
   return 0;
 }
 
@@ -118,278 +428,610 @@ int main(int argc, char const *argv[]) {
 /*
  * Function evolve
  * ---------------
- *  Evolve the game state for a given number of iterations
+ *  Evolve the game state for a given number of iterations (called by every
+ *  thread of the team)
  *
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
- *  nSteps: number of iterations (assumed to be even)
+ *  nSteps: number of iterations
  *  nThreads: number of threads
  *  threadData: pointer to the first element of the array containing thread data
+ *  hist: pointer to the cycle detector, or NULL to evolve blindly. When the
+ *        board enters a cycle, only the generations needed to reach the
+ *        state at nSteps modulo the period are computed
+ *  series: stream where the statistics of every generation are written as a
+ *          time series by thread 0, or NULL to skip them
+ *  live: shared-memory segment where every live->head->interval-th
+ *        generation and the final one are published, or NULL
+ *  noise: stochastic rule, or NULL for the Game of Life
+ *  separable: use the separable kernel (see evolveRowSeparable)
+ *  blocks: compute the 2D block of every thread instead of its row band
+ *  every: print the hash of generation 0, of every generation multiple of
+ *         every (if positive) and of the final one (see hashReport), or -1
+ *         to print none. The partial hashes of the checkpoints are taken
+ *         like those of the cycle detector (after the generation for the
+ *         blocks, which do not hash) and combined by thread 0
+ *
+ *  When other is NULL the board is updated in place (see generationInPlace)
  */
 void evolve(const int n, const int m, const int nSteps, const int nThreads,
-            tdata_t* restrict threadData) {
-  int k, i, j;
-  char field;
+            tdata_t* restrict threadData, history_t* restrict hist,
+            FILE* series, live_t* restrict live,
+            const noise_t* restrict noise, const int separable,
+            const int blocks, const int every) {
+  int k;
   int tid;
+  int last;
+  int report;
+  history_t local;  // Private copy of the cycle detector
+  stats_t st;  // Combined statistics (thread 0)
 
   tid = omp_get_thread_num();
+  last = nSteps;
+  const int inPlace = other == NULL;
+  char* restrict colSum = separable ? (char*) malloc(m+2) : NULL;
+  char* restrict rows = inPlace ? (char*) malloc(4 * (size_t) m) : NULL;
+  // Rows of the thread in the live view frames
+  const int p0 = tid == 0 ? 0 : threadData[tid].i0;
+  const int p1 = tid == nThreads-1 ? n : threadData[tid].i1;
+  const int interval = live != NULL ? live->head->interval : 0;
 
-  if (tid == 0) {
-    for (k = 0; k < nSteps; k+=2) {
+  if (live != NULL) {
+    if (tid == 0) {
+      liveBegin(live, 0);
+    }
+    #pragma omp barrier
+  }
 
-      // FIRST ITERATION
-      {
-      // First row (i=0)
-        // First column (j=0)
-        field = state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                    + state[0][m-1] + state[0][0] + state[0][1]
-                    + state[1][m-1] + state[1][0] + state[1][1];
-        decide(state[0][0], other, 0, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = state[n-1][j-1] + state[n-1][j] + state[n-1][j+1]
-                      + state[0][j-1] + state[0][j] + state[0][j+1]
-                      + state[1][j-1] + state[1][j] + state[1][j+1];
-          decide(state[0][j], other, 0, j, field);
-        }
-        // Last column (j=m-1)
-        field = state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                    + state[0][m-2] + state[0][m-1] + state[0][0]
-                    + state[1][m-2] + state[1][m-1] + state[1][0];
-        decide(state[0][m-1], other, 0, m-1, field);
-
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                    + state[i][m-1] + state[i][0] + state[i][1]
-                    + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-        decide(state[i][0], other, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                      + state[i][j-1] + state[i][j] + state[i][j+1]
-                      + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-          decide(state[i][j], other, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                    + state[i][m-2] + state[i][m-1] + state[i][0]
-                    + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-        decide(state[i][m-1], other, i, m-1, field);
-      }
+  if (hist != NULL || every >= 0) {
+    threadData[tid].hash[0] = hashBand(state, n, m, nThreads, threadData,
+                                       tid);
+    #pragma omp barrier
+    if (hist != NULL) {
+      local = *hist;
+      historyCheck(&local, combineHash(nThreads, threadData, 0), 0);
+    }
+    if (every >= 0 && tid == 0) {
+      hashReport(0, combineHash(nThreads, threadData, 0));
+    }
+  }
+
+  if (series != NULL) {
+    statsBand(&threadData[tid].stats[0], state, n, m, nThreads, threadData,
+              tid);
+    #pragma omp barrier
+    if (tid == 0) {
+      combineStats(&st, nThreads, threadData, 0);
+      statsWrite(series, 0, &st);
+    }
+  }
+
+  for (k = 0; k < last; k++) {
+    report = every >= 0
+             && (k+1 == nSteps || (every > 0 && (k+1) % every == 0));
 
+    // Generation k is read-only during this iteration, so every thread packs
+    // its rows of it into the frame begun by thread 0 before the last barrier
+    if (live != NULL && k % interval == 0) {
+      livePack(live, k / interval % 2, inPlace || k % 2 == 0 ? state : other,
+               p0, p1);
+    }
+
+    // Generation k goes from state to other when k is even, and back when odd
+    if (inPlace) {
+      generationInPlace(state, n, m, nThreads, threadData, tid,
+                        hist != NULL || report
+                        ? &threadData[tid].hash[(k+1)%2] : NULL,
+                        series != NULL ? &threadData[tid].stats[(k+1)%2]
+                                       : NULL, colSum, rows);
+    } else if (blocks) {
+      if (k % 2 == 0) {
+        generationBlock(state, other, n, m, &threadData[tid]);
+      } else {
+        generationBlock(other, state, n, m, &threadData[tid]);
       }
+    } else if (k % 2 == 0) {
+      generation(state, other, n, m, nThreads, threadData, tid,
+                 hist != NULL || report ? &threadData[tid].hash[1] : NULL,
+                 series != NULL ? &threadData[tid].stats[1] : NULL, colSum,
+                 noise, k);
+    } else {
+      generation(other, state, n, m, nThreads, threadData, tid,
+                 hist != NULL || report ? &threadData[tid].hash[0] : NULL,
+                 series != NULL ? &threadData[tid].stats[0] : NULL, colSum,
+                 noise, k);
+    }
 
-      #pragma omp barrier
+    // Frames alternate, so the next one can be begun while the current one
+    // is still being written and completed after the barrier
+    if (live != NULL && tid == 0 && (k+1) % interval == 0) {
+      liveBegin(live, (k+1) / interval % 2);
+    }
 
-      // SECOND ITERATION
-      {
-      // First row (i=0)
-        // First column (j=0)
-        field = other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                    + other[0][m-1] + other[0][0] + other[0][1]
-                    + other[1][m-1] + other[1][0] + other[1][1];
-        decide(other[0][0], state, 0, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = other[n-1][j-1] + other[n-1][j] + other[n-1][j+1]
-                      + other[0][j-1] + other[0][j] + other[0][j+1]
-                      + other[1][j-1] + other[1][j] + other[1][j+1];
-          decide(other[0][j], state, 0, j, field);
-        }
-        // Last column (j=m-1)
-        field = other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                    + other[0][m-2] + other[0][m-1] + other[0][0]
-                    + other[1][m-2] + other[1][m-1] + other[1][0];
-        decide(other[0][m-1], state, 0, m-1, field);
-
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                    + other[i][m-1] + other[i][0] + other[i][1]
-                    + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-        decide(other[i][0], state, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                      + other[i][j-1] + other[i][j] + other[i][j+1]
-                      + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-          decide(other[i][j], state, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                    + other[i][m-2] + other[i][m-1] + other[i][0]
-                    + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-        decide(other[i][m-1], state, i, m-1, field);
+    #pragma omp barrier
+
+    if (live != NULL && tid == 0 && k % interval == 0) {
+      liveEnd(live, k / interval % 2, k);
+    }
+
+    // Thread 0 reduces the partial statistics while the others move on
+    if (series != NULL && tid == 0) {
+      const long long previous = st.population;
+      combineStats(&st, nThreads, threadData, (k+1)%2);
+      statsFinish(&st, previous);
+      statsWrite(series, k+1, &st);
+    }
+
+    if (report) {
+      if (blocks) {
+        threadData[tid].hash[(k+1)%2] = hashBand(k % 2 == 0 ? other : state, n,
+                                                 m, nThreads, threadData, tid);
+        #pragma omp barrier
       }
+      if (tid == 0) {
+        hashReport(k+1, combineHash(nThreads, threadData, (k+1)%2));
+      }
+    }
 
+    // Every thread combines the partial hashes itself and takes the same
+    // decision, so no further synchronization is needed. Partial hashes are
+    // double buffered because the next generation overwrites the other slot.
+    // A proposed period is checked on the cells: every thread holds and
+    // compares its own rows, and the verdicts are combined after a barrier
+    if (hist != NULL && local.period == 0) {
+      char** restrict board = inPlace || k % 2 == 1 ? state : other;
+      if (historyDue(&local, k+1)) {
+        threadData[tid].same = historySame(&local, board, p0, p1, m);
+        #pragma omp barrier
+        historyConfirm(&local, k+1, allSame(nThreads, threadData));
       }
+      const int period = historyCheck(&local,
+                                      combineHash(nThreads, threadData, (k+1)%2),
+                                      k+1);
+      if (period == 0 && local.held == k+1) {
+        historyHold(&local, board, p0, p1, m);
+      }
+      if (period != 0) {
+        last = k+1 + (nSteps - (k+1)) % period;
+      }
+    }
 
-      #pragma omp barrier
+  }
+
+  free(colSum);
+  free(rows);
 
+  // Publish the final state (as generation nSteps, which it equals when a
+  // cycle cut the evolution short)
+  if (live != NULL) {
+    if (tid == 0) {
+      liveBegin(live, last / interval % 2);
+    }
+    #pragma omp barrier
+    livePack(live, last / interval % 2,
+             inPlace || last % 2 == 0 ? state : other, p0, p1);
+    #pragma omp barrier
+    if (tid == 0) {
+      liveEnd(live, last / interval % 2, nSteps);
     }
-  } else if (tid == nThreads-1) {
-    for (k = 0; k < nSteps; k+=2) {
+  }
 
-      // FIRST ITERATION
-      {
+  // Leave the final state in state
+  #pragma omp single
+  {
+    if (last % 2 == 1 && !inPlace) {
+      char** restrict tmp = state;
+      state = other;
+      other = tmp;
+    }
+    if (hist != NULL) {
+      *hist = local;
+    }
+  }
+}
 
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                    + state[i][m-1] + state[i][0] + state[i][1]
-                    + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-        decide(state[i][0], other, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                      + state[i][j-1] + state[i][j] + state[i][j+1]
-                      + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-          decide(state[i][j], other, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                    + state[i][m-2] + state[i][m-1] + state[i][0]
-                    + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-        decide(state[i][m-1], other, i, m-1, field);
-      }
 
-      // Last row (i=n-1)
-        // First column (j=0)
-        field = state[n-2][m-1] + state[n-2][0] + state[n-2][1]
-                    + state[n-1][m-1] + state[n-1][0] + state[n-1][1]
-                    + state[0][m-1] + state[0][0] + state[0][1];
-        decide(state[n-1][0], other, n-1, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = state[n-2][j-1] + state[n-2][j] + state[n-2][j+1]
-                      + state[n-1][j-1] + state[n-1][j]  + state[n-1][j+1]
-                      + state[0][j-1] + state[0][j] + state[0][j+1];
-          decide(state[n-1][j], other, n-1, j, field);
-        }
-        // Last column (j=m-1)
-        field = state[n-2][m-2] + state[n-2][m-1] + state[n-2][0]
-                    + state[n-1][m-2] + state[n-1][m-1] + state[n-1][0]
-                    + state[0][m-2] + state[0][m-1] + state[0][0];
-        decide(state[n-1][m-1], other, n-1, m-1, field);
 
-      }
+/*
+ * Function generation
+ * -------------------
+ *  Compute the rows of one generation that belong to a thread
+ *
+ *  cur: pointer to the first element of the current state matrix
+ *  next: pointer to the first element of the future state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ *  hash: where to store the partial hash of the rows of the thread (NULL to
+ *        skip it)
+ *  st: where to store the partial statistics of the rows of the thread (NULL
+ *      to skip them)
+ *  colSum: scratch row of m+2 elements of the thread for the separable
+ *          kernel (NULL for the direct one)
+ *  noise: stochastic rule (NULL for the Game of Life)
+ *  gen: generation of cur (keys the draws of the stochastic rule)
+ *
+ *  Hashes and statistics are taken from every row right after it is
+ *  computed, while it is still in cache
+ */
+static void generation(char** restrict cur, char** restrict next, const int n,
+                       const int m, const int nThreads,
+                       const tdata_t* restrict threadData, const int tid,
+                       unsigned long long* restrict hash,
+                       stats_t* restrict st, char* restrict colSum,
+                       const noise_t* restrict noise, const int gen) {
+  int i;
+  unsigned long long h = 0;
 
-      #pragma omp barrier
+  // Rows i0 to i1 of the thread, plus the first row (i=0) for the first
+  // thread and the last row (i=n-1) for the last one (both if there is just
+  // 1 thread!)
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
 
-      // SECOND ITERATION
-      {
+  if (st != NULL) statsInit(st);
 
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                    + other[i][m-1] + other[i][0] + other[i][1]
-                    + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-        decide(other[i][0], state, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                      + other[i][j-1] + other[i][j] + other[i][j+1]
-                      + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-          decide(other[i][j], state, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                    + other[i][m-2] + other[i][m-1] + other[i][0]
-                    + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-        decide(other[i][m-1], state, i, m-1, field);
-      }
+  for (i = first; i < end; i++) {
+    // Rows above and below, wrapping around the first and last rows
+    const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+    const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+    if (noise != NULL) {
+      noiseRow(noise, gen, i, up, cur[i], down, next[i], m);
+    } else if (colSum != NULL) {
+      evolveRowSeparable(up, cur[i], down, next[i], m, colSum);
+    } else {
+      evolveRow(up, cur[i], down, next[i], m);
+    }
+    if (hash != NULL) h += hashRow(next[i], m, i);
+    if (st != NULL) statsRow(st, cur[i], next[i], m, i);
+  }
 
-      // Last row (i=n-1)
-        // First column (j=0)
-        field = other[n-2][m-1] + other[n-2][0] + other[n-2][1]
-                    + other[n-1][m-1] + other[n-1][0] + other[n-1][1]
-                    + other[0][m-1] + other[0][0] + other[0][1];
-        decide(other[n-1][0], state, n-1, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = other[n-2][j-1] + other[n-2][j] + other[n-2][j+1]
-                      + other[n-1][j-1] + other[n-1][j]  + other[n-1][j+1]
-                      + other[0][j-1] + other[0][j] + other[0][j+1];
-          decide(other[n-1][j], state, n-1, j, field);
-        }
-        // Last column (j=m-1)
-        field = other[n-2][m-2] + other[n-2][m-1] + other[n-2][0]
-                    + other[n-1][m-2] + other[n-1][m-1] + other[n-1][0]
-                    + other[0][m-2] + other[0][m-1] + other[0][0];
-        decide(other[n-1][m-1], state, n-1, m-1, field);
+  if (hash != NULL) *hash = h;
+}
 
-      }
 
-      #pragma omp barrier
 
+/*
+ * Function generationInPlace
+ * --------------------------
+ *  Compute the rows of one generation that belong to a thread, overwriting
+ *  the current state. Every thread first copies the rows just above and
+ *  below its band, which its neighbors are about to overwrite. Inside the
+ *  band a new row is computed into a scratch row and only written back once
+ *  the next row has been computed, since that one still needs the old
+ *  version. Four scratch rows per thread replace the second grid
+ *
+ *  mat: pointer to the first element of the state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads, threadData, tid, hash, st, colSum: as in generation
+ *  rows: scratch space for four rows of the thread
+ */
+static void generationInPlace(char** restrict mat, const int n, const int m,
+                              const int nThreads,
+                              const tdata_t* restrict threadData,
+                              const int tid, unsigned long long* restrict hash,
+                              stats_t* restrict st, char* restrict colSum,
+                              char* restrict rows) {
+  int i;
+  unsigned long long h = 0;
+  char* restrict above = rows;  // Old row above the band
+  char* restrict below = rows + m;  // Old row below the band
+  char* restrict pending[2] = {rows + 2*m, rows + 3*m};  // New rows i-1, i
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+
+  if (st != NULL) statsInit(st);
+
+  if (first < end) {
+    memcpy(above, mat[first == 0 ? n-1 : first-1], m);
+    memcpy(below, mat[end == n ? 0 : end], m);
+  }
+  #pragma omp barrier
+
+  for (i = first; i < end; i++) {
+    const char* restrict up = i == first ? above : mat[i-1];
+    const char* restrict down = i == end-1 ? below : mat[i+1];
+    char* restrict out = pending[i%2];
+    if (colSum != NULL) {
+      evolveRowSeparable(up, mat[i], down, out, m, colSum);
+    } else {
+      evolveRow(up, mat[i], down, out, m);
     }
-  } else {
-    for (k = 0; k < nSteps; k+=2) {
+    if (hash != NULL) h += hashRow(out, m, i);
+    if (st != NULL) statsRow(st, mat[i], out, m, i);
+    // The old row i-1 is not needed anymore
+    if (i > first) {
+      memcpy(mat[i-1], pending[(i-1)%2], m);
+    }
+  }
+  if (first < end) {
+    memcpy(mat[end-1], pending[(end-1)%2], m);
+  }
 
-      // FIRST ITERATION
-      {
+  if (hash != NULL) *hash = h;
+}
 
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = state[i-1][m-1] + state[i-1][0] + state[i-1][1]
-                    + state[i][m-1] + state[i][0] + state[i][1]
-                    + state[i+1][m-1] + state[i+1][0] + state[i+1][1];
-        decide(state[i][0], other, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = state[i-1][j-1] + state[i-1][j] + state[i-1][j+1]
-                      + state[i][j-1] + state[i][j] + state[i][j+1]
-                      + state[i+1][j-1] + state[i+1][j] + state[i+1][j+1];
-          decide(state[i][j], other, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = state[i-1][m-2] + state[i-1][m-1] + state[i-1][0]
-                    + state[i][m-2] + state[i][m-1] + state[i][0]
-                    + state[i+1][m-2] + state[i+1][m-1] + state[i+1][0];
-        decide(state[i][m-1], other, i, m-1, field);
-      }
 
-      }
 
-      #pragma omp barrier
+/*
+ * Function generationBlock
+ * ------------------------
+ *  Compute the 2D block of one generation that belongs to a thread
+ *
+ *  cur: pointer to the first element of the current state matrix
+ *  next: pointer to the first element of the future state matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  td: pointer to the data of the thread
+ */
+static void generationBlock(char** restrict cur, char** restrict next,
+                            const int n, const int m,
+                            const tdata_t* restrict td) {
+  int i;
+  if (td->c0 >= td->c1) {
+    return;
+  }
+  for (i = td->r0; i < td->r1; i++) {
+    // Rows above and below, wrapping around the first and last rows
+    const char* restrict up = i == 0 ? cur[n-1] : cur[i-1];
+    const char* restrict down = i == n-1 ? cur[0] : cur[i+1];
+    evolveSegment(up, cur[i], down, next[i], m, td->c0, td->c1);
+  }
+}
 
-      // SECOND ITERATION
-      {
 
-      // Other rows (i=1 to n-2) - Note the separation for each thread
-      for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-        // First column (j=0)
-        field = other[i-1][m-1] + other[i-1][0] + other[i-1][1]
-                    + other[i][m-1] + other[i][0] + other[i][1]
-                    + other[i+1][m-1] + other[i+1][0] + other[i+1][1];
-        decide(other[i][0], state, i, 0, field);
-        // Other columns (j=1 to m-2)
-        for (j=1; j <= m - 2; j++) {
-          field = other[i-1][j-1] + other[i-1][j] + other[i-1][j+1]
-                      + other[i][j-1] + other[i][j] + other[i][j+1]
-                      + other[i+1][j-1] + other[i+1][j] + other[i+1][j+1];
-          decide(other[i][j], state, i, j, field);
-        }
-        // Last column (j=m-1)
-        field = other[i-1][m-2] + other[i-1][m-1] + other[i-1][0]
-                    + other[i][m-2] + other[i][m-1] + other[i][0]
-                    + other[i+1][m-2] + other[i+1][m-1] + other[i+1][0];
-        decide(other[i][m-1], state, i, m-1, field);
-      }
 
-      }
+/*
+ * Function evolveSegment
+ * ----------------------
+ *  Compute the future state of columns j0 to j1 (exclusive) of one row of
+ *  the torus. Only the blocks touching the first or last column wrap around
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ *  j0, j1: columns of the segment
+ */
+static inline void evolveSegment(const char* restrict up,
+                                 const char* restrict mid,
+                                 const char* restrict down,
+                                 char* restrict out, const int m,
+                                 const int j0, const int j1) {
+  int j;
+  char field;
+  const int start = j0 == 0 ? 1 : j0;
+  const int stop = j1 == m ? m-1 : j1;
+  // First column (j=0)
+  if (j0 == 0) {
+    field = up[m-1] + up[0] + up[1]
+                + mid[m-1] + mid[0] + mid[1]
+                + down[m-1] + down[0] + down[1];
+    out[0] = decide(mid[0], field);
+  }
+  // Inner columns
+  for (j = start; j < stop; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+                + mid[j-1] + mid[j] + mid[j+1]
+                + down[j-1] + down[j] + down[j+1];
+    out[j] = decide(mid[j], field);
+  }
+  // Last column (j=m-1)
+  if (j1 == m && m-1 > 0) {
+    field = up[m-2] + up[m-1] + up[0]
+                + mid[m-2] + mid[m-1] + mid[0]
+                + down[m-2] + down[m-1] + down[0];
+    out[m-1] = decide(mid[m-1], field);
+  }
+}
 
-      #pragma omp barrier
 
-    }
+
+/*
+ * Function evolveRow
+ * ------------------
+ *  Compute the future state of one row of the torus
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ */
+static inline void evolveRow(const char* restrict up,
+                             const char* restrict mid,
+                             const char* restrict down, char* restrict out,
+                             const int m) {
+  int j;
+  char field;
+  // First column (j=0)
+  field = up[m-1] + up[0] + up[1]
+              + mid[m-1] + mid[0] + mid[1]
+              + down[m-1] + down[0] + down[1];
+  out[0] = decide(mid[0], field);
+  // Other columns (j=1 to m-2)
+  for (j = 1; j <= m - 2; j++) {
+    field = up[j-1] + up[j] + up[j+1]
+                + mid[j-1] + mid[j] + mid[j+1]
+                + down[j-1] + down[j] + down[j+1];
+    out[j] = decide(mid[j], field);
   }
+  // Last column (j=m-1)
+  field = up[m-2] + up[m-1] + up[0]
+              + mid[m-2] + mid[m-1] + mid[0]
+              + down[m-2] + down[m-1] + down[0];
+  out[m-1] = decide(mid[m-1], field);
+}
+
 
+
+/*
+ * Function evolveRowSeparable
+ * ---------------------------
+ *  Compute the future state of one row of the torus from column sums: the
+ *  three rows are first added vertically, once per column, and the field of
+ *  every cell is the sum of three neighboring column sums. That is three
+ *  loads per cell instead of nine, and both loops vectorize
+ *
+ *  up: pointer to the first element of the row above
+ *  mid: pointer to the first element of the row
+ *  down: pointer to the first element of the row below
+ *  out: pointer to the first element of the future row
+ *  m: number of columns of the matrix
+ *  colSum: scratch row of m+2 elements
+ */
+static inline void evolveRowSeparable(const char* restrict up,
+                                      const char* restrict mid,
+                                      const char* restrict down,
+                                      char* restrict out, const int m,
+                                      char* restrict colSum) {
+  int j;
+  // Column sums, shifted by one so the wrapped columns fit at both ends
+  for (j = 0; j < m; j++) {
+    colSum[j+1] = up[j] + mid[j] + down[j];
+  }
+  colSum[0] = colSum[m];
+  colSum[m+1] = colSum[1];
+  // Horizontal window over the column sums
+  for (j = 0; j < m; j++) {
+    out[j] = decide(mid[j], colSum[j] + colSum[j+1] + colSum[j+2]);
+  }
+}
+
+
+
+/*
+ * Function hashBand
+ * -----------------
+ *  Compute the partial hash of the rows that belong to a thread
+ *
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ *
+ *  returns: the partial hash
+ */
+static unsigned long long hashBand(char** restrict mat, const int n,
+                                   const int m, const int nThreads,
+                                   const tdata_t* restrict threadData,
+                                   const int tid) {
+  int i;
+  unsigned long long h = 0;
+  if (tid == 0) {
+    h += hashRow(mat[0], m, 0);
+  }
+  for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
+    h += hashRow(mat[i], m, i);
+  }
+  if (tid == nThreads-1) {
+    h += hashRow(mat[n-1], m, n-1);
+  }
+  return h;
+}
+
+
+
+/*
+ * Function combineHash
+ * --------------------
+ *  Combine the partial hashes of all threads into the hash of the board. The
+ *  sum does not depend on the order, so the result is the same for any
+ *  number of threads
+ *
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  slot: which of the two partial hashes of every thread to combine
+ *
+ *  returns: the hash of the board
+ */
+static inline unsigned long long combineHash(const int nThreads,
+                                             const tdata_t* restrict threadData,
+                                             const int slot) {
+  int t;
+  unsigned long long h = 0;
+  for (t = 0; t < nThreads; t++) {
+    h += threadData[t].hash[slot];
+  }
+  return h;
+}
+
+
+
+/*
+ * Function allSame
+ * ----------------
+ *  Combine the verdicts of all threads on the board held by the cycle
+ *  detector (see historySame)
+ *
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *
+ *  returns: 1 if the rows of every thread matched, 0 otherwise
+ */
+static inline int allSame(const int nThreads,
+                          const tdata_t* restrict threadData) {
+  int t;
+  for (t = 0; t < nThreads; t++) {
+    if (!threadData[t].same) return 0;
+  }
+  return 1;
+}
+
+
+
+/*
+ * Function statsBand
+ * ------------------
+ *  Compute the partial statistics of the rows that belong to a thread in the
+ *  initial state
+ *
+ *  st: where to store the partial statistics
+ *  mat: pointer to the first element of the matrix
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  tid: id of the calling thread
+ */
+static void statsBand(stats_t* restrict st, char** restrict mat, const int n,
+                      const int m, const int nThreads,
+                      const tdata_t* restrict threadData, const int tid) {
+  int i;
+  const int first = tid == 0 ? 0 : threadData[tid].i0;
+  const int end = tid == nThreads-1 ? n : threadData[tid].i1;
+  statsInit(st);
+  for (i = first; i < end; i++) {
+    statsRow(st, NULL, mat[i], m, i);
+  }
+}
+
+
+
+/*
+ * Function combineStats
+ * ---------------------
+ *  Reduce the partial statistics of all threads into the statistics of the
+ *  board
+ *
+ *  st: where to store the statistics of the board
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ *  slot: which of the two partial statistics of every thread to combine
+ */
+static void combineStats(stats_t* restrict st, const int nThreads,
+                         const tdata_t* restrict threadData, const int slot) {
+  int t;
+  statsInit(st);
+  for (t = 0; t < nThreads; t++) {
+    statsMerge(st, &threadData[t].stats[slot]);
+  }
 }
 
 
@@ -399,18 +1041,16 @@ void evolve(const int n, const int m, const int nSteps, const int nThreads,
  *  Decide wether a cell lives or dies
  *
  *  alive: current state of the cell
- *  future: pointer to the first element of the future state matrix
- *  i: index for row
- *  j: index for column
  *  field: number of alive neighbors + the cell itself
+ *
+ *  returns: the future state of the cell
  */
-static inline void decide(const char alive, char** restrict future, const int i,
-                          const int j, const char field) {
+static inline char decide(const char alive, const char field) {
   if (field == 3) {
-    future[i][j] = 1;
+    return 1;
   } else if (field == 4) {
-    future[i][j] = alive;
+    return alive;
   } else {
-    future[i][j] = 0;
+    return 0;
   }
 }
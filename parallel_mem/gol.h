@@ -1,6 +1,55 @@
 #ifndef GOL_H
 #define GOL_H
 
+#include <stdio.h>
+#include "hash.h"
+#include "live.h"
+#include "noise.h"
+#include "stats.h"
+
+/*
+ * Structure options
+ * -----------------
+ *  Optional flags given after the positional arguments
+ *
+ *  cycles: detect when the board repeats itself and skip to the final state
+ *  alloc: grid allocation strategy (-1 for the default one)
+ *  stats: path of the per-generation statistics (NULL if not requested)
+ *  separable: compute the fields from column sums (see evolveRowSeparable)
+ *  inPlace: update a single grid in place instead of two
+ *  blocks: split the board in 2D blocks instead of row bands
+ *  px, py: blocks along the rows and the columns (0 to choose them)
+ *  roofline: report the run against the bandwidth and integer throughput of
+ *            the host
+ *  live: name of the shared-memory live view (NULL if not requested)
+ *  interval: generations between the frames of the live view
+ *  rule3d: 3D rule in Bays notation (NULL for the 2D Game of Life)
+ *  depth: planes of the 3D board
+ *  survive, born: parsed 3D rule (see life3dParseRule)
+ *  hash: generations between printed hashes (0 for the first and final ones
+ *        only, -1 if not requested)
+ *  noise: run the stochastic rule (see noise.h)
+ *  pBirth, pSurvive: probabilities of a birth and of a survival
+ */
+typedef struct options {
+  int cycles;
+  int alloc;
+  const char* stats;
+  int separable;
+  int inPlace;
+  int blocks;
+  int px, py;
+  int roofline;
+  const char* live;
+  int interval;
+  const char* rule3d;
+  int depth;
+  unsigned survive, born;
+  int hash;
+  int noise;
+  double pBirth, pSurvive;
+} options_t;
+
 /*
  * Structure tdata
  * ---------------
@@ -8,13 +57,26 @@
  *
  *  i0: starting index (inclusive)
  *  i1: ending index (exclusive)
+ *  r0, r1, c0, c1: rows and columns of the block of the thread in the 2D
+ *                  decomposition (inclusive, exclusive)
+ *  hash: partial hashes of the rows of the thread (even/odd generations)
+ *  stats: partial statistics of the rows of the thread (even/odd generations)
+ *  same: whether the rows of the thread matched the board held by the cycle
+ *        detector (see historySame)
  */
 typedef struct tdata {
   int i0;  // Inclusive
   int i1;  // Exclusive
+  int r0, r1, c0, c1;
+  unsigned long long hash[2];
+  stats_t stats[2];
+  int same;
 } tdata_t;
 
 void evolve(const int n, const int m, const int nSteps, const int nThreads,
-            tdata_t* restrict threadData);
+            tdata_t* restrict threadData, history_t* restrict hist,
+            FILE* series, live_t* restrict live,
+            const noise_t* restrict noise, const int separable,
+            const int blocks, const int every);
 
 #endif
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "life3d.h"
+
+
+// Forward declaration of static methods
+static void planeSums(const life3d_t* restrict lf,
+                      const unsigned long long* restrict plane,
+                      unsigned long long* restrict h,
+                      unsigned long long* restrict v);
+static void applyRule(const life3d_t* restrict lf,
+                      const unsigned long long* restrict center,
+                      const unsigned long long* restrict below,
+                      const unsigned long long* restrict mid,
+                      const unsigned long long* restrict above,
+                      unsigned long long* restrict out);
+static inline unsigned long long match(const unsigned long long t[5],
+                                       unsigned set);
+
+
+
+/*
+ * Function life3dParseRule
+ * ------------------------
+ *  Parse a 3D rule in Bays notation: El Eu Fl Fu, a live cell surviving with
+ *  El to Eu live neighbors and a dead cell becoming alive with Fl to Fu. The
+ *  four numbers are given as four digits (e.g. 4555 or 5766) or separated
+ *  by commas (e.g. 4,5,5,5)
+ *
+ *  rule: rule to parse
+ *  survive: where to store the neighbor counts that keep a cell alive
+ *  born: where to store the neighbor counts that bring a cell to life
+ *
+ *  returns: 0 on success, -1 if the rule is not valid
+ */
+int life3dParseRule(const char* rule, unsigned* survive, unsigned* born) {
+  int e[4], k, c;
+  if (strchr(rule, ',') != NULL) {
+    if (sscanf(rule, "%d,%d,%d,%d%n", &e[0], &e[1], &e[2], &e[3], &c) != 4
+        || rule[c] != '\0') {
+      return -1;
+    }
+  } else {
+    if (strlen(rule) != 4) {
+      return -1;
+    }
+    for (k = 0; k < 4; k++) {
+      if (rule[k] < '0' || rule[k] > '9') {
+        return -1;
+      }
+      e[k] = rule[k] - '0';
+    }
+  }
+  if (e[0] < 0 || e[0] > e[1] || e[1] > 26 || e[2] < 0 || e[2] > e[3]
+      || e[3] > 26) {
+    return -1;
+  }
+  *survive = *born = 0;
+  for (c = e[0]; c <= e[1]; c++) {
+    *survive |= 1u << c;
+  }
+  for (c = e[2]; c <= e[3]; c++) {
+    *born |= 1u << c;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function life3dInit
+ * -------------------
+ *  Allocate a 3D board. The cells are left untouched, so that every thread
+ *  touches its own planes first (see life3dFill)
+ *
+ *  lf: pointer to the board
+ *  n: rows (y) of the board
+ *  m: columns (x) of the board
+ *  depth: planes (z) of the board
+ *  survive, born: rule (see life3dParseRule)
+ */
+void life3dInit(life3d_t* restrict lf, const int n, const int m,
+                const int depth, const unsigned survive, const unsigned born) {
+  const size_t total = (size_t) depth * n * ((m + 63) / 64);
+  lf->n = n;
+  lf->m = m;
+  lf->depth = depth;
+  lf->words = (m + 63) / 64;
+  lf->last = m % 64 == 0 ? ~0ULL : (1ULL << (m % 64)) - 1;
+  lf->survive = survive;
+  lf->born = born;
+  lf->cells = (unsigned long long*) malloc(total
+                                           * sizeof(unsigned long long));
+  lf->next = (unsigned long long*) malloc(total
+                                          * sizeof(unsigned long long));
+}
+
+
+
+/*
+ * Function life3dFill
+ * -------------------
+ *  Fill the planes of a thread with random cells (called by every thread of
+ *  the team). Every plane has its own random sequence, so the board does not
+ *  depend on the number of threads
+ *
+ *  lf: pointer to the board
+ *  prob: probability of a cell being alive
+ *  seed: seed of the random sequences
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread
+ *              data (planes in i0, i1)
+ */
+void life3dFill(life3d_t* restrict lf, const double prob,
+                const unsigned seed, const int nThreads,
+                const tdata_t* restrict threadData) {
+  const int tid = omp_get_thread_num();
+  const int z0 = tid == 0 ? 0 : threadData[tid].i0;
+  const int z1 = tid == nThreads-1 ? lf->depth : threadData[tid].i1;
+  const size_t plane = (size_t) lf->n * lf->words;
+  const double cut = prob * ((double) RAND_MAX + 1);
+  int z, y, x;
+  for (z = z0; z < z1; z++) {
+    unsigned s = seed + 0x9E3779B9u * (unsigned) (z + 1);
+    unsigned long long* restrict p = lf->cells + z * plane;
+    memset(p, 0, plane * sizeof(unsigned long long));
+    memset(lf->next + z * plane, 0, plane * sizeof(unsigned long long));
+    for (y = 0; y < lf->n; y++) {
+      unsigned long long* restrict row = p + (size_t) y * lf->words;
+      for (x = 0; x < lf->m; x++) {
+        if (rand_r(&s) < cut) {
+          row[x/64] |= 1ULL << (x%64);
+        }
+      }
+    }
+  }
+}
+
+
+
+/*
+ * Function life3dEvolve
+ * ---------------------
+ *  Evolve a 3D board for a given number of generations (called by every
+ *  thread of the team). Each thread computes a slab of planes along z. The
+ *  26 neighbors are counted separably, one bit of the count per word so 64
+ *  cells at a time: the three cells of a row along x, then three of those
+ *  sums along y (a plane of 3x3 sums, computed once per plane and reused by
+ *  the three planes around it), then three planes of those along z
+ *
+ *  lf: pointer to the board
+ *  nSteps: number of generations
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread
+ *              data (planes in i0, i1)
+ */
+void life3dEvolve(life3d_t* restrict lf, const int nSteps, const int nThreads,
+                  const tdata_t* restrict threadData) {
+  const int tid = omp_get_thread_num();
+  const int z0 = tid == 0 ? 0 : threadData[tid].i0;
+  const int z1 = tid == nThreads-1 ? lf->depth : threadData[tid].i1;
+  const int depth = lf->depth;
+  const size_t plane = (size_t) lf->n * lf->words;
+  // Sums along x of a plane (2 bits), and a ring of three planes of sums
+  // along x and y (4 bits)
+  unsigned long long* restrict h = (unsigned long long*)
+    malloc(2 * plane * sizeof(unsigned long long));
+  unsigned long long* restrict v = (unsigned long long*)
+    malloc(3 * 4 * plane * sizeof(unsigned long long));
+  unsigned long long* cur = lf->cells;
+  unsigned long long* nxt = lf->next;
+  unsigned long long* tmp;
+  int k, z;
+
+  for (k = 0; k < nSteps; k++) {
+    if (z0 < z1) {
+      // Plane z of the slab uses slot (z - z0 + 1) % 3
+      planeSums(lf, cur + (size_t) ((z0 - 1 + depth) % depth) * plane, h, v);
+      planeSums(lf, cur + (size_t) z0 * plane, h, v + 4 * plane);
+      for (z = z0; z < z1; z++) {
+        const int r = z - z0 + 1;
+        planeSums(lf, cur + (size_t) ((z + 1) % depth) * plane, h,
+                  v + (size_t) ((r + 1) % 3) * 4 * plane);
+        applyRule(lf, cur + (size_t) z * plane,
+                  v + (size_t) ((r - 1) % 3) * 4 * plane,
+                  v + (size_t) (r % 3) * 4 * plane,
+                  v + (size_t) ((r + 1) % 3) * 4 * plane,
+                  nxt + (size_t) z * plane);
+      }
+    }
+
+    // Wait for the whole generation before reading it
+    #pragma omp barrier
+    tmp = cur;
+    cur = nxt;
+    nxt = tmp;
+  }
+
+  free(h);
+  free(v);
+  #pragma omp single
+  {
+    lf->cells = cur;
+    lf->next = nxt;
+  }
+}
+
+
+
+/*
+ * Function life3dPopulation
+ * -------------------------
+ *  Count the live cells of a 3D board
+ *
+ *  lf: pointer to the board
+ *
+ *  returns: the number of live cells
+ */
+long long life3dPopulation(const life3d_t* restrict lf) {
+  const size_t total = (size_t) lf->depth * lf->n * lf->words;
+  long long population = 0;
+  size_t w;
+  for (w = 0; w < total; w++) {
+    population += __builtin_popcountll(lf->cells[w]);
+  }
+  return population;
+}
+
+
+
+/*
+ * Function life3dPrint
+ * --------------------
+ *  Print a 3D board plane by plane
+ *
+ *  lf: pointer to the board
+ */
+void life3dPrint(const life3d_t* restrict lf) {
+  int z, y, x;
+  for (z = 0; z < lf->depth; z++) {
+    printf("Plane %d:\n", z);
+    for (y = 0; y < lf->n; y++) {
+      const unsigned long long* row = lf->cells
+                                      + ((size_t) z * lf->n + y) * lf->words;
+      printf("[ ");
+      for (x = 0; x < lf->m; x++) {
+        printf("%d ", (int) ((row[x/64] >> (x%64)) & 1));
+      }
+      printf("]\n");
+    }
+  }
+}
+
+
+
+/*
+ * Function life3dFree
+ * -------------------
+ *  Free a 3D board
+ *
+ *  lf: pointer to the board
+ */
+void life3dFree(life3d_t* restrict lf) {
+  free(lf->cells);
+  free(lf->next);
+}
+
+
+
+/*
+ * Function planeSums
+ * ------------------
+ *  Sum every cell of a plane with its neighbors along x and y (3x3 sums,
+ *  0 to 9), bit-sliced: bit b of the sums of the 64 cells of word w of row y
+ *  is v[(y*words + w)*4 + b]
+ *
+ *  lf: pointer to the board
+ *  plane: pointer to the first word of the plane
+ *  h: pointer to room for the sums along x (2 bits per cell)
+ *  v: pointer to room for the 3x3 sums
+ */
+static void planeSums(const life3d_t* restrict lf,
+                      const unsigned long long* restrict plane,
+                      unsigned long long* restrict h,
+                      unsigned long long* restrict v) {
+  const int n = lf->n, words = lf->words;
+  const int top = (lf->m - 1) % 64;
+  int y, w;
+
+  // Along x: the row shifted by one cell both ways, wrapping around
+  for (y = 0; y < n; y++) {
+    const unsigned long long* restrict row = plane + (size_t) y * words;
+    unsigned long long* restrict out = h + (size_t) y * words * 2;
+    for (w = 0; w < words; w++) {
+      const unsigned long long c = row[w];
+      unsigned long long l = (c << 1) | (w > 0 ? row[w-1] >> 63
+                                                : (row[words-1] >> top) & 1);
+      const unsigned long long r = (c >> 1)
+                                   | (w < words-1 ? row[w+1] << 63
+                                                  : (row[0] & 1) << top);
+      if (w == words-1) {
+        l &= lf->last;
+      }
+      out[2*w] = l ^ c ^ r;
+      out[2*w+1] = (l & c) | (r & (l ^ c));
+    }
+  }
+
+  // Along y: three sums along x, the rows above and below wrapping around
+  for (y = 0; y < n; y++) {
+    const unsigned long long* restrict a = h + (size_t) (y == 0 ? n-1 : y-1)
+                                               * words * 2;
+    const unsigned long long* restrict b = h + (size_t) y * words * 2;
+    const unsigned long long* restrict c = h + (size_t) (y == n-1 ? 0 : y+1)
+                                               * words * 2;
+    unsigned long long* restrict out = v + (size_t) y * words * 4;
+    for (w = 0; w < words; w++) {
+      // a + b (3 bits)
+      const unsigned long long s0 = a[2*w] ^ b[2*w];
+      const unsigned long long c0 = a[2*w] & b[2*w];
+      const unsigned long long x1 = a[2*w+1] ^ b[2*w+1];
+      const unsigned long long s1 = x1 ^ c0;
+      const unsigned long long s2 = (a[2*w+1] & b[2*w+1]) | (c0 & x1);
+      // + c (4 bits)
+      const unsigned long long d0 = c[2*w] & s0;
+      const unsigned long long y1 = s1 ^ c[2*w+1];
+      const unsigned long long d1 = (s1 & c[2*w+1]) | (d0 & y1);
+      out[4*w] = s0 ^ c[2*w];
+      out[4*w+1] = y1 ^ d0;
+      out[4*w+2] = s2 ^ d1;
+      out[4*w+3] = s2 & d1;
+    }
+  }
+}
+
+
+
+/*
+ * Function applyRule
+ * ------------------
+ *  Compute the next generation of a plane from the 3x3 sums of the planes
+ *  below, at and above it. The sum of the three is the count of the 27
+ *  cells of the neighborhood, the cell included, so a live cell survives
+ *  with one more than its number of live neighbors
+ *
+ *  lf: pointer to the board
+ *  center: pointer to the first word of the plane
+ *  below, mid, above: pointers to the 3x3 sums of the three planes
+ *  out: pointer to the first word of the plane in the next generation
+ */
+static void applyRule(const life3d_t* restrict lf,
+                      const unsigned long long* restrict center,
+                      const unsigned long long* restrict below,
+                      const unsigned long long* restrict mid,
+                      const unsigned long long* restrict above,
+                      unsigned long long* restrict out) {
+  const size_t total = (size_t) lf->n * lf->words;
+  const unsigned survive = lf->survive << 1, born = lf->born;
+  unsigned long long t[5];
+  size_t i;
+  int b;
+  for (i = 0; i < total; i++) {
+    const unsigned long long* restrict p = below + 4*i;
+    const unsigned long long* restrict q = mid + 4*i;
+    const unsigned long long* restrict r = above + 4*i;
+    unsigned long long s[5], carry = 0;
+    // p + q (5 bits), then + r (5 bits, the count is at most 27)
+    for (b = 0; b < 4; b++) {
+      const unsigned long long x = p[b] ^ q[b];
+      s[b] = x ^ carry;
+      carry = (p[b] & q[b]) | (carry & x);
+    }
+    s[4] = carry;
+    carry = 0;
+    for (b = 0; b < 5; b++) {
+      const unsigned long long rb = b < 4 ? r[b] : 0;
+      const unsigned long long x = s[b] ^ rb;
+      t[b] = x ^ carry;
+      carry = (s[b] & rb) | (carry & x);
+    }
+    const unsigned long long alive = center[i];
+    out[i] = (alive & match(t, survive)) | (~alive & match(t, born));
+  }
+  // Cells past the last column stay dead
+  for (i = lf->words - 1; i < total; i += lf->words) {
+    out[i] &= lf->last;
+  }
+}
+
+
+
+/*
+ * Function match
+ * --------------
+ *  Find the cells whose bit-sliced count is in a set
+ *
+ *  t: bit-sliced counts of 64 cells (5 bits)
+ *  set: bit c set if count c is in the set
+ *
+ *  returns: the mask of the cells whose count is in the set
+ */
+static inline unsigned long long match(const unsigned long long t[5],
+                                       unsigned set) {
+  unsigned long long found = 0;
+  while (set) {
+    const int c = __builtin_ctz(set);
+    unsigned long long eq = ~0ULL;
+    int b;
+    set &= set - 1;
+    for (b = 0; b < 5; b++) {
+      eq &= (c >> b) & 1 ? t[b] : ~t[b];
+    }
+    found |= eq;
+  }
+  return found;
+}
@@ -0,0 +1,43 @@
+#ifndef LIFE3D_H
+#define LIFE3D_H
+
+#include "gol.h"
+
+/*
+ * Structure life3d
+ * ----------------
+ *  Board of a 3D totalistic automaton on the n x m x depth torus, with the 26
+ *  cells of the Moore neighborhood. Rows along x are bit-packed: cell x of
+ *  row (y, z) is bit x%64 of word x/64 of cells[(z*n + y)*words], the bits
+ *  past the last column being zero
+ *
+ *  n, m, depth: rows (y), columns (x) and planes (z) of the board
+ *  words: 64-bit words per row
+ *  last: valid bits of the last word of a row
+ *  survive: bit c set if a live cell with c live neighbors survives
+ *  born: bit c set if a dead cell with c live neighbors becomes alive
+ *  cells: current generation
+ *  next: scratch buffer for the next generation
+ */
+typedef struct life3d {
+  int n, m, depth;
+  int words;
+  unsigned long long last;
+  unsigned survive, born;
+  unsigned long long* cells;
+  unsigned long long* next;
+} life3d_t;
+
+int life3dParseRule(const char* rule, unsigned* survive, unsigned* born);
+void life3dInit(life3d_t* restrict lf, const int n, const int m,
+                const int depth, const unsigned survive, const unsigned born);
+void life3dFill(life3d_t* restrict lf, const double prob,
+                const unsigned seed, const int nThreads,
+                const tdata_t* restrict threadData);
+void life3dEvolve(life3d_t* restrict lf, const int nSteps, const int nThreads,
+                  const tdata_t* restrict threadData);
+long long life3dPopulation(const life3d_t* restrict lf);
+void life3dPrint(const life3d_t* restrict lf);
+void life3dFree(life3d_t* restrict lf);
+
+#endif
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "live.h"
+#include "utils.h"
+
+
+// Bytes before the first frame (the header rounded up to a cache line)
+#define LIVE_OFFSET ((sizeof(liveHeader_t) + 63) / 64 * 64)
+// Discarded copies after which a reader gives up (a writer that died while
+// writing both frames)
+#define LIVE_MAX_RETRIES (1 << 20)
+
+
+// Forward declaration of static methods
+static int mapSegment(live_t* restrict lv, const int fd, const int prot);
+
+
+
+/*
+ * Function liveCreate
+ * -------------------
+ *  Create (or replace) a live view segment for a board and map it. Both
+ *  frames start empty (generation -1)
+ *
+ *  lv: pointer to the mapping to fill
+ *  name: name of the POSIX shared-memory object, e.g. /gol
+ *  n: number of rows of the board
+ *  m: number of columns of the board
+ *  interval: generations between frames
+ *
+ *  returns: 0 on success, -1 if the segment cannot be created
+ */
+int liveCreate(live_t* restrict lv, const char* name, const int n,
+               const int m, const int interval) {
+  const int words = (m + 63) / 64;
+  const int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+  lv->name = name;
+  lv->owner = 1;
+  lv->size = LIVE_OFFSET + 2 * (size_t) n * words * sizeof(unsigned long long);
+  if (fd < 0 || ftruncate(fd, lv->size) != 0
+      || mapSegment(lv, fd, PROT_READ | PROT_WRITE) != 0) {
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(name);
+    }
+    return -1;
+  }
+  close(fd);
+  lv->head->n = n;
+  lv->head->m = m;
+  lv->head->words = words;
+  lv->head->interval = interval;
+  lv->head->slots[0].gen = lv->head->slots[1].gen = -1;
+  // Readers check the magic last
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(lv->head->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC));
+  return 0;
+}
+
+
+
+/*
+ * Function liveAttach
+ * -------------------
+ *  Map an existing live view segment read-only
+ *
+ *  lv: pointer to the mapping to fill
+ *  name: name of the POSIX shared-memory object
+ *
+ *  returns: 0 on success, -1 if there is no valid segment with that name
+ */
+int liveAttach(live_t* restrict lv, const char* name) {
+  struct stat st;
+  const int fd = shm_open(name, O_RDONLY, 0);
+  lv->name = name;
+  lv->owner = 0;
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < LIVE_OFFSET) {
+    close(fd);
+    return -1;
+  }
+  lv->size = st.st_size;
+  if (mapSegment(lv, fd, PROT_READ) != 0) {
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  if (memcmp(lv->head->magic, LIVE_MAGIC, sizeof(LIVE_MAGIC)) != 0
+      || lv->size < LIVE_OFFSET + 2 * (size_t) lv->head->n * lv->head->words
+                                    * sizeof(unsigned long long)) {
+    munmap(lv->head, lv->size);
+    return -1;
+  }
+  return 0;
+}
+
+
+
+/*
+ * Function liveBegin
+ * ------------------
+ *  Mark a frame as being written, so readers discard what they copy from it.
+ *  Beginning a frame that is already being written does nothing
+ *
+ *  lv: pointer to the mapping
+ *  slot: frame (0 or 1)
+ */
+void liveBegin(live_t* restrict lv, const int slot) {
+  unsigned long long* seq = &lv->head->slots[slot].seq;
+  const unsigned long long s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+  if (s % 2 == 0) {
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+}
+
+
+
+/*
+ * Function livePack
+ * -----------------
+ *  Bit-pack some rows of the board into a frame. Rows of different threads
+ *  are written independently between liveBegin and liveEnd
+ *
+ *  lv: pointer to the mapping
+ *  slot: frame (0 or 1)
+ *  mat: pointer to the first element of the state matrix
+ *  i0, i1: first (inclusive) and last (exclusive) row to pack
+ */
+void livePack(live_t* restrict lv, const int slot, char** restrict mat,
+              const int i0, const int i1) {
+  const int m = lv->head->m, words = lv->head->words;
+  unsigned long long* restrict frame = lv->frames
+                                       + (size_t) slot * lv->head->n * words;
+  unsigned long long x;
+  int i, w, k, j;
+  for (i = i0; i < i1; i++) {
+    const char* restrict row = mat[i];
+    unsigned long long* restrict out = frame + (size_t) i * words;
+    for (w = 0; w < words; w++) {
+      const int base = 64*w;
+      unsigned long long bits = 0;
+      // Cells are 0 or 1: eight of them read as a word are packed into
+      // eight bits with one multiplication
+      for (k = 0; k < 8 && base + 8*k + 8 <= m; k++) {
+        memcpy(&x, row + base + 8*k, 8);
+        bits |= ((x * 0x0102040810204080ULL) >> 56) << (8*k);
+      }
+      for (j = base + 8*k; j < m && j < base + 64; j++) {
+        bits |= (unsigned long long) row[j] << (j - base);
+      }
+      out[w] = bits;
+    }
+  }
+}
+
+
+
+/*
+ * Function liveEnd
+ * ----------------
+ *  Publish a frame once all its rows are packed
+ *
+ *  lv: pointer to the mapping
+ *  slot: frame (0 or 1)
+ *  gen: generation held by the frame
+ */
+void liveEnd(live_t* restrict lv, const int slot, const long long gen) {
+  liveSlot_t* s = &lv->head->slots[slot];
+  s->gen = gen;
+  s->stamp = get_wall_seconds();
+  __atomic_store_n(&s->seq, __atomic_load_n(&s->seq, __ATOMIC_RELAXED) + 1,
+                   __ATOMIC_RELEASE);
+}
+
+
+
+/*
+ * Function liveRead
+ * -----------------
+ *  Copy the most recent complete frame of a segment. The writer is never
+ *  waited for: a copy overlapped by a write is thrown away and retried
+ *
+ *  lv: pointer to the mapping
+ *  frame: pointer to the n * words words to fill
+ *  gen: pointer to the generation of the copied frame
+ *  stamp: pointer to the wall time at which the frame was completed
+ *
+ *  returns: the number of discarded copies, or -1 if no complete frame could
+ *           be read
+ */
+int liveRead(const live_t* restrict lv, unsigned long long* restrict frame,
+             long long* gen, double* stamp) {
+  const size_t frameWords = (size_t) lv->head->n * lv->head->words;
+  int retries = 0;
+  while (1) {
+    unsigned long long s[2];
+    long long g[2];
+    int k, best = -1;
+    for (k = 0; k < 2; k++) {
+      s[k] = __atomic_load_n(&lv->head->slots[k].seq, __ATOMIC_ACQUIRE);
+      g[k] = lv->head->slots[k].gen;
+      if (s[k] % 2 == 0 && g[k] >= 0 && (best < 0 || g[k] > g[best])) {
+        best = k;
+      }
+    }
+    if (best < 0) {
+      // Nothing published yet, or both frames being written
+      if ((g[0] < 0 && g[1] < 0) || retries >= LIVE_MAX_RETRIES) {
+        return -1;
+      }
+      retries++;
+      sched_yield();
+      continue;
+    }
+    memcpy(frame, lv->frames + best * frameWords,
+           frameWords * sizeof(unsigned long long));
+    *gen = g[best];
+    *stamp = lv->head->slots[best].stamp;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&lv->head->slots[best].seq, __ATOMIC_RELAXED)
+        == s[best]) {
+      return retries;
+    }
+    retries++;
+  }
+}
+
+
+
+/*
+ * Function liveClose
+ * ------------------
+ *  Unmap a live view segment, and remove it if this process created it
+ *
+ *  lv: pointer to the mapping
+ */
+void liveClose(live_t* restrict lv) {
+  munmap(lv->head, lv->size);
+  if (lv->owner) {
+    shm_unlink(lv->name);
+  }
+  lv->head = NULL;
+  lv->frames = NULL;
+}
+
+
+
+/*
+ * Function mapSegment
+ * -------------------
+ *  Map a shared-memory object and locate its frames
+ *
+ *  lv: pointer to the mapping (size already set)
+ *  fd: file descriptor of the object
+ *  prot: protection of the mapping
+ *
+ *  returns: 0 on success, -1 on failure
+ */
+static int mapSegment(live_t* restrict lv, const int fd, const int prot) {
+  void* p = mmap(NULL, lv->size, prot, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    return -1;
+  }
+  lv->head = (liveHeader_t*) p;
+  lv->frames = (unsigned long long*) ((char*) p + LIVE_OFFSET);
+  return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stddef.h>
+
+// First bytes of a live view segment
+#define LIVE_MAGIC "GOLLIVE"
+
+/*
+ * Structure liveSlot
+ * ------------------
+ *  Header of one of the two frames of a live view segment
+ *
+ *  seq: seqlock, odd while the frame is being written
+ *  gen: generation held by the frame (-1 before the first one)
+ *  stamp: wall time at which the frame was completed
+ */
+typedef struct liveSlot {
+  unsigned long long seq;
+  long long gen;
+  double stamp;
+  char pad[40];  // One cache line per slot
+} liveSlot_t;
+
+/*
+ * Structure liveHeader
+ * --------------------
+ *  Start of a live view segment. It is followed by the two frames, each the
+ *  board bit-packed as n rows of words 64-bit words, cell j of a row being
+ *  bit j%64 of word j/64. Frames alternate, so a frame can be written while
+ *  the previous one stays readable
+ *
+ *  magic: LIVE_MAGIC
+ *  n, m: dimensions of the board
+ *  words: words per row
+ *  interval: generations between frames
+ *  slots: headers of the two frames
+ */
+typedef struct liveHeader {
+  char magic[8];
+  int n, m;
+  int words;
+  int interval;
+  liveSlot_t slots[2];
+} liveHeader_t;
+
+/*
+ * Structure live
+ * --------------
+ *  Mapping of a live view segment
+ *
+ *  name: name of the POSIX shared-memory object
+ *  head: pointer to the header of the mapping
+ *  frames: pointer to the first word of frame 0 (frame 1 follows it)
+ *  size: size of the mapping in bytes
+ *  owner: whether the segment was created by this process
+ */
+typedef struct live {
+  const char* name;
+  liveHeader_t* head;
+  unsigned long long* frames;
+  size_t size;
+  int owner;
+} live_t;
+
+int liveCreate(live_t* restrict lv, const char* name, const int n,
+               const int m, const int interval);
+int liveAttach(live_t* restrict lv, const char* name);
+void liveBegin(live_t* restrict lv, const int slot);
+void livePack(live_t* restrict lv, const int slot, char** restrict mat,
+              const int i0, const int i1);
+void liveEnd(live_t* restrict lv, const int slot, const long long gen);
+int liveRead(const live_t* restrict lv, unsigned long long* restrict frame,
+             long long* gen, double* stamp);
+void liveClose(live_t* restrict lv);
+
+#endif
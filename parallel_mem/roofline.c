@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "roofline.h"
+#include "utils.h"
+
+
+// Elements of every triad array (three arrays of doubles, well beyond the
+// last-level cache)
+#define TRIAD_SIZE (1 << 22)
+// Bytes of every array of the integer benchmark (resident in L1)
+#define INT_SIZE 4096
+// Repetitions of each benchmark, the best one is kept
+#define TRIALS 5
+
+// Results of the benchmarks, so they are not optimized away
+static volatile double sink;
+
+// Forward declaration of static methods
+static double triad(double* restrict a, const double* restrict b,
+                    const double* restrict c, const double s,
+                    const int nThreads);
+static double intOps(const int reps, const int nThreads);
+
+
+
+/*
+ * Function machineMeasure
+ * -----------------------
+ *  Measure the memory bandwidth with a STREAM-like triad (a = b + s*c, 24
+ *  bytes per element, write-allocate traffic not counted) and the integer
+ *  throughput with a loop of byte additions and XORs on L1-resident arrays,
+ *  vectorized like the kernels, both with nThreads threads. Takes about a
+ *  second
+ *
+ *  mc: pointer to the structure to fill
+ *  nThreads: number of threads
+ */
+void machineMeasure(machine_t* restrict mc, const int nThreads) {
+  double* restrict a = (double*) malloc(TRIAD_SIZE * sizeof(double));
+  double* restrict b = (double*) malloc(TRIAD_SIZE * sizeof(double));
+  double* restrict c = (double*) malloc(TRIAD_SIZE * sizeof(double));
+  double best;
+  int j, t;
+
+  // First touch by the threads that run the triad
+  #pragma omp parallel for num_threads(nThreads) schedule(static)
+  for (j = 0; j < TRIAD_SIZE; j++) {
+    a[j] = 0;
+    b[j] = 1;
+    c[j] = 2;
+  }
+  best = 0;
+  for (t = 0; t < TRIALS; t++) {
+    const double sec = triad(a, b, c, 3.0, nThreads);
+    if (best == 0 || sec < best) {
+      best = sec;
+    }
+  }
+  mc->bandwidth = 3.0 * sizeof(double) * TRIAD_SIZE / best;
+
+  best = 0;
+  for (t = 0; t < TRIALS; t++) {
+    const double sec = intOps(4096, nThreads);
+    if (best == 0 || sec < best) {
+      best = sec;
+    }
+  }
+  // 6 operations per byte and repetition on every thread
+  mc->intRate = 6.0 * INT_SIZE * 4096 * nThreads / best;
+
+  // Keep the results alive
+  sink += a[TRIAD_SIZE / 2];
+  free(a);
+  free(b);
+  free(c);
+}
+
+
+
+/*
+ * Function rooflineReport
+ * -----------------------
+ *  Report how close a run got to the roofline of the host: the attainable
+ *  cell update rate is the lower of the bandwidth over the bytes per update
+ *  and the integer throughput over the operations per update
+ *
+ *  f: stream where the report is written
+ *  mc: pointer to the ceilings of the host
+ *  kernel: name of the kernel that was run
+ *  bytes: bytes moved from and to memory per cell update
+ *  ops: integer operations per cell update
+ *  updates: number of cell updates of the run
+ *  seconds: duration of the run
+ */
+void rooflineReport(FILE* f, const machine_t* restrict mc,
+                    const char* kernel, const double bytes, const double ops,
+                    const double updates, const double seconds) {
+  const double rate = updates / seconds;
+  const double memBound = mc->bandwidth / bytes;
+  const double intBound = mc->intRate / ops;
+  const double bound = memBound < intBound ? memBound : intBound;
+  fprintf(f, "Roofline: host %.2f GB/s triad, %.2f Gop/s integer\n",
+          mc->bandwidth * 1e-9, mc->intRate * 1e-9);
+  fprintf(f, "Roofline: %s kernel, %.1f bytes and %.1f ops per update "
+          "(intensity %.2f ops/byte, ridge %.2f)\n", kernel, bytes, ops,
+          ops / bytes, mc->intRate / mc->bandwidth);
+  fprintf(f, "Roofline: achieved %.2f GB/s, %.2f Gop/s, %.3f Gcell-updates/s "
+          "= %.1f%% of the %s bound (%.3f Gcell-updates/s)\n",
+          rate * bytes * 1e-9, rate * ops * 1e-9, rate * 1e-9,
+          100 * rate / bound, memBound < intBound ? "memory" : "compute",
+          bound * 1e-9);
+}
+
+
+
+/*
+ * Function triad
+ * --------------
+ *  Time one pass of the triad a = b + s*c split among nThreads threads
+ *
+ *  returns: the duration of the pass in seconds
+ */
+static double triad(double* restrict a, const double* restrict b,
+                    const double* restrict c, const double s,
+                    const int nThreads) {
+  int j;
+  double t = get_wall_seconds();
+  #pragma omp parallel for num_threads(nThreads) schedule(static)
+  for (j = 0; j < TRIAD_SIZE; j++) {
+    a[j] = b[j] + s * c[j];
+  }
+  return get_wall_seconds() - t;
+}
+
+
+
+/*
+ * Function intOps
+ * ---------------
+ *  Time reps passes of six byte-wide additions and XORs per element on
+ *  arrays private to each of nThreads threads. Every pass depends on the
+ *  previous one, so none can be skipped
+ *
+ *  returns: the duration of the passes in seconds
+ */
+static double intOps(const int reps, const int nThreads) {
+  double t = 0;
+  #pragma omp parallel num_threads(nThreads)
+  {
+    unsigned char* restrict a = (unsigned char*) malloc(INT_SIZE);
+    unsigned char* restrict b = (unsigned char*) malloc(INT_SIZE);
+    int r, j;
+    for (j = 0; j < INT_SIZE; j++) {
+      a[j] = j;
+      b[j] = 3*j + 1;
+    }
+    #pragma omp barrier
+    #pragma omp master
+    t = get_wall_seconds();
+    for (r = 0; r < reps; r++) {
+      for (j = 0; j < INT_SIZE; j++) {
+        unsigned char v = a[j] + b[j];
+        v ^= 0x35;
+        v += v;
+        v -= b[j];
+        v ^= a[j];
+        a[j] = v + 7;
+      }
+    }
+    #pragma omp atomic
+    sink += a[INT_SIZE / 2];
+    free(a);
+    free(b);
+    #pragma omp barrier
+    #pragma omp master
+    t = get_wall_seconds() - t;
+  }
+  return t;
+}
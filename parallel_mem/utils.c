@@ -2,19 +2,24 @@
 #include <stdio.h>
 #include <sys/time.h>
 #include <omp.h>
+#include "alloc.h"
 #include "utils.h"
 #include "gol.h"
 
 
 // Forward declaration of static methods
-static inline double cRandom();
+static void createInitialRow(char* restrict row, const int m,
+                             const double prob,
+                             const unsigned long long seed, const int i);
+static inline unsigned long long splitMix(unsigned long long x);
 
 
 
 /*
  * Function allocateMatrix
  * -----------------------
- *  Allocate memory for a matrix
+ *  Allocate memory for a matrix with the current allocation strategy (see
+ *  alloc.h)
  *
  *  nRows: number of rows of the matrix
  *  nCols: number of columns of the matrix
@@ -22,12 +27,7 @@ static inline double cRandom();
  *  returns: a pointer to the first element of the matrix
  */
 char** allocateMatrix(const int nRows, const int nCols) {
-  char** mat = (char**) malloc(nRows * sizeof(char*));
-  int i;
-  for (i = 0; i < nRows; i++) {
-    mat[i] = (char*) malloc(nCols * sizeof(char));
-  }
-  return mat;
+  return (char**) gridAlloc(nRows, nCols * sizeof(char));
 }
 
 
@@ -42,11 +42,79 @@ char** allocateMatrix(const int nRows, const int nCols) {
  *  nCols: number of columns of the matrix
  */
 void freeMatrix(char** restrict mat, const int nRows, const int nCols) {
+  gridFree((void**) mat);
+}
+
+
+
+/*
+ * Function distributeRows
+ * -----------------------
+ *  Distribute the rows 1 to n-2 evenly among the threads (the first and the
+ *  last row go to the first and the last thread)
+ *
+ *  n: number of rows of the matrix
+ *  nThreads: number of threads
+ *  threadData: pointer to the first element of the array containing thread data
+ */
+void distributeRows(const int n, const int nThreads,
+                    tdata_t* restrict threadData) {
+  const int elePerThread = (n-2)/nThreads;
+  const int remainder = (n-2)%nThreads;
   int i;
-  for (i = 0; i < nRows; i++) {
-    free(mat[i]);
+  for (i = 0; i < remainder; i++) {
+    threadData[i].i0 = i*(elePerThread+1)+1;
+    threadData[i].i1 = (i+1)*(elePerThread+1)+1;
+  }
+  for (i = remainder; i < nThreads; i++) {
+    threadData[i].i0 = remainder + i*elePerThread + 1;
+    threadData[i].i1 = remainder + (i+1)*elePerThread + 1;
+  }
+}
+
+
+
+/*
+ * Function distributeBlocks
+ * -------------------------
+ *  Split the matrix in a px x py grid of blocks, one per thread. If px and py
+ *  are not given, the grid that reads the fewest bytes from the neighboring
+ *  blocks is chosen among the factorizations of nThreads (row bands on ties)
+ *
+ *  n: number of rows of the matrix
+ *  m: number of columns of the matrix
+ *  nThreads: number of threads
+ *  px: blocks along the rows (0 to choose them, set on return)
+ *  py: blocks along the columns (0 to choose them, set on return)
+ *  threadData: pointer to the first element of the array containing thread data
+ */
+void distributeBlocks(const int n, const int m, const int nThreads,
+                      int* restrict px, int* restrict py,
+                      tdata_t* restrict threadData) {
+  int t;
+  if (*px <= 0 || *py <= 0) {
+    double best = 0;
+    *px = 0;
+    for (t = nThreads; t >= 1; t--) {
+      if (nThreads % t == 0) {
+        // Bytes read from the neighbors: two rows of the block, and two
+        // columns that cost a whole cache line per row
+        const double halo = 2.0 * m / (nThreads / t) + 2.0 * 64 * n / t;
+        if (*px == 0 || halo < best) {
+          best = halo;
+          *px = t;
+          *py = nThreads / t;
+        }
+      }
+    }
+  }
+  for (t = 0; t < nThreads; t++) {
+    const int bi = t / *py, bj = t % *py;
+    threadData[t].r0 = (int) ((long long) n * bi / *px);
+    threadData[t].r1 = (int) ((long long) n * (bi+1) / *px);
+    threadData[t].c0 = (int) ((long long) m * bj / *py);
+    threadData[t].c1 = (int) ((long long) m * (bj+1) / *py);
   }
-  free(mat);
 }
 
 
@@ -60,44 +128,74 @@ void freeMatrix(char** restrict mat, const int nRows, const int nCols) {
  *  n: number of rows of the matrix
  *  m: number of columns of the matrix
  *  prob: probability of a cell being alive
+ *  seed: key of the draws
  *  nThreads: number of threads
  *  threadData: pointer to the first element of the array containing thread data
+ *
+ *  Every thread draws its own rows (so their pages are first touched by the
+ *  thread that computes them), and the draws depend only on the seed and
+ *  the cell, so the board is the same for any number of threads and in
+ *  every variant
  */
 void createInitialState(char** restrict mat, const int n, const int m,
-                        const double prob, const int nThreads,
-                        tdata_t* restrict threadData) {
-  int i, j;
+                        const double prob, const unsigned long long seed,
+                        const int nThreads, tdata_t* restrict threadData) {
+  int i;
   int tid = omp_get_thread_num();
 
   if (tid == 0) {
-    for (j = 0; j < m; j++) {
-      mat[0][j] = cRandom() <= prob ? 1 : 0;
-    }
+    createInitialRow(mat[0], m, prob, seed, 0);
   }
   if (tid == nThreads - 1) {  // Cannot use else if in case there is just 1 thread!
-    for (j = 0; j < m; j++) {
-      mat[n-1][j] = cRandom() <= prob ? 1 : 0;
-    }
+    createInitialRow(mat[n-1], m, prob, seed, n-1);
   }
   for (i = threadData[tid].i0; i < threadData[tid].i1; i++) {
-    for (j = 0; j < m; j++) {
-      mat[i][j] = cRandom() <= prob ? 1 : 0;
-    }
+    createInitialRow(mat[i], m, prob, seed, i);
   }
 }
 
 
 
 /*
- * Function cRandom
- * ----------------
- *  Generate a uniform random number in range [0, 1]
+ * Function createInitialRow
+ * -------------------------
+ *  Draw one row of the initial state from a counter-based generator: the row
+ *  gets a key from the seed and its index, and cell j is alive when the top
+ *  53 bits of the mix of the key and j fall below prob
+ *
+ *  row: pointer to the first element of the row
+ *  m: number of columns of the row
+ *  prob: probability of a cell being alive
+ *  seed: key of the draws
+ *  i: index of the row
+ */
+static void createInitialRow(char* restrict row, const int m,
+                             const double prob,
+                             const unsigned long long seed, const int i) {
+  const unsigned long long key = splitMix(splitMix(seed) ^ (unsigned) i);
+  const unsigned long long threshold = (unsigned long long) (prob * 0x1p53);
+  int j;
+  for (j = 0; j < m; j++) {
+    row[j] = splitMix(key + (unsigned) j) >> 11 < threshold;
+  }
+}
+
+
+
+/*
+ * Function splitMix
+ * -----------------
+ *  Finalizer of the SplitMix64 generator
+ *
+ *  x: value to mix
  *
- *  returns: the generated number
+ *  returns: the mixed value
  */
-static inline double cRandom() {
-  // https://stackoverflow.com/questions/6218399/how-to-generate-a-random-number-between-0-and-1
-  return (double) rand() / (double) RAND_MAX;
+static inline unsigned long long splitMix(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
 }
 
 
@@ -6,9 +6,14 @@
 void printMatrix(char** restrict mat, const int nRows, const int nCols);
 char** allocateMatrix(const int nRows, const int nCols);
 void freeMatrix(char** restrict mat, const int nRows, const int nCols);
+void distributeRows(const int n, const int nThreads,
+                    tdata_t* restrict threadData);
+void distributeBlocks(const int n, const int m, const int nThreads,
+                      int* restrict px, int* restrict py,
+                      tdata_t* restrict threadData);
 void createInitialState(char** restrict mat, const int n, const int m,
-                        const double prob, const int nThreads,
-                        tdata_t* restrict threadData);
+                        const double prob, const unsigned long long seed,
+                        const int nThreads, tdata_t* restrict threadData);
 double get_wall_seconds();
 
 #endif
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "live.h"
+#include "utils.h"
+
+
+// Forward declaration of static methods
+static int compareDoubles(const void* a, const void* b);
+
+
+
+int main(int argc, char const *argv[]) {
+
+  // Check that arguments are provided
+  if (argc < 4 || argc > 5) {
+    printf("Usage: %s name samples periodMs [print]\n", argv[0]);
+    printf("  sample the frames published by gol -live name, one every periodMs\n"
+           "  milliseconds, and report the read latency; print the last frame\n"
+           "  if requested\n");
+    return -1;
+  }
+
+  // Parse arguments
+  const int samples = atoi(argv[2]);
+  const double period = atof(argv[3]);
+  const int print = argc == 5;
+  live_t lv;
+  if (samples <= 0 || period < 0) {
+    printf("Usage:\n  samples must be a positive integer\n  periodMs must be non-negative\n");
+    return -1;
+  }
+  if (liveAttach(&lv, argv[1]) != 0) {
+    printf("No live view named %s\n", argv[1]);
+    return -1;
+  }
+
+  // Initialize data structures
+  const int n = lv.head->n, m = lv.head->m, words = lv.head->words;
+  unsigned long long* frame = (unsigned long long*)
+    malloc((size_t) n * words * sizeof(unsigned long long));
+  double* latency = (double*) malloc(samples * sizeof(double));
+  double* age = (double*) malloc(samples * sizeof(double));
+  long long gen = -1, first = -1, retries = 0;
+  double stamp, tFirst = 0, tLast = 0;
+  int s, read = 0;
+  const struct timespec pause = {(time_t) (period / 1000),
+                                 (long) (period * 1e6) % 1000000000L};
+
+  // Sample frames
+  for (s = 0; s < samples; s++) {
+    const double t = get_wall_seconds();
+    const int r = liveRead(&lv, frame, &gen, &stamp);
+    const double done = get_wall_seconds();
+    if (r >= 0) {
+      latency[read] = done - t;
+      age[read] = done - stamp;
+      retries += r;
+      if (first < 0) {
+        first = gen;
+        tFirst = done;
+      }
+      tLast = done;
+      read++;
+    }
+    if (period > 0 && s+1 < samples) {
+      nanosleep(&pause, NULL);
+    }
+  }
+  if (read == 0) {
+    printf("No frame was published\n");
+    return -1;
+  }
+
+  // Report the sampled frames
+  long long population = 0;
+  for (s = 0; s < n * words; s++) {
+    population += __builtin_popcountll(frame[s]);
+  }
+  qsort(latency, read, sizeof(double), compareDoubles);
+  qsort(age, read, sizeof(double), compareDoubles);
+  printf("Board %dx%d, frame every %d generations, %.1f kB per frame\n", n, m,
+         lv.head->interval, n * words * 8 / 1024.0);
+  printf("%d frames read, generations %lld to %lld (%.1f generations/s), "
+         "%lld copies discarded\n", read, first, gen,
+         tLast > tFirst ? (gen - first) / (tLast - tFirst) : 0.0, retries);
+  printf("Read latency: min %.1f us, median %.1f us, max %.1f us\n",
+         latency[0] * 1e6, latency[read/2] * 1e6, latency[read-1] * 1e6);
+  printf("Frame age: min %.1f us, median %.1f us, max %.1f us\n",
+         age[0] * 1e6, age[read/2] * 1e6, age[read-1] * 1e6);
+  printf("Last frame: generation %lld, population %lld\n", gen, population);
+
+  // Print the last frame
+  if (print) {
+    int i, j;
+    for (i = 0; i < n; i++) {
+      printf("[ ");
+      for (j = 0; j < m; j++) {
+        printf("%d ", (int) ((frame[(size_t) i * words + j/64] >> (j%64)) & 1));
+      }
+      printf("]\n");
+    }
+  }
+
+  // Free data structures
+  free(frame);
+  free(latency);
+  free(age);
+  liveClose(&lv);
+
+  return 0;
+}
+
+
+
+/*
+ * Function compareDoubles
+ * -----------------------
+ *  Order two doubles for qsort
+ *
+ *  returns: negative, zero or positive if a is lower, equal or greater
+ */
+static int compareDoubles(const void* a, const void* b) {
+  const double x = *(const double*) a, y = *(const double*) b;
+  return (x > y) - (x < y);
+}
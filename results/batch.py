@@ -0,0 +1,260 @@
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+from track import read_results
+
+
+# Board and steps of the stored sweeps (see track.py)
+sweep_steps = 100
+sweep_grid = 7000
+# Backends that take a thread count after the seed
+threaded = ('parallel', 'parallel_mem')
+repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+class Model:
+    """Cell updates per second of every backend, from the stored results:
+    by thread count for the threaded backends (measured on the sweep board
+    and assumed to hold for other sizes), by board size for the serial
+    ones."""
+
+    def __init__(self, folder):
+        self.rates = {}
+        for backend in ('base', 'opt') + threaded:
+            path = os.path.join(folder, backend + '.txt')
+            if not os.path.exists(path):
+                continue
+            _, rows = read_results(path)
+            rates = {}
+            for label, times in rows.items():
+                med = sorted(times)[len(times) // 2]
+                if backend in threaded:
+                    rates[int(label)] = sweep_grid**2 * sweep_steps / med
+                else:
+                    rates[int(label)**2] = int(label)**2 * sweep_steps / med
+            self.rates[backend] = rates
+
+    def rate(self, backend, cells, threads):
+        rates = self.rates[backend]
+        if backend in threaded:
+            return rates[min(threads, max(rates))]
+        # Serial backends: the sweep size closest in cells
+        return rates[min(rates, key=lambda c: abs(c - cells))]
+
+    def max_threads(self, backend):
+        return max(self.rates[backend]) if backend in threaded else 1
+
+    def best_rate(self, backend, cells):
+        """Rate of the fastest thread count."""
+        return max(self.rate(backend, cells, t)
+                   for t in range(1, self.max_threads(backend) + 1))
+
+
+class Job:
+    def __init__(self, index, fields):
+        self.index = index
+        self.backend = fields[0]
+        self.n, self.m = int(fields[1]), int(fields[2])
+        self.prob, self.seed = fields[3], fields[5]
+        self.nsteps = int(fields[4])
+        self.options = fields[6:]
+        self.cells = self.n * self.m
+        self.threads = 1
+        self.cores = []
+        self.predicted = self.start = self.end = 0.0
+
+    def updates(self):
+        return self.cells * self.nsteps
+
+    def command(self):
+        args = [str(self.n), str(self.m), self.prob, str(self.nsteps),
+                self.seed]
+        if self.backend in threaded:
+            args.append(str(self.threads))
+        return ['./gol'] + args + ['0'] + self.options
+
+
+def read_jobs(path, model):
+    """Read a job list: one 'backend n m prob nSteps seed [options]' line per
+    simulation, '#' starts a comment."""
+    jobs = []
+    with open(sys.stdin.fileno() if path == '-' else path) as f:
+        for line in f:
+            fields = line.split('#', 1)[0].split()
+            if not fields:
+                continue
+            if fields[0] not in model.rates or len(fields) < 6:
+                raise ValueError('bad job line: ' + line.strip())
+            jobs.append(Job(len(jobs), fields))
+    return jobs
+
+
+def choose_threads(model, job, free, queued, tolerance):
+    """Threads for a job about to start: the free cores are shared evenly
+    among the queued jobs, and within its share a job takes the fewest
+    threads whose rate is within the tolerance of the best one, leaving the
+    cores that would barely help to the next jobs."""
+    share = max(1, free // max(1, queued))
+    share = min(share, model.max_threads(job.backend))
+    rates = [model.rate(job.backend, job.cells, t) for t in range(1, share+1)]
+    best = max(rates)
+    return next(t for t, r in enumerate(rates, 1)
+                if r >= (1 - tolerance) * best)
+
+
+def schedule(jobs, model, cores, tolerance, launch, wait):
+    """List scheduling, longest predicted job first, on disjoint core sets.
+    launch(job) starts a job on job.cores, wait() returns a finished job."""
+    queue = sorted(jobs, key=lambda j: -j.updates()
+                   / model.best_rate(j.backend, j.cells))
+    free = list(cores)
+    running = 0
+    while queue or running:
+        while queue and free:
+            job = queue.pop(0)
+            job.threads = choose_threads(model, job, len(free), len(queue) + 1,
+                                         tolerance)
+            job.cores, free = free[:job.threads], free[job.threads:]
+            job.predicted = job.updates() / model.rate(job.backend, job.cells,
+                                                       job.threads)
+            launch(job)
+            running += 1
+        job = wait()
+        running -= 1
+        free = sorted(free + job.cores)
+
+
+def run(jobs, model, cores, tolerance):
+    """Run the jobs, each pinned to its cores with as many OpenMP threads."""
+    procs = {}
+
+    def launch(job):
+        env = dict(os.environ, OMP_NUM_THREADS=str(job.threads),
+                   OMP_PROC_BIND='close')
+        job.start = time.time()
+        proc = subprocess.Popen(
+            job.command(), cwd=os.path.join(repo, job.backend), env=env,
+            stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+            preexec_fn=lambda: os.sched_setaffinity(0, job.cores))
+        procs[proc.pid] = (job, proc)
+
+    def wait():
+        pid, status = os.wait()
+        job, proc = procs.pop(pid)
+        job.end = time.time()
+        proc.returncode = os.waitstatus_to_exitcode(status)
+        proc.stdout.read()
+        if proc.returncode != 0:
+            print('Job {} failed: {}'.format(job.index,
+                                             ' '.join(job.command())),
+                  file=sys.stderr)
+        return job
+
+    t0 = time.time()
+    schedule(jobs, model, cores, tolerance, launch, wait)
+    for job in jobs:
+        job.start -= t0
+        job.end -= t0
+
+
+def simulate(jobs, model, cores, tolerance):
+    """Schedule the jobs with their predicted durations, without running."""
+    events = []
+    clock = [0.0]
+
+    def launch(job):
+        job.start = clock[0]
+        job.end = job.start + job.predicted
+        events.append(job)
+
+    def wait():
+        job = min(events, key=lambda j: j.end)
+        events.remove(job)
+        clock[0] = job.end
+        return job
+
+    schedule(jobs, model, cores, tolerance, launch, wait)
+
+
+def core_list(cores):
+    """Compact form of a sorted core list, e.g. 0-3,8."""
+    spans = []
+    for c in cores:
+        if spans and c == spans[-1][1] + 1:
+            spans[-1][1] = c
+        else:
+            spans.append([c, c])
+    return ','.join(str(a) if a == b else '{}-{}'.format(a, b)
+                    for a, b in spans)
+
+
+def report(jobs, model):
+    print('{:>4} {:>12} {:>12} {:>6} {:>7} {:>10} {:>9} {:>9} {:>9}'.format(
+        'job', 'backend', 'board', 'steps', 'threads', 'cores', 'predicted',
+        'seconds', 'Gcell/s'))
+    for job in sorted(jobs, key=lambda j: j.index):
+        seconds = job.end - job.start
+        print('{:>4} {:>12} {:>12} {:>6} {:>7} {:>10} {:>9.2f} {:>9.2f} '
+              '{:>9.3f}'.format(job.index, job.backend,
+                                '{}x{}'.format(job.n, job.m), job.nsteps,
+                                job.threads, core_list(job.cores),
+                                job.predicted, seconds,
+                                job.updates() / seconds * 1e-9))
+    makespan = max(j.end for j in jobs)
+    updates = sum(j.updates() for j in jobs)
+    # One job after another, each with its fastest thread count
+    alone = sum(j.updates() / model.best_rate(j.backend, j.cells)
+                for j in jobs)
+    print('{} jobs in {:.2f} s: {:.3f} Gcell-updates/s aggregate '
+          '(one at a time: {:.2f} s predicted, {:.3f} Gcell-updates/s)'.format(
+              len(jobs), makespan, updates / makespan * 1e-9, alone,
+              updates / alone * 1e-9))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run a list of simulations side by side on disjoint core '
+                    'sets, with the threads of every job chosen from the '
+                    'throughput model of the stored results.')
+    parser.add_argument('jobs', help="job list, one 'backend n m prob nSteps "
+                                     "seed [options]' per line (- for stdin)")
+    parser.add_argument('--cores', type=int,
+                        help='cores to use (default: all the usable ones)')
+    parser.add_argument('--tolerance', type=float, default=0.05,
+                        help='rate a job gives up to use fewer threads '
+                             '(default 0.05)')
+    parser.add_argument('--model', default=os.path.dirname(
+                            os.path.abspath(__file__)),
+                        help='folder of the result files of the model')
+    parser.add_argument('--dry-run', action='store_true',
+                        help='print the predicted schedule without running')
+    args = parser.parse_args()
+
+    model = Model(args.model)
+    try:
+        jobs = read_jobs(args.jobs, model)
+    except ValueError as e:
+        print(e, file=sys.stderr)
+        return 1
+    if not jobs:
+        return 0
+    cores = sorted(os.sched_getaffinity(0))[:args.cores]
+    if args.dry_run and args.cores:
+        # Plans can be made for a bigger box than this one
+        cores = list(range(args.cores))
+    if args.dry_run:
+        simulate(jobs, model, cores, args.tolerance)
+    else:
+        for backend in set(j.backend for j in jobs):
+            subprocess.run(['make', '-s'], cwd=os.path.join(repo, backend),
+                           check=True)
+        run(jobs, model, cores, args.tolerance)
+    report(jobs, model)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
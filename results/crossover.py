@@ -0,0 +1,80 @@
+import argparse
+import math
+import os
+import subprocess
+import sys
+
+
+repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def rate(n, m, prob, nsteps, seed, options):
+    """Cell updates per second of an opt run and its line of the incremental
+    engine (None without -incremental)."""
+    args = [str(n), str(m), prob, str(nsteps), str(seed), '0', '-footprint']
+    proc = subprocess.run(['./gol'] + args + options,
+                          cwd=os.path.join(repo, 'opt'),
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                          universal_newlines=True, check=True)
+    updates, report = None, None
+    for line in proc.stderr.splitlines():
+        if line.startswith('Footprint:'):
+            updates = float(line.split(' cell updates')[0].split()[-1])
+        elif line.startswith('Incremental:'):
+            report = line
+    return updates, report
+
+
+def activity(report):
+    """Percentage of the cells flipped per generation after the first."""
+    return float(report.split('% of the cells')[0].split()[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure the dense kernel of opt against the incremental '
+                    'engine on soups of decreasing density, and estimate the '
+                    'activity (cells flipped per generation) below which the '
+                    'incremental engine is faster.')
+    parser.add_argument('-n', type=int, default=2000,
+                        help='rows (default 2000)')
+    parser.add_argument('-m', type=int, default=2000,
+                        help='columns (default 2000)')
+    parser.add_argument('--steps', type=int, default=500,
+                        help='generations (default 500)')
+    parser.add_argument('--seed', type=int, default=1, help='seed (default 1)')
+    parser.add_argument('--probs',
+                        default='0.01,0.02,0.03,0.05,0.07,0.1,0.2,0.3',
+                        help='densities of the soups')
+    args = parser.parse_args()
+
+    subprocess.run(['make', '-s'], cwd=os.path.join(repo, 'opt'), check=True)
+    print('{:>6} {:>10} {:>12} {:>12} {:>8}'.format(
+        'prob', 'activity%', 'dense c/s', 'increm c/s', 'speedup'))
+    points = []
+    for prob in args.probs.split(','):
+        dense, _ = rate(args.n, args.m, prob, args.steps, args.seed, [])
+        incremental, report = rate(args.n, args.m, prob, args.steps,
+                                   args.seed, ['-incremental'])
+        speedup = incremental / dense
+        points.append((activity(report), speedup))
+        print('{:>6} {:>10.4f} {:>12.3e} {:>12.3e} {:>8.2f}'.format(
+            prob, points[-1][0], dense, incremental, speedup))
+
+    # Speedup against activity is close to a power law, so the crossover is
+    # interpolated between the two measurements around 1 in log-log space
+    points.sort()
+    for (a0, s0), (a1, s1) in zip(points, points[1:]):
+        if s0 >= 1 > s1 and a0 > 0:
+            t = math.log(s0) / (math.log(s0) - math.log(s1))
+            crossover = math.exp(math.log(a0) + t * (math.log(a1)
+                                                     - math.log(a0)))
+            print('Incremental engine faster below {:.3f}% of the cells '
+                  'flipped per generation'.format(crossover))
+            return 0
+    print('No crossover within the measured densities')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
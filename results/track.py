@@ -0,0 +1,257 @@
+import argparse
+import datetime
+import math
+import os
+import platform
+import random
+import subprocess
+import sys
+
+
+# Sweeps of the test.py scripts: rows of every result file
+repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sweeps = {
+    'base': ('grid', [str(g) for g in range(1000, 8000, 1000)]),
+    'opt': ('grid', [str(g) for g in range(1000, 8000, 1000)]),
+    'parallel': ('threads', [str(t) for t in range(1, 26)]),
+    'parallel_mem': ('threads', [str(t) for t in range(1, 26)]),
+}
+prob = '0.5'
+nsteps = '100'
+grid = '7000'  # Board of the thread sweeps
+
+
+def read_results(path):
+    """Read a result file: '# key: value' metadata lines, then one row of
+    seconds per grid size or thread count."""
+    meta, rows = {}, []
+    with open(path) as f:
+        for line in f:
+            if line.startswith('#'):
+                key, _, value = line[1:].partition(':')
+                meta[key.strip()] = value.strip()
+            elif line.strip():
+                rows.append([float(t) for t in line.split()])
+    # Files without metadata are the stored baselines, named after their
+    # variant
+    variant = meta.setdefault('variant',
+                              os.path.splitext(os.path.basename(path))[0])
+    if 'rows' in meta:
+        labels = meta['rows'].split()
+    else:
+        labels = sweeps[variant][1][:len(rows)]
+    return meta, dict(zip(labels, rows))
+
+
+def environment(variant):
+    """Describe where and how a result set is produced."""
+    def run(cmd, cwd=repo):
+        try:
+            return subprocess.run(cmd, cwd=cwd, capture_output=True,
+                                  text=True).stdout.strip()
+        except OSError:
+            return 'unknown'
+    cpu = 'unknown'
+    if os.path.exists('/proc/cpuinfo'):
+        with open('/proc/cpuinfo') as f:
+            names = [l.split(':', 1)[1].strip() for l in f
+                     if l.startswith('model name')]
+        if names:
+            cpu = '{} x {}'.format(len(names), names[0])
+    flags = [l.split('=', 1)[1].strip()
+             for l in open(os.path.join(repo, variant, 'Makefile'))
+             if l.startswith('CFLAGS')]
+    dirty = run(['git', 'status', '--porcelain', '--untracked-files=no',
+                 '--', variant])
+    return {
+        'variant': variant,
+        'date': datetime.datetime.now().isoformat(timespec='seconds'),
+        'host': platform.node(),
+        'cpu': cpu,
+        'kernel': platform.release(),
+        'compiler': run(['gcc', '--version']).split('\n')[0],
+        'cflags': flags[0] if flags else 'unknown',
+        'commit': run(['git', 'rev-parse', '--short', 'HEAD'])
+                  + (' (modified)' if dirty else ''),
+    }
+
+
+def benchmark(variant, labels, reps, out):
+    """Build a variant, run its sweep and write the times with metadata."""
+    kind = sweeps[variant][0]
+    cwd = os.path.join(repo, variant)
+    subprocess.run(['make', '-s'], cwd=cwd, check=True)
+    meta = environment(variant)
+    meta['params'] = 'prob {} nsteps {}'.format(prob, nsteps) \
+        + (' grid {}'.format(grid) if kind == 'threads' else '')
+    meta['rows'] = ' '.join(labels)
+    rows = {}
+    for index_i, label in enumerate(labels):
+        rows[label] = []
+        for j in range(reps):
+            seed = str(j+1)
+            if kind == 'grid':
+                args = [label, label, prob, nsteps, seed]
+            else:
+                args = [grid, grid, prob, nsteps, seed, label]
+            proc = subprocess.run(['./gol'] + args + ['0'], cwd=cwd,
+                                  capture_output=True, text=True)
+            rows[label].append(float(proc.stdout.split()[-1]))
+        print('{}% complete!'.format(((index_i+1)/len(labels))*100),
+              file=sys.stderr)
+    with open(out, 'w') as f:
+        f.writelines(['# {}: {}\n'.format(k, v) for k, v in meta.items()])
+        f.writelines([' '.join(str(t) for t in rows[label]) + '\n'
+                      for label in labels])
+    return meta, rows
+
+
+def median(xs):
+    s = sorted(xs)
+    k = len(s) // 2
+    return s[k] if len(s) % 2 else (s[k-1] + s[k]) / 2
+
+
+def bootstrap_ci(base, new, level=0.95, n_boot=2000):
+    """Percentile bootstrap interval of the ratio of medians (new / base)."""
+    rng = random.Random(12345)
+    ratios = sorted(median(rng.choices(new, k=len(new)))
+                    / median(rng.choices(base, k=len(base)))
+                    for _ in range(n_boot))
+    lo = ratios[int((1 - level) / 2 * n_boot)]
+    hi = ratios[int((1 + level) / 2 * n_boot) - 1]
+    return lo, hi
+
+
+def mann_whitney_greater(base, new):
+    """One-sided Mann-Whitney U test of new being slower than base. Exact
+    for small samples without ties, normal approximation otherwise.
+
+    returns: the p-value
+    """
+    n1, n2 = len(new), len(base)
+    pooled = sorted([(t, 0) for t in new] + [(t, 1) for t in base])
+    # Average ranks of tied times
+    ranks, i, ties = [0.0] * len(pooled), 0, []
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j+1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j+1):
+            ranks[k] = (i + j) / 2 + 1
+        if j > i:
+            ties.append(j - i + 1)
+        i = j + 1
+    r1 = sum(r for r, (_, g) in zip(ranks, pooled) if g == 0)
+    u = r1 - n1 * (n1 + 1) / 2  # Pairs where new is slower
+    if not ties and n1 * n2 <= 400:
+        # counts[u] = number of orderings giving each U
+        counts = exact_u(n1, n2)
+        return sum(counts[int(u):]) / sum(counts)
+    mean = n1 * n2 / 2
+    n = n1 + n2
+    var = n1 * n2 / 12 * ((n + 1) - sum(t**3 - t for t in ties) / (n * (n-1)))
+    if var == 0:
+        return 1.0
+    z = (u - mean - 0.5) / var ** 0.5  # Continuity correction
+    return 0.5 * math.erfc(z / 2 ** 0.5)
+
+
+def exact_u(n1, n2):
+    """Distribution of U for samples of sizes n1 and n2 (counts per U)."""
+    # table[a][b] holds the counts for sizes a and b
+    table = [[None] * (n2+1) for _ in range(n1+1)]
+    for a in range(n1+1):
+        for b in range(n2+1):
+            if a == 0 or b == 0:
+                table[a][b] = [1]
+                continue
+            # The largest value belongs to the first sample (adds b to U) or
+            # to the second one
+            x, y = table[a-1][b], table[a][b-1]
+            c = [0] * (a*b + 1)
+            for v, k in enumerate(x):
+                c[v + b] += k
+            for v, k in enumerate(y):
+                c[v] += k
+            table[a][b] = c
+    return table[n1][n2]
+
+
+def compare(base_meta, base_rows, new_meta, new_rows, threshold, alpha):
+    """Print the comparison table and return the number of regressions."""
+    for key in ('params', 'host', 'cpu', 'compiler', 'cflags', 'commit'):
+        b, n = base_meta.get(key, 'unknown'), new_meta.get(key, 'unknown')
+        print('{:9} {} -> {}'.format(key, b, n) if b != n
+              else '{:9} {}'.format(key, b))
+    kind = sweeps[new_meta['variant']][0]
+    print('{:>8} {:>10} {:>10} {:>7} {:>17} {:>8}  verdict'.format(
+        kind, 'base med', 'new med', 'ratio', '95% CI', 'p'))
+    regressions = 0
+    for label, new in new_rows.items():
+        if label not in base_rows:
+            continue
+        base = base_rows[label]
+        ratio = median(new) / median(base)
+        lo, hi = bootstrap_ci(base, new)
+        p = mann_whitney_greater(base, new)
+        if ratio > 1 + threshold and p < alpha:
+            verdict = 'REGRESSION'
+            regressions += 1
+        elif ratio < 1 - threshold and p > 1 - alpha:
+            verdict = 'faster'
+        else:
+            verdict = 'same'
+        print('{:>8} {:>10.4f} {:>10.4f} {:>7.3f} [{:>6.3f}, {:>6.3f}] '
+              '{:>8.4f}  {}'.format(label, median(base), median(new), ratio,
+                                    lo, hi, p, verdict))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run the benchmark sweep of a variant and/or compare it '
+                    'against a stored baseline. Exits with 1 if any row is '
+                    'slower than the baseline beyond the threshold.')
+    sub = parser.add_subparsers(dest='command', required=True)
+    run = sub.add_parser('run', help='run a sweep and save it with metadata')
+    run.add_argument('variant', choices=sorted(sweeps))
+    run.add_argument('--out', help='result file (default: <variant>_new.txt)')
+    run.add_argument('--rows', help='comma separated grid sizes or thread '
+                                    'counts (default: the whole sweep)')
+    run.add_argument('--reps', type=int, default=10)
+    run.add_argument('--baseline', help='result file to compare against')
+    cmp = sub.add_parser('compare', help='compare two result files')
+    cmp.add_argument('baseline')
+    cmp.add_argument('new')
+    for p in (run, cmp):
+        p.add_argument('--threshold', type=float, default=0.05,
+                       help='relative slowdown tolerated (default 0.05)')
+        p.add_argument('--alpha', type=float, default=0.05,
+                       help='significance level (default 0.05)')
+    args = parser.parse_args()
+
+    if args.command == 'run':
+        labels = args.rows.split(',') if args.rows else sweeps[args.variant][1]
+        out = args.out or os.path.join(repo, 'results',
+                                       args.variant + '_new.txt')
+        new_meta, new_rows = benchmark(args.variant, labels, args.reps, out)
+        print('Results written to {}'.format(out))
+        if args.baseline is None:
+            return 0
+        base_meta, base_rows = read_results(args.baseline)
+    else:
+        base_meta, base_rows = read_results(args.baseline)
+        new_meta, new_rows = read_results(args.new)
+
+    regressions = compare(base_meta, base_rows, new_meta, new_rows,
+                          args.threshold, args.alpha)
+    if regressions:
+        print('{} regression(s) beyond {:.0f}%'.format(
+            regressions, args.threshold * 100))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,168 @@
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+
+# Backends that take a thread count after the seed
+threaded = ('parallel', 'parallel_mem')
+repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+# Kernels of every backend checked against the reference, with whether they
+# print the hashes of intermediate generations and run the stochastic rule
+configs = {
+    'base': [([], True, False)],
+    'opt': [([], True, True), (['-generic'], True, True),
+            (['-separable'], True, False), (['-inplace'], True, False),
+            (['-adaptive'], False, False), (['-incremental'], True, False)],
+    'parallel': [([], True, True), (['-separable'], True, False),
+                 (['-inplace'], True, False)],
+    'parallel_mem': [([], True, True), (['-separable'], True, False),
+                     (['-inplace'], True, False),
+                     (['-blocks', 'auto'], True, False)],
+}
+
+
+class Run:
+    """One backend with one kernel and thread count."""
+
+    def __init__(self, backend, options, threads, checkpoints):
+        self.backend = backend
+        self.options = options
+        self.threads = threads
+        self.checkpoints = checkpoints
+        self.seconds = 0.0
+
+    def name(self):
+        label = ' '.join([self.backend] + self.options)
+        if self.backend in threaded:
+            label += ' ({} threads)'.format(self.threads)
+        return label
+
+    def hashes(self, board, nsteps, every):
+        """Hashes printed by the backend, by generation."""
+        n, m, prob, seed, extra = board
+        args = [str(n), str(m), prob, str(nsteps), str(seed)]
+        if self.backend in threaded:
+            args.append(str(self.threads))
+        args += ['0', '-hash', str(every if self.checkpoints else 0)]
+        env = dict(os.environ, OMP_NUM_THREADS=str(self.threads))
+        t = time.time()
+        proc = subprocess.run(['./gol'] + args + self.options + extra,
+                              cwd=os.path.join(repo, self.backend), env=env,
+                              stdout=subprocess.DEVNULL,
+                              stderr=subprocess.PIPE, universal_newlines=True)
+        self.seconds = time.time() - t
+        if proc.returncode != 0:
+            raise RuntimeError('{} failed: {}'.format(self.name(),
+                                                      ' '.join(args)))
+        hashes = {}
+        for line in proc.stderr.splitlines():
+            if line.startswith('Hash: generation '):
+                gen, value = line.split()[2:4]
+                hashes[int(gen)] = value
+        return hashes
+
+
+def first_divergence(reference, hashes):
+    """Last generation both runs agree on and first one they do not (None if
+    they agree on every generation both printed)."""
+    agreed = -1
+    for gen in sorted(set(reference) & set(hashes)):
+        if reference[gen] != hashes[gen]:
+            return agreed, gen
+        agreed = gen
+    return agreed, None
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run every backend on the same board and compare the '
+                    'hashes of its generations with those of a reference '
+                    'backend, reporting the first generation that differs.')
+    parser.add_argument('-n', type=int, default=1000,
+                        help='rows (default 1000)')
+    parser.add_argument('-m', type=int, default=1000,
+                        help='columns (default 1000)')
+    parser.add_argument('--prob', default='0.3',
+                        help='probability of a live cell (default 0.3)')
+    parser.add_argument('--steps', type=int, default=200,
+                        help='generations (default 200)')
+    parser.add_argument('--seed', type=int, default=1, help='seed (default 1)')
+    parser.add_argument('--every', type=int, default=10,
+                        help='generations between compared hashes (default 10)')
+    parser.add_argument('--threads', default='1,2,4',
+                        help='thread counts of the threaded backends '
+                             '(default 1,2,4)')
+    parser.add_argument('--backends', default=','.join(configs),
+                        help='backends to check (default all)')
+    parser.add_argument('--reference', default=None,
+                        help='backend the others are compared with (default '
+                             'base, or opt with --noise)')
+    parser.add_argument('--noise', nargs=2, metavar=('PB', 'PS'),
+                        help='run the stochastic rule instead of Life (only '
+                             'the kernels that have it)')
+    args = parser.parse_args()
+
+    if args.every < 0 or args.seed < 0:
+        print('every and seed cannot be negative', file=sys.stderr)
+        return 1
+    threads = [int(t) for t in args.threads.split(',')]
+    backends = args.backends.split(',')
+    reference = args.reference or ('opt' if args.noise else 'base')
+    extra = ['-noise'] + args.noise if args.noise else []
+    board = (args.n, args.m, args.prob, args.seed, extra)
+    for backend in set(backends + [reference]):
+        if backend not in configs:
+            print('unknown backend ' + backend, file=sys.stderr)
+            return 1
+        subprocess.run(['make', '-s'], cwd=os.path.join(repo, backend),
+                       check=True)
+
+    runs = []
+    for backend in backends:
+        for options, checkpoints, noise in configs[backend]:
+            if args.noise and not noise:
+                continue
+            for t in threads if backend in threaded else [1]:
+                runs.append(Run(backend, options, t, checkpoints))
+    ref = Run(reference, [], max(threads) if reference in threaded else 1,
+              True)
+    runs = [r for r in runs if (r.backend, r.options, r.threads)
+            != (ref.backend, ref.options, ref.threads)]
+    if args.noise and not any(noise for _, _, noise in configs[reference]):
+        print(reference + ' has no stochastic rule', file=sys.stderr)
+        return 1
+
+    expected = ref.hashes(board, args.steps, args.every)
+    print('Reference {}: {}x{}, prob {}, seed {}, {} generations, {} hashes '
+          'in {:.2f} s'.format(ref.name(), args.n, args.m, args.prob,
+                               args.seed, args.steps, len(expected),
+                               ref.seconds))
+    failed = 0
+    for run in runs:
+        hashes = run.hashes(board, args.steps, args.every)
+        agreed, diverged = first_divergence(expected, hashes)
+        if diverged is None:
+            print('{:<40} agrees on {} hashes in {:.2f} s'.format(
+                run.name(), len(set(expected) & set(hashes)), run.seconds))
+            continue
+        failed += 1
+        # Narrow the divergence down to a generation by hashing every one
+        # between the last checkpoint that agreed and the first that did not
+        if diverged - agreed > 1 and run.checkpoints:
+            fine = ref.hashes(board, diverged, 1)
+            agreed, diverged = first_divergence(
+                fine, run.hashes(board, diverged, 1))
+        if diverged - agreed > 1:
+            print('{:<40} DIVERGES between generations {} and {}'.format(
+                run.name(), agreed, diverged))
+        else:
+            print('{:<40} DIVERGES at generation {}'.format(run.name(),
+                                                            diverged))
+    print('{} of {} runs diverge'.format(failed, len(runs)))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())